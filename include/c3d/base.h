@@ -4,12 +4,6 @@
 
 #define C3D_DEFAULT_CMDBUF_SIZE 0x40000
 
-enum
-{
-	C3D_UNSIGNED_BYTE = 0,
-	C3D_UNSIGNED_SHORT = 1,
-};
-
 bool C3D_Init(size_t cmdBufSize);
 void C3D_FlushAsync(void);
 void C3D_Fini(void);
@@ -23,6 +17,7 @@ void C3D_SetScissor(GPU_SCISSORMODE mode, u32 left, u32 top, u32 right, u32 bott
 
 void C3D_DrawArrays(GPU_Primitive_t primitive, int first, int size);
 void C3D_DrawElements(GPU_Primitive_t primitive, int count, int type, const void* indices);
+void C3D_DrawElementsRanges(GPU_Primitive_t primitive, int type, const void* indices, const u32* ranges, int numRanges);
 
 // Immediate-mode vertex submission
 void C3D_ImmDrawBegin(GPU_Primitive_t primitive);
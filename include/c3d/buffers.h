@@ -19,3 +19,50 @@ int  BufInfo_Add(C3D_BufInfo* info, const void* data, ptrdiff_t stride, int attr
 
 C3D_BufInfo* C3D_GetBufInfo(void);
 void C3D_SetBufInfo(C3D_BufInfo* info);
+
+// Pool of large linear memory blocks that static vertex and index buffers are carved out of.
+// Allocations are referred to by handle so that BufPool_Compact can move them.
+#define C3D_BUFPOOL_MAX_ALIGN 0x1000
+
+typedef u32 C3D_BufHandle; // 0 is never a valid handle
+
+typedef struct
+{
+	void* data;        // Linear memory
+	u32 size;
+	u32 used;          // End of the last allocation
+	u32 live;          // Bytes held by live allocations
+	u32 count;         // Number of live allocations
+	C3D_BufInfo info;  // Based at the start of the block, shared by everything allocated from it
+} C3D_BufPoolBlock;
+
+typedef struct
+{
+	u32 offset;        // Offset within the block, or the next free entry
+	u32 size;
+	u16 block;
+	u16 align;         // 0 if the entry is free
+} C3D_BufPoolEntry;
+
+typedef struct
+{
+	C3D_BufPoolBlock* blocks;
+	int numBlocks;
+	u32 blockSize;
+	C3D_BufPoolEntry* entries;
+	u32 numEntries, maxEntries;
+	u32 freeEntry;     // First free entry plus one, 0 if none
+} C3D_BufPool;
+
+void BufPool_Init(C3D_BufPool* pool, u32 blockSize);
+void BufPool_Fini(C3D_BufPool* pool);
+C3D_BufHandle BufPool_Alloc(C3D_BufPool* pool, u32 size, u32 align);
+C3D_BufHandle BufPool_Upload(C3D_BufPool* pool, const void* data, u32 size, u32 align);
+void BufPool_Free(C3D_BufPool* pool, C3D_BufHandle handle);
+void* BufPool_Get(const C3D_BufPool* pool, C3D_BufHandle handle);
+int BufPool_Block(const C3D_BufPool* pool, C3D_BufHandle handle);
+C3D_BufInfo* BufPool_GetBufInfo(C3D_BufPool* pool, C3D_BufHandle handle);
+
+// Moves allocations together and releases emptied blocks, returning the number of bytes released.
+// The GPU must not be using the pool; pointers and block buffer configurations have to be fetched again.
+u32 BufPool_Compact(C3D_BufPool* pool);
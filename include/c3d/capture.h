@@ -0,0 +1,56 @@
+#pragma once
+#include "types.h"
+
+// Frame captures hold the command lists submitted during one frame together with the memory their
+// draws read (vertex and index buffers, textures), keyed by physical address. Reading and writing them
+// is host-compatible so that captures taken on the console can be inspected and replayed offline.
+//
+// Each address holds a single version of its memory: the contents it had when a draw first read it.
+// A buffer that is rewritten between the lists of a frame replays with its earlier contents for the
+// later lists; such ranges are flagged C3D_CAPTURERANGE_REWRITTEN.
+#define C3D_CAPTURE_MAGIC   0x43443343 // "C3DC"
+#define C3D_CAPTURE_VERSION 2          // Version 1 files, without range flags, are still loaded
+
+enum
+{
+	C3D_CAPTURERANGE_REWRITTEN = 1 << 0, // Memory changed after it was captured, later draws saw other data
+};
+
+typedef struct
+{
+	u32* words;
+	u32 numWords;
+} C3D_CaptureList;
+
+typedef struct
+{
+	u32 paddr;
+	u32 size;
+	void* data;
+	u32 flags;
+} C3D_CaptureRange;
+
+typedef struct
+{
+	C3D_CaptureList* lists;
+	u32 numLists;
+	C3D_CaptureRange* ranges; // Sorted by address, never overlapping
+	u32 numRanges;
+} C3D_Capture;
+
+// Returns a pointer to size bytes of memory at a physical address, or NULL if it can't be accessed
+typedef const void* (* C3D_CaptureResolveCb)(u32 paddr, u32 size, void* user);
+
+bool C3D_CaptureAddList(C3D_Capture* cap, const u32* words, u32 numWords);
+// Walks the draws of all lists added so far and copies the memory they read through resolve. Memory
+// captured by an earlier call keeps its contents, so calling this after each list snapshots every
+// range as the first list that read it saw it.
+bool C3D_CaptureAddMemory(C3D_Capture* cap, C3D_CaptureResolveCb resolve, void* user);
+// Flags the ranges whose memory no longer matches the capture, returns how many were flagged
+u32  C3D_CaptureMarkRewritten(C3D_Capture* cap, C3D_CaptureResolveCb resolve, void* user);
+bool C3D_CaptureSave(const C3D_Capture* cap, const char* path);
+bool C3D_CaptureLoad(C3D_Capture* cap, const char* path);
+void C3D_CaptureFree(C3D_Capture* cap);
+
+// Looks up captured memory, user being the C3D_Capture. Usable as a C3D_CaptureResolveCb for replay.
+const void* C3D_CaptureResolve(u32 paddr, u32 size, void* user);
@@ -0,0 +1,38 @@
+#pragma once
+#include "types.h"
+
+// PICA200 command stream decoding, for inspecting what the library emits. Host-compatible: the
+// tools/cmddump utility uses it to disassemble command buffers dumped from the console.
+#define C3D_CMD_NUM_REGS 0x400
+
+enum
+{
+	C3D_CMDWRITE_REDUNDANT   = 1 << 0, // Every written byte already held the same value
+	C3D_CMDWRITE_OVERWRITTEN = 1 << 1, // Fully replaced by a later write before anything used it
+};
+
+typedef struct
+{
+	u32 offset; // Word offset of the command in the buffer
+	u16 reg;
+	u8 mask;    // Byte enable mask, 0xF for plain writes
+	u8 flags;   // Set by C3D_CmdAnalyze
+	u32 value;
+} C3D_CmdWrite;
+
+typedef struct
+{
+	u32 writes;
+	u32 stateWrites; // Writes other than data ports and triggers, which are the only ones analyzed
+	u32 redundant;
+	u32 overwritten;
+	u32 draws;
+	u32 regWrites[C3D_CMD_NUM_REGS];
+} C3D_CmdStats;
+
+// Expands a command buffer into single register writes (incremental and repeated writes produce one
+// entry per parameter). Returns the total number of writes, of which at most maxWrites are stored.
+// Decoding stops at the first truncated command.
+u32  C3D_CmdDecode(const u32* cmdBuf, u32 numWords, C3D_CmdWrite* out, u32 maxWrites);
+bool C3D_CmdAnalyze(C3D_CmdWrite* writes, u32 count, C3D_CmdStats* stats);
+const char* C3D_CmdRegName(u16 reg); // NULL for registers without a name
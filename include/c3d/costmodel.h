@@ -0,0 +1,43 @@
+#pragma once
+#include "cmdstream.h"
+
+// Rough GPU cost estimate of a decoded command stream, for catching regressions without hardware.
+// Nothing is rasterized: fragments are estimated per primitive and capped by the framebuffer area.
+// The per-unit constants should be calibrated against C3D_TimingGet measurements on the console.
+typedef struct
+{
+	float clockHz;
+
+	// Vertex processing, per vertex
+	float vertexBase;
+	float vertexPerAttribByte;  // Attribute fetch
+	float vertexPerShaderWord;  // Per word of uploaded vertex shader code
+	float indexMissRatio;       // Fraction of indices missing the post-vertex cache
+
+	// Primitive setup, per triangle
+	float setupPerPrim;
+	float fragmentsPerPrim;
+	float maxOverdraw;          // Cap on fragments per draw, in framebuffers
+
+	// Per fragment
+	float fragBase;
+	float fragPerTexEnv;        // Per non-passthrough combiner stage
+	float fragPerTexel;         // Per texture unit sample, scaled by bytes per texel
+	float fragPerLight;
+	float fragPerLightLut;
+	float fragProcTex;
+	float fragFog;
+	float fragPerFbByte;        // Framebuffer reads and writes
+} C3D_CostParams;
+
+typedef struct
+{
+	u32 draws, vertices, primitives;
+	float fragments;
+	float vertex, setup, fill, texture, lighting; // Cycles
+	float total;
+	float ms;
+} C3D_CostEstimate;
+
+void C3D_CostParamsDefault(C3D_CostParams* params);
+void C3D_CostEstimateStream(const C3D_CmdWrite* writes, u32 count, const C3D_CostParams* params, C3D_CostEstimate* out);
@@ -15,6 +15,19 @@ static inline float FogLut_CalcZ(float depth, float near, float far)
 void FogLut_FromArray(C3D_FogLut* lut, const float data[256]);
 void FogLut_Exp(C3D_FogLut* lut, float density, float gradient, float near, float far);
 
+// Interpolates between keyframe LUTs, e.g. ones made with FogLut_Exp at different densities
+typedef struct
+{
+	C3D_FogLut lut;
+	u32* keys;
+	int numKeys;
+	s32 curPos;
+} C3D_FogAnim;
+
+bool FogAnim_Init(C3D_FogAnim* anim, const C3D_FogLut* keys, int numKeys);
+void FogAnim_Free(C3D_FogAnim* anim);
+bool FogAnim_Update(C3D_FogAnim* anim, float pos);
+
 void C3D_FogGasMode(GPU_FOGMODE fogMode, GPU_GASMODE gasMode, bool zFlip);
 void C3D_FogColor(u32 color);
 void C3D_FogLutBind(C3D_FogLut* lut);
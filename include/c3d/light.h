@@ -19,6 +19,8 @@ typedef struct
 // Light environment
 //-----------------------------------------------------------------------------
 
+#define C3D_MTLCACHE_SIZE 4
+
 // Forward declarations
 typedef struct C3D_Light_t C3D_Light;
 typedef struct C3D_LightEnv_t C3D_LightEnv;
@@ -57,6 +59,12 @@ struct C3D_LightEnv_t
 	C3D_Light* lights[8];
 	C3D_LightEnvConf conf;
 	C3D_Material material;
+
+	// Recently used materials, each identified by a nonzero tag
+	u32 mtlTag, mtlTagNext;
+	u32 mtlCacheTags[C3D_MTLCACHE_SIZE];
+	C3D_Material mtlCache[C3D_MTLCACHE_SIZE];
+	u8 mtlCacheNext;
 };
 
 void C3D_LightEnvInit(C3D_LightEnv* env);
@@ -90,6 +98,12 @@ typedef struct
 	u32 specular0, specular1, diffuse, ambient;
 } C3D_LightMatConf;
 
+typedef struct
+{
+	u32 mtlTag;
+	C3D_LightMatConf conf;
+} C3D_LightMatCache;
+
 typedef struct
 {
 	C3D_LightMatConf material;
@@ -123,6 +137,10 @@ struct C3D_Light_t
 	float specular0[3];
 	float specular1[3];
 	C3D_LightConf conf;
+
+	// Blended colors for the parent's recently used materials
+	u8 mtlCacheNext;
+	C3D_LightMatCache mtlCache[C3D_MTLCACHE_SIZE];
 };
 
 int  C3D_LightInit(C3D_Light* light, C3D_LightEnv* env);
@@ -0,0 +1,174 @@
+#pragma once
+#include "types.h"
+
+// Mesh preprocessing helpers. These only operate on memory and can also be built for the host.
+
+// Post-transform cache size assumed by the optimizers; draws start with an empty cache
+#define C3D_MESH_VCACHE_SIZE 16
+
+// Relative cost of transforming a vertex compared to fetching an index
+#define C3D_MESH_MISS_COST 8
+
+// Upper bound of the number of indices produced by Mesh_Stripify
+#define C3D_MESH_STRIP_MAX(_numIndices) ((_numIndices)/3*6)
+
+typedef struct
+{
+	u32 misses;      // Number of vertices that had to be transformed
+	u32 triangles;   // Number of triangles submitted
+	u32 vertices;    // Number of unique vertices referenced
+	float acmr;      // Average cache miss ratio (misses per triangle)
+	float atvr;      // Average transform to vertex ratio (misses per unique vertex)
+} C3D_MeshCacheStats;
+
+u32 Mesh_CacheMisses(const u16* indices, u32 numIndices, u32 cacheSize);
+void Mesh_AnalyzeCache(C3D_MeshCacheStats* out, const u16* indices, u32 numIndices, u32 numVertices, u32 cacheSize);
+bool Mesh_OptimizeCache(u16* out, const u16* indices, u32 numIndices, u32 numVertices, u32 cacheSize);
+u32 Mesh_OptimizeFetch(u16* remap, u16* indices, u32 numIndices, u32 numVertices);
+void Mesh_RemapVertices(void* out, const void* in, u32 numVertices, u32 stride, const u16* remap);
+
+// Triangle strips. Without segEnds, strips are stitched into one with degenerate triangles;
+// otherwise segEnds receives the end offset of each strip, to be drawn as separate primitives.
+u32 Mesh_Stripify(u16* out, const u16* indices, u32 numIndices, u32* segEnds, u32* numSegs);
+u32 Mesh_StripOrList(u16* out, bool* isStrip, const u16* indices, u32 numIndices, u32 cacheSize);
+
+// Vertex quantization. Formats use the GPU_FORMATS encoding (GPU_UNSIGNED_BYTE, GPU_SHORT, GPU_FLOAT);
+// the shader reconstructs each attribute as stored*scale + bias.
+#define C3D_MESH_MAX_ATTRIBS 12
+
+typedef struct
+{
+	const float* data; // First component of the first vertex
+	u32 stride;        // Distance between vertices in bytes
+	u8 count;          // Number of components (1-4)
+	s8 regId;          // Shader input register
+	float maxError;    // Maximum absolute error allowed per component, 0 keeps floats
+} C3D_MeshStream;
+
+typedef struct
+{
+	s8 regId;
+	u8 format;
+	u8 count;
+	u8 offset;         // Offset within the interleaved vertex
+	u8 stream;         // Index of the source stream
+	C3D_FVec scale;
+	C3D_FVec bias;
+	float error;       // Largest quantization error of any component
+	const C3D_MeshStream* src;
+} C3D_MeshAttrib;
+
+typedef struct
+{
+	int numAttribs;
+	C3D_MeshAttrib attribs[C3D_MESH_MAX_ATTRIBS];
+	u32 stride;
+	u32 numVertices;
+} C3D_MeshLayout;
+
+bool Mesh_PackLayout(C3D_MeshLayout* out, const C3D_MeshStream* streams, int numStreams, u32 numVertices);
+void Mesh_PackVertices(void* out, const C3D_MeshLayout* layout);
+int Mesh_PackIndices(void* out, const u16* indices, u32 numIndices, u32 numVertices);
+
+// Binary mesh container, see mesh3ds.h for the loader. All offsets are relative to the start of the file.
+#define C3D_MESHFILE_MAGIC   0x5344334D // "M3DS"
+#define C3D_MESHFILE_VERSION 2
+
+typedef struct
+{
+	u32 offset;
+	u32 flags[2];
+} C3D_MeshFileBuf; // Same layout as C3D_BufCfg
+
+typedef struct
+{
+	u32 magic;
+	u16 version;
+	u16 primitive;     // GPU_Primitive_t
+	u32 fileSize;
+	u32 numVertices;
+	u32 numIndices;
+	u32 indexType;     // C3D_UNSIGNED_BYTE or C3D_UNSIGNED_SHORT
+	u32 indexOffset;
+	u32 uniformOffset; // Dequantization scale/bias pairs in stream order, as x,y,z,w floats
+	u32 numUniforms;
+	u32 attrFlags[2];  // Same layout as C3D_AttrInfo
+	u32 attrPermutation[2];
+	u32 attrCount;
+	u32 bufCount;
+	C3D_MeshFileBuf buffers[12];
+	float boundsMin[3];
+	float boundsMax[3];
+} C3D_MeshFileHeader;
+
+typedef struct
+{
+	const C3D_MeshLayout* layout;
+	const void* vertices; // Output of Mesh_PackVertices
+	const void* indices;  // Output of Mesh_PackIndices
+	u32 numIndices;
+	int indexType;
+	u16 primitive;
+	s8 positionReg;       // Attribute used for the bounds, or -1
+} C3D_MeshFileDesc;
+
+size_t Mesh_FileSize(const C3D_MeshFileDesc* desc);
+size_t Mesh_FileWrite(void* out, size_t outSize, const C3D_MeshFileDesc* desc);
+
+// Clusters of nearby triangles with similar facing, stored as structure of arrays for culling
+#define C3D_MESH_CLUSTER_MAX_TRIS 64
+
+typedef struct
+{
+	u32 count;
+	u32* first;        // First index of each cluster
+	u32* numIndices;
+	float* centerX;    // Bounding spheres
+	float* centerY;
+	float* centerZ;
+	float* radius;
+	float* axisX;      // Average triangle normals
+	float* axisY;
+	float* axisZ;
+	float* coneSin;    // Sine and cosine of the widest angle between a normal and the axis
+	float* coneCos;
+} C3D_MeshClusters;
+
+bool Mesh_BuildClusters(C3D_MeshClusters* out, u16* indices, u32 numIndices, const float* positions, u32 stride, u32 numVertices, u32 maxTriangles);
+void Mesh_FreeClusters(C3D_MeshClusters* clusters);
+void Mesh_FrustumPlanes(C3D_FVec planes[6], const C3D_Mtx* clip);
+u32 Mesh_CullClusters(u32* ranges, const C3D_MeshClusters* clusters, const C3D_FVec* planes, C3D_FVec eye);
+
+// Levels of detail sharing one vertex buffer, each one a range of a common index buffer.
+// Errors are object space distances; levels are selected by how many pixels that error covers.
+#define C3D_MESH_MAX_LODS 8
+
+typedef struct
+{
+	u32 first;         // First index of the level
+	u32 numIndices;
+	float error;       // Approximate deviation from the full detail mesh
+} C3D_MeshLod;
+
+typedef struct
+{
+	C3D_FVec sphere;   // View space bounding sphere, center in xyz and radius in w
+	const C3D_MeshLod* lods;
+	u8 numLods;
+	u8 level;          // Selected level, kept from frame to frame
+} C3D_MeshLodObject;
+
+u32 Mesh_Simplify(u16* out, float* outError, const u16* indices, u32 numIndices, const float* positions, u32 stride, u32 numVertices, u32 targetIndices, float maxError);
+int Mesh_BuildLods(u16* out, u32 outSize, C3D_MeshLod* lods, int maxLods, const u16* indices, u32 numIndices, const float* positions, u32 stride, u32 numVertices, float ratio);
+u32 Mesh_SelectLods(C3D_MeshLodObject* objects, u32 count, const C3D_Mtx* proj, float width, float height, float threshold, float hysteresis);
+
+#ifdef _3DS
+#include "attribs.h"
+#include "buffers.h"
+
+void Mesh_LayoutAttrInfo(const C3D_MeshLayout* layout, C3D_AttrInfo* info);
+int Mesh_LayoutBufInfo(const C3D_MeshLayout* layout, C3D_BufInfo* info, const void* data);
+// Stream i gets its scale in uniform firstId + 2*i and its bias in the next one, whatever order
+// Mesh_PackLayout sorted the attributes into
+void Mesh_LayoutUniforms(const C3D_MeshLayout* layout, int firstId);
+#endif
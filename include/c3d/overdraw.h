@@ -0,0 +1,27 @@
+#pragma once
+#include "types.h"
+
+// Overdraw analysis counts how many fragments were rasterized on each pixel of a render target. In
+// overdraw mode (see renderqueue.h) every draw increments the stencil buffer, so the count is read
+// back from the stencil byte of a D24S8 depth buffer. Counting is host-compatible and works on any
+// copy of the tiled buffer.
+#define C3D_OVERDRAW_BUCKETS 16
+
+typedef struct
+{
+	u32 pixels;    // Pixels in the buffer
+	u32 covered;   // Pixels drawn at least once
+	u32 fragments; // Fragments over all pixels
+	u32 maxLayers; // Highest count of a single pixel, saturates at 255
+	u32 histogram[C3D_OVERDRAW_BUCKETS]; // Pixels per count, the last bucket also holds higher counts
+} C3D_OverdrawStats;
+
+// depthBuf is a tiled (8x8 block) D24S8 buffer of width*height pixels. If heatmap is not NULL it
+// receives the count of every pixel, width bytes per row in the buffer's own row order.
+bool C3D_OverdrawCount(const void* depthBuf, u32 width, u32 height, C3D_OverdrawStats* out, u8* heatmap);
+
+// Average fragments per covered pixel
+static inline float C3D_OverdrawAverage(const C3D_OverdrawStats* stats)
+{
+	return stats->covered ? (float)stats->fragments / stats->covered : 0.0f;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "types.h"
+
+// Pixel formats as the GPU stores them, in GPU_COLORBUF order. RGBA8 pixels are little endian
+// 0xRRGGBBAA words and RGB8 pixels are B, G, R bytes.
+typedef enum
+{
+	C3D_PIX_RGBA8  = 0,
+	C3D_PIX_RGB8   = 1,
+	C3D_PIX_RGB5A1 = 2,
+	C3D_PIX_RGB565 = 3,
+	C3D_PIX_RGBA4  = 4,
+} C3D_PixFormat;
+
+// Layouts produced by the conversion kernels: R, G, B, A bytes as image files expect them, or native
+// 16-bit RGB565
+typedef enum
+{
+	C3D_PIXOUT_RGBA,
+	C3D_PIXOUT_RGB565,
+} C3D_PixOutput;
+
+// The kernels work a word at a time, so both buffers must be 4-byte aligned.
+// Converts linear pixels, such as display transfer output.
+void C3D_PixConvert(void* dst, C3D_PixOutput out, const void* src, C3D_PixFormat fmt, u32 numPixels);
+// Detiles and converts a buffer stored in 8x8 tiles (render targets, textures); dst gets width pixels
+// per row, rows in the buffer's own order
+void C3D_PixDetile(void* dst, C3D_PixOutput out, const void* src, C3D_PixFormat fmt, u32 width, u32 height);
+
+// Planar YUV 4:2:0 image, such as decoded video, with one U and V sample per 2x2 pixels
+typedef struct
+{
+	const u8* y;
+	const u8* u;
+	const u8* v;
+	u32 yStride;  // Bytes per luma row
+	u32 uvStride; // Bytes per chroma row
+} C3D_YUVFrame;
+
+// Converts rows [y0, y1) of a width pixels wide BT.601 YUV image straight into an 8x8-tiled RGB565 or
+// RGB8 texture image of texWidth*texHeight pixels. Texture memory starts with the top row (t=1), so
+// image row y is texture row y and the image fills the top left corner. width, y0 and y1 must be even.
+// Disjoint bands of rows can be converted concurrently.
+bool C3D_PixFromYUV420Tiled(void* dst, C3D_PixFormat fmt, u32 texWidth, u32 texHeight, const C3D_YUVFrame* src, u32 width, u32 y0, u32 y1);
+
+static inline u32 C3D_PixSize(C3D_PixFormat fmt)
+{
+	return fmt == C3D_PIX_RGBA8 ? 4 : fmt == C3D_PIX_RGB8 ? 3 : 2;
+}
+
+static inline u32 C3D_PixOutputSize(C3D_PixOutput out)
+{
+	return out == C3D_PIXOUT_RGBA ? 4 : 2;
+}
@@ -1,10 +1,11 @@
 #pragma once
-#include "types.h"
+#include "texture.h"
 
 typedef struct
 {
 	u32 color[256];
 	u32 diff[256];
+	u16 dirtyStart, dirtyEnd; // Range of entries not yet uploaded
 } C3D_ProcTexColorLut;
 
 typedef struct
@@ -94,6 +95,21 @@ void ProcTexLut_FromArray(C3D_ProcTexLut* lut, const float in[129]);
 void C3D_ProcTexColorLutBind(C3D_ProcTexColorLut* lut);
 void ProcTexColorLut_Write(C3D_ProcTexColorLut* out, const u32* in, int offset, int length);
 
+// CPU evaluation of a procedural texture configuration. NULL LUTs behave as a linear ramp.
+// Samples are returned in the same layout as the color LUT entries (R in the low byte).
+typedef struct
+{
+	const C3D_ProcTex* pt;
+	const C3D_ProcTexLut* noise;
+	const C3D_ProcTexLut* rgbMap;
+	const C3D_ProcTexLut* alphaMap;
+	const C3D_ProcTexColorLut* colorLut;
+} C3D_ProcTexEval;
+
+u32 ProcTexEval_Sample(const C3D_ProcTexEval* ev, float u, float v);
+void ProcTexEval_Row(const C3D_ProcTexEval* ev, u32* out, const float* u, const float* v, int count);
+bool ProcTexEval_Bake(const C3D_ProcTexEval* ev, C3D_Tex* tex, float u0, float v0, float u1, float v1);
+
 static inline void C3D_ProcTexClamp(C3D_ProcTex* pt, GPU_PROCTEX_CLAMP u, GPU_PROCTEX_CLAMP v)
 {
 	pt->uClamp = u;
@@ -0,0 +1,50 @@
+#pragma once
+#include "types.h"
+
+// Timeline profiler. Scopes are only compiled in when C3D_PROFILE is defined (make C3D_PROFILE=1 for the
+// library itself); completed scopes go to a lock-free ring buffer that can be exported as Chrome trace JSON.
+// Every draw records 3-4 events (the draw call, the context update and uniform uploads), so the default
+// ring holds about a thousand draws. Once it is full the oldest events are overwritten; they are counted
+// by C3D_ProfileDropped and reported in the export. Size the ring for a whole frame with C3D_ProfileInit
+// and call C3D_ProfileClear before the frame to export.
+#define C3D_PROFILE_CAPACITY 4096
+
+typedef struct
+{
+	const char* name;  // Must outlive the capture, usually a string literal
+	u64 start;         // In C3D_ProfileTicks units
+	u32 duration;
+	u32 thread;
+} C3D_ProfileEvent;
+
+typedef struct
+{
+	const char* name;
+	u64 start;
+} C3D_ProfileScope;
+
+// Replaces the ring with one of capacity events (0 restores the default one) and clears it. Must not be
+// called while scopes are being recorded.
+bool C3D_ProfileInit(u32 capacity);
+u64  C3D_ProfileTicks(void);
+void C3D_ProfileEnable(bool enable);
+void C3D_ProfileRecord(const char* name, u64 start, u64 end);
+void C3D_ProfileClear(void);
+u32  C3D_ProfileEvents(C3D_ProfileEvent* out, u32 maxEvents);
+// Events overwritten since the last clear because the ring was full
+u32  C3D_ProfileDropped(void);
+size_t C3D_ProfileExport(char* out, size_t size);
+
+static inline void C3D_ProfileScopeEnd(C3D_ProfileScope* scope)
+{
+	C3D_ProfileRecord(scope->name, scope->start, C3D_ProfileTicks());
+}
+
+#ifdef C3D_PROFILE
+#define C3Di_PROFILE_CAT2(_a, _b) _a##_b
+#define C3Di_PROFILE_CAT(_a, _b) C3Di_PROFILE_CAT2(_a, _b)
+#define C3D_PROFILE_SCOPE(_name) \
+	C3D_ProfileScope C3Di_PROFILE_CAT(__c3d_prof_, __LINE__) __attribute__((cleanup(C3D_ProfileScopeEnd))) = { (_name), C3D_ProfileTicks() }
+#else
+#define C3D_PROFILE_SCOPE(_name) do { } while (0)
+#endif
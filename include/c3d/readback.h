@@ -0,0 +1,28 @@
+#pragma once
+#include "renderqueue.h"
+#include "pixconv.h"
+
+// A readback copies a render target into linear memory with a display transfer, without waiting for
+// the GPU. Queue it inside a frame once the image is complete (usually just before C3D_FrameEnd); the
+// copy completes with the frame and can be converted once C3D_ReadbackReady returns true. Continuous
+// capture alternates between two readbacks so that one is converted while the other is in flight.
+typedef struct
+{
+	void* data;  // Linear copy of the target in fmt, rows in the target's own order
+	u32 fence;
+	u16 width, height;
+	GX_TRANSFER_FORMAT fmt;
+	bool queued;
+} C3D_Readback;
+
+bool C3D_ReadbackInit(C3D_Readback* rb, u16 width, u16 height, GX_TRANSFER_FORMAT fmt);
+// Waits for a queued copy, so it must not be called in the frame the copy was queued in
+void C3D_ReadbackDelete(C3D_Readback* rb);
+
+// The target must match the size of the readback. Outside of a frame the transfer waits for the GPU
+// to be idle first.
+bool C3D_ReadbackQueue(C3D_Readback* rb, C3D_RenderTarget* target);
+bool C3D_ReadbackReady(const C3D_Readback* rb);
+// Waits for the copy if needed and converts it into width*height linear pixels. Returns false if
+// nothing was queued or the frame it was queued in has not ended.
+bool C3D_ReadbackConvert(C3D_Readback* rb, void* dst, C3D_PixOutput out);
@@ -0,0 +1,65 @@
+#pragma once
+#include "renderqueue.h"
+
+#define C3D_RG_MAX_PASSES    16
+#define C3D_RG_MAX_RESOURCES 16
+#define C3D_RG_MAX_READS     4
+
+typedef void (* C3D_RenderPassCb)(void* param);
+
+typedef struct
+{
+	C3D_RenderTarget* target; // Imported, or created by C3D_RenderGraphCompile for transient resources
+	C3D_Tex* tex;             // Texture the target renders into, if it can be sampled
+	u16 width, height;
+	GPU_TEXCOLOR colorFmt;
+	s8 depthFmt;              // GPU_DEPTHBUF, or -1 for none
+	bool transient;
+	s8 alias;                 // Resource whose memory is used, or -1 if it has its own
+	s8 first, last;           // Lifetime, as positions in the execution order
+	C3D_Tex ownTex;
+} C3D_RenderGraphRes;
+
+typedef struct
+{
+	C3D_RenderPassCb cb;
+	void* param;
+	s8 target;                // Resource drawn into, or transferred to
+	s8 transferSrc;           // Resource transferred from, or -1 for draw passes
+	u32 transferFlags;
+	u8 numReads;
+	s8 reads[C3D_RG_MAX_READS];
+	C3D_ClearBits clearBits;
+	u32 clearColor, clearDepth;
+} C3D_RenderGraphPass;
+
+typedef struct
+{
+	C3D_RenderGraphPass passes[C3D_RG_MAX_PASSES];
+	C3D_RenderGraphRes res[C3D_RG_MAX_RESOURCES];
+	u8 order[C3D_RG_MAX_PASSES];
+	u8 numPasses, numRes, numOrdered;
+	bool compiled;
+} C3D_RenderGraph;
+
+void C3D_RenderGraphInit(C3D_RenderGraph* rg);
+void C3D_RenderGraphDelete(C3D_RenderGraph* rg);
+
+int C3D_RenderGraphImport(C3D_RenderGraph* rg, C3D_RenderTarget* target, C3D_Tex* tex);
+int C3D_RenderGraphTransient(C3D_RenderGraph* rg, u16 width, u16 height, GPU_TEXCOLOR colorFmt, C3D_DEPTHTYPE depthFmt);
+
+int  C3D_RenderGraphAddPass(C3D_RenderGraph* rg, int target, C3D_RenderPassCb cb, void* param);
+int  C3D_RenderGraphAddTransfer(C3D_RenderGraph* rg, int src, int dst, u32 transferFlags);
+bool C3D_RenderGraphRead(C3D_RenderGraph* rg, int pass, int res);
+void C3D_RenderGraphClear(C3D_RenderGraph* rg, int pass, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth);
+
+// Orders the passes, drops the ones whose output is never used and allocates transient resources.
+// Must be called outside of a frame; returns false if the dependencies form a cycle.
+bool C3D_RenderGraphCompile(C3D_RenderGraph* rg);
+void C3D_RenderGraphExecute(C3D_RenderGraph* rg);
+
+static inline C3D_Tex* C3D_RenderGraphGetTex(C3D_RenderGraph* rg, int res)
+{
+	C3D_RenderGraphRes* r = &rg->res[res];
+	return r->alias >= 0 ? rg->res[r->alias].tex : r->tex;
+}
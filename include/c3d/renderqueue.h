@@ -1,5 +1,6 @@
 #pragma once
 #include "framebuffer.h"
+#include "overdraw.h"
 
 typedef struct C3D_RenderTarget_tag C3D_RenderTarget;
 
@@ -9,6 +10,7 @@ struct C3D_RenderTarget_tag
 	C3D_FrameBuf frameBuf;
 
 	bool used;
+	bool autoCleared; // Cleared by the render queue and not drawn into since
 	bool ownsColor, ownsDepth;
 
 	bool linked;
@@ -24,11 +26,13 @@ enum
 {
 	C3D_FRAME_SYNCDRAW = BIT(0), // Perform C3D_FrameSync before checking the GPU status
 	C3D_FRAME_NONBLOCK = BIT(1), // Return false instead of waiting if the GPU is busy
+	C3D_FRAME_LOWLATENCY = BIT(2), // Delay the frame so that it finishes just before the next VBlank
 };
 
 float C3D_FrameRate(float fps);
 void C3D_FrameSync(void);
 u32 C3D_FrameCounter(int id);
+u32 C3D_FrameDeadlineMisses(void);
 
 bool C3D_FrameBegin(u8 flags);
 bool C3D_FrameDrawOn(C3D_RenderTarget* target);
@@ -37,6 +41,29 @@ void C3D_FrameEnd(u8 flags);
 
 void C3D_FrameEndHook(void (* hook)(void*), void* param);
 
+// A fence identifies the work submitted up to a point. C3D_FrameFence returns the fence of the current
+// frame (completed by C3D_FrameEnd), or of the last submitted work outside of a frame.
+u32 C3D_FrameFence(void);
+bool C3D_FenceReached(u32 fence);
+// Returns false if the fence belongs to a frame that has not ended yet
+bool C3D_FenceWait(u32 fence);
+
+// Captures the next frame to a file, see capture.h. All state is re-emitted at the start of the
+// captured frame so that the capture does not depend on earlier frames.
+bool C3D_FrameCapture(const char* path);
+
+// Overdraw mode replaces the stencil setup, blending and texture combiners of every draw so that it
+// increments the stencil buffer and adds a constant color, see overdraw.h. Fog and gas are turned off
+// so they don't tint that color. Targets need a D24S8 depth buffer cleared to a stencil of 0. An
+// isolated draw is the only one counted, attributing its fragments to it; pass -1 to count all draws
+// again. Draws are numbered from C3D_FrameBegin, one per draw call: C3D_DrawElementsRanges and
+// immediate mode draws are a single draw each.
+void C3D_OverdrawMode(bool enable);
+void C3D_OverdrawIsolate(int draw);
+// Waits for the GPU and counts the fragments drawn to target; heatmap is optional (see
+// C3D_OverdrawCount). Call after C3D_FrameEnd and before the target is cleared again.
+bool C3D_OverdrawRead(C3D_RenderTarget* target, C3D_OverdrawStats* out, u8* heatmap);
+
 float C3D_GetDrawingTime(void);
 float C3D_GetProcessingTime(void);
 
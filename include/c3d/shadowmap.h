@@ -0,0 +1,46 @@
+#pragma once
+#include "renderqueue.h"
+#include "maths.h"
+
+#define C3D_SHADOW_MAX_CASCADES 4
+
+typedef struct
+{
+	C3D_Tex* tex;
+	C3D_RenderTarget* target;
+
+	C3D_Mtx view, proj, viewProj;
+	float splitNear, splitFar;
+	float radius, depth;
+
+	// Texel-snapped light space position of the cascade, used to detect movement
+	float lightX, lightY, lightZ;
+	bool valid;
+} C3D_ShadowCascade;
+
+typedef struct
+{
+	int numCascades;
+	u16 size;
+	float lambda;  // 0 = uniform splits, 1 = logarithmic splits
+	float extend;  // Extra depth towards the light for casters outside the cascade bounds
+	C3D_FVec lightDir;
+	C3D_ShadowCascade cascades[C3D_SHADOW_MAX_CASCADES];
+} C3D_ShadowMap;
+
+void C3D_ShadowMapSplits(float* splits, int numCascades, float near, float far, float lambda);
+
+bool C3D_ShadowMapInit(C3D_ShadowMap* sm, int numCascades, u16 size);
+void C3D_ShadowMapDelete(C3D_ShadowMap* sm);
+void C3D_ShadowMapPurgePool(void);
+
+// Returns a mask of the cascades whose contents have to be rendered again
+u32  C3D_ShadowMapUpdate(C3D_ShadowMap* sm, const C3D_Mtx* view, float fovy, float aspect, float near, float far, C3D_FVec lightDir, bool isLeftHanded);
+bool C3D_ShadowCascadeCull(const C3D_ShadowCascade* cascade, C3D_FVec center, float radius);
+
+static inline void C3D_ShadowMapInvalidate(C3D_ShadowMap* sm)
+{
+	int i;
+	for (i = 0; i < sm->numCascades; i ++)
+		sm->cascades[i].valid = false;
+}
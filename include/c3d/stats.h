@@ -0,0 +1,35 @@
+#pragma once
+#include "types.h"
+
+// Command buffer statistics. Counters are only collected when citro3d is built with C3D_STATS
+// (make C3D_STATS=1); otherwise the hooks compile to nothing and C3D_GetStats returns zeros.
+enum
+{
+	C3D_STAT_PROGRAM = 0,
+	C3D_STAT_FRAMEBUF,  // Framebuffer, viewport and scissor
+	C3D_STAT_ATTRIB,    // Attribute and buffer info, fixed attributes
+	C3D_STAT_EFFECT,
+	C3D_STAT_TEXTURE,   // Texture units and procedural textures
+	C3D_STAT_TEXENV,
+	C3D_STAT_FOG,
+	C3D_STAT_LIGHTING,
+	C3D_STAT_UNIFORMS,
+	C3D_STAT_DRAW,      // Draw call setup and kick-off
+
+	C3D_STAT_COUNT,
+};
+
+typedef struct
+{
+	u32 words[C3D_STAT_COUNT];   // Command buffer words emitted per category
+	u32 changes[C3D_STAT_COUNT]; // Number of times each category was (re)emitted
+	u32 draws;
+	u32 vertices;                // Non-indexed and immediate mode vertices
+	u32 indices;
+} C3D_Stats;
+
+// Returns the counters of the last frame ended with C3D_FrameEnd
+void C3D_GetStats(C3D_Stats* out);
+// Returns the counters accumulated since the current frame began, or since the last C3D_ResetStats
+void C3D_GetStatsCurrent(C3D_Stats* out);
+void C3D_ResetStats(void);
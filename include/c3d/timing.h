@@ -0,0 +1,21 @@
+#pragma once
+#include "types.h"
+
+#define C3D_TIMING_MAX_SCOPES 16
+#define C3D_TIMING_WINDOW     32 // Number of frames averaged
+
+typedef struct
+{
+	const char* name;
+	float gpuAvg, gpuMax; // Milliseconds per frame
+	float cpuAvg, cpuMax;
+	u32 frames;           // Frames in the window that used the scope
+} C3D_TimingInfo;
+
+// Commands recorded between C3D_TimingBegin and C3D_TimingEnd are submitted as their own command
+// lists, whose GPU time is measured when each one completes. Scopes end with the frame.
+int  C3D_TimingScope(const char* name);
+void C3D_TimingBegin(int scope);
+void C3D_TimingEnd(void);
+bool C3D_TimingGet(int scope, C3D_TimingInfo* info);
+void C3D_TimingReset(void);
@@ -3,9 +3,15 @@
 #include <3ds.h>
 #else
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 typedef uint8_t u8;
+typedef uint16_t u16;
 typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
 #endif
 
 #ifndef CITRO3D_NO_DEPRECATION
@@ -16,6 +22,13 @@ typedef uint32_t u32;
 
 typedef u32 C3D_IVec;
 
+// Index types of C3D_DrawElements; here rather than in base.h so that host-side mesh tools can use them
+enum
+{
+	C3D_UNSIGNED_BYTE = 0,
+	C3D_UNSIGNED_SHORT = 1,
+};
+
 static inline C3D_IVec IVec_Pack(u8 x, u8 y, u8 z, u8 w)
 {
 	return (u32)x | ((u32)y << 8) | ((u32)z << 16) | ((u32)w << 24);
@@ -0,0 +1,43 @@
+#pragma once
+#include "renderqueue.h"
+#include "pixconv.h"
+
+#define C3D_VIDEOTEX_MAX_BUFFERS 4
+
+// A video texture streams frames into a ring of textures. A frame is converted into a buffer the GPU
+// no longer samples while the previous one is displayed, so uploads never wait for rendering as long as
+// there are enough buffers (three keep the decoder a frame ahead).
+typedef struct
+{
+	C3D_Tex tex[C3D_VIDEOTEX_MAX_BUFFERS];
+	u32 fence[C3D_VIDEOTEX_MAX_BUFFERS]; // Last frame that sampled each buffer
+	u8 numBuffers;
+	s8 current;  // Buffer with the newest complete frame, or -1
+	s8 writing;  // Buffer between C3D_VideoTexBegin and C3D_VideoTexEnd, or -1
+	u16 width, height;
+} C3D_VideoTex;
+
+// The textures are rounded up to powers of two, see C3D_VideoTexExtent. fmt is GPU_RGB565 or GPU_RGB8.
+bool C3D_VideoTexInit(C3D_VideoTex* vt, u16 width, u16 height, GPU_TEXCOLOR fmt, int numBuffers);
+// Waits for the GPU to stop sampling the buffers, so it must be called outside of a frame
+void C3D_VideoTexDelete(C3D_VideoTex* vt);
+
+// Starts a new frame and returns its texture. If every other buffer is still in use, returns NULL or,
+// if wait is set, waits for the oldest one.
+C3D_Tex* C3D_VideoTexBegin(C3D_VideoTex* vt, bool wait);
+// Converts rows [y0, y1) of the frame being written; y0 and y1 must be even. Bands may be converted
+// on several threads at once, e.g. split in halves between the application and a system core thread.
+bool C3D_VideoTexConvert(C3D_VideoTex* vt, const C3D_YUVFrame* frame, u32 y0, u32 y1);
+// Flushes the frame being written and makes it the current one
+void C3D_VideoTexEnd(C3D_VideoTex* vt);
+
+// Binds the current frame inside C3D_FrameBegin/C3D_FrameEnd and records that the frame samples it.
+// Returns NULL before the first frame has been written.
+C3D_Tex* C3D_VideoTexBind(C3D_VideoTex* vt, int unitId);
+
+// Texture coordinates of the bottom right corner of the video; the top left corner is (0, 1)
+static inline void C3D_VideoTexExtent(const C3D_VideoTex* vt, float* s, float* t)
+{
+	*s = (float)vt->width / vt->tex[0].width;
+	*t = 1.0f - (float)vt->height / vt->tex[0].height;
+}
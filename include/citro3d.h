@@ -28,6 +28,20 @@ extern "C" {
 
 #include "c3d/framebuffer.h"
 #include "c3d/renderqueue.h"
+#include "c3d/rendergraph.h"
+#include "c3d/timing.h"
+#include "c3d/profile.h"
+#include "c3d/stats.h"
+#include "c3d/cmdstream.h"
+#include "c3d/capture.h"
+#include "c3d/costmodel.h"
+#include "c3d/overdraw.h"
+#include "c3d/pixconv.h"
+#include "c3d/readback.h"
+#include "c3d/videotex.h"
+#include "c3d/shadowmap.h"
+
+#include "c3d/mesh.h"
 
 #ifdef __cplusplus
 }
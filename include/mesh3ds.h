@@ -0,0 +1,86 @@
+/** @file mesh3ds.h
+ *  @brief Mesh3DS support
+ */
+#pragma once
+#ifdef CITRO3D_BUILD
+#include "c3d/mesh.h"
+#include "c3d/base.h"
+#else
+#include <citro3d.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Mesh
+ *  @note The whole file lives in a single linear allocation which is used in place
+ */
+typedef struct Mesh3DS_Mesh_s* Mesh3DS_Mesh;
+
+/** @brief Import Mesh3DS mesh
+ *  @param[in] input  Input data
+ *  @param[in] insize Size of the input data
+ *  @returns Mesh3DS mesh
+ */
+Mesh3DS_Mesh Mesh3DS_MeshImport(const void* input, size_t insize);
+
+/** @brief Import Mesh3DS mesh
+ *
+ *  Reads from the current file descriptor's offset to the end of the file
+ *  with a single read.
+ *
+ *  @param[in] fd Open file descriptor
+ *  @returns Mesh3DS mesh
+ */
+Mesh3DS_Mesh Mesh3DS_MeshImportFD(int fd);
+
+/** @brief Import Mesh3DS mesh
+ *
+ *  Reads from the current file stream's offset to the end of the file with a
+ *  single read.
+ *
+ *  @param[in] fp Open file stream
+ *  @returns Mesh3DS mesh
+ */
+Mesh3DS_Mesh Mesh3DS_MeshImportStdio(FILE* fp);
+
+/** @brief Bind the mesh's attribute and buffer configuration
+ *  @param[in] mesh Mesh3DS mesh
+ */
+void Mesh3DS_MeshBind(const Mesh3DS_Mesh mesh);
+
+/** @brief Upload the mesh's dequantization scale/bias pairs
+ *  @param[in] mesh    Mesh3DS mesh
+ *  @param[in] firstId First vertex shader float uniform (two per input stream, in stream order)
+ */
+void Mesh3DS_MeshSetUniforms(const Mesh3DS_Mesh mesh, int firstId);
+
+/** @brief Draw the whole mesh
+ *  @param[in] mesh Mesh3DS mesh
+ */
+void Mesh3DS_MeshDraw(const Mesh3DS_Mesh mesh);
+
+/** @brief Get mesh header
+ *  @param[in] mesh Mesh3DS mesh
+ *  @returns Header, including counts and bounds
+ */
+const C3D_MeshFileHeader* Mesh3DS_MeshGetHeader(const Mesh3DS_Mesh mesh);
+
+/** @brief Get index data
+ *  @param[in] mesh Mesh3DS mesh
+ *  @returns Pointer to the index buffer in linear memory
+ */
+const void* Mesh3DS_MeshGetIndices(const Mesh3DS_Mesh mesh);
+
+/** @brief Free Mesh3DS mesh
+ *  @param[in] mesh Mesh3DS mesh to free
+ */
+void Mesh3DS_MeshFree(Mesh3DS_Mesh mesh);
+
+#ifdef __cplusplus
+}
+#endif
@@ -16,6 +16,65 @@ __attribute__((weak)) void C3Di_RenderQueueExit(void)
 {
 }
 
+__attribute__((weak)) void C3Di_ShadowPoolExit(void)
+{
+}
+
+__attribute__((weak)) void C3Di_TimingSubmit(void)
+{
+}
+
+__attribute__((weak)) void C3Di_TimingFrameEnd(void)
+{
+}
+
+__attribute__((weak)) void C3Di_TimingExit(void)
+{
+}
+
+__attribute__((weak)) void C3Di_CaptureFrameBegin(void)
+{
+}
+
+__attribute__((weak)) void C3Di_CaptureList(u32* cmdBuf, u32 cmdBufSize)
+{
+	(void)cmdBuf;
+	(void)cmdBufSize;
+}
+
+__attribute__((weak)) void C3Di_CaptureFrameEnd(void)
+{
+}
+
+__attribute__((weak)) void C3Di_CaptureExit(void)
+{
+}
+
+__attribute__((weak)) void C3Di_OverdrawFrameBegin(void)
+{
+}
+
+__attribute__((weak)) void C3Di_OverdrawDraw(C3D_Context* ctx)
+{
+	(void)ctx;
+}
+
+__attribute__((weak)) C3D_Effect* C3Di_OverdrawEffect(C3D_Effect* e)
+{
+	return e;
+}
+
+__attribute__((weak)) C3D_TexEnv* C3Di_OverdrawTexEnv(int id, C3D_TexEnv* env)
+{
+	(void)id;
+	return env;
+}
+
+__attribute__((weak)) u32 C3Di_OverdrawTexEnvBuf(u32 texEnvBuf)
+{
+	return texEnvBuf;
+}
+
 __attribute__((weak)) void C3Di_LightEnvUpdate(C3D_LightEnv* env)
 {
 	(void)env;
@@ -36,6 +95,26 @@ __attribute__((weak)) void C3Di_ProcTexDirty(C3D_Context* ctx)
 	(void)ctx;
 }
 
+void C3Di_DirtyAll(C3D_Context* ctx)
+{
+	ctx->flags |= C3DiF_AttrInfo | C3DiF_BufInfo | C3DiF_Effect | C3DiF_FrameBuf
+		| C3DiF_Viewport | C3DiF_Scissor | C3DiF_Program | C3DiF_VshCode | C3DiF_GshCode
+		| C3DiF_TexAll | C3DiF_TexEnvBuf | C3DiF_TexEnvAll | C3DiF_LightEnv;
+	ctx->texEnvHwValid = 0;
+
+	C3Di_DirtyUniforms(GPU_VERTEX_SHADER);
+	C3Di_DirtyUniforms(GPU_GEOMETRY_SHADER);
+
+	ctx->fixedAttribDirty |= ctx->fixedAttribEverDirty;
+
+	C3D_LightEnv* env = ctx->lightEnv;
+	if (ctx->fogLut)
+		ctx->flags |= C3DiF_FogLut;
+	if (env)
+		C3Di_LightEnvDirty(env);
+	C3Di_ProcTexDirty(ctx);
+}
+
 static void C3Di_AptEventHook(APT_HookType hookType, C3D_UNUSED void* param)
 {
 	C3D_Context* ctx = C3Di_GetContext();
@@ -49,21 +128,7 @@ static void C3Di_AptEventHook(APT_HookType hookType, C3D_UNUSED void* param)
 		}
 		case APTHOOK_ONRESTORE:
 		{
-			ctx->flags |= C3DiF_AttrInfo | C3DiF_BufInfo | C3DiF_Effect | C3DiF_FrameBuf
-				| C3DiF_Viewport | C3DiF_Scissor | C3DiF_Program | C3DiF_VshCode | C3DiF_GshCode
-				| C3DiF_TexAll | C3DiF_TexEnvBuf | C3DiF_TexEnvAll | C3DiF_LightEnv;
-
-			C3Di_DirtyUniforms(GPU_VERTEX_SHADER);
-			C3Di_DirtyUniforms(GPU_GEOMETRY_SHADER);
-
-			ctx->fixedAttribDirty |= ctx->fixedAttribEverDirty;
-
-			C3D_LightEnv* env = ctx->lightEnv;
-			if (ctx->fogLut)
-				ctx->flags |= C3DiF_FogLut;
-			if (env)
-				C3Di_LightEnvDirty(env);
-			C3Di_ProcTexDirty(ctx);
+			C3Di_DirtyAll(ctx);
 			break;
 		}
 		default:
@@ -125,6 +190,7 @@ bool C3D_Init(size_t cmdBufSize)
 
 	for (i = 0; i < 6; i ++)
 		C3D_TexEnvInit(&ctx->texEnv[i]);
+	ctx->texEnvHwValid = 0;
 
 	ctx->fixedAttribDirty = 0;
 	ctx->fixedAttribEverDirty = 0;
@@ -160,12 +226,17 @@ void C3Di_UpdateContext(void)
 {
 	int i;
 	C3D_Context* ctx = C3Di_GetContext();
+	C3D_PROFILE_SCOPE("C3Di_UpdateContext");
+	// Overdraw mode only marks state dirty, its words are counted with that state below
+	C3Di_OverdrawDraw(ctx);
+	C3Di_STATS_MARK();
 
 	if (ctx->flags & C3DiF_Program)
 	{
 		shaderProgramConfigure(ctx->program, (ctx->flags & C3DiF_VshCode) != 0, (ctx->flags & C3DiF_GshCode) != 0);
 		ctx->flags &= ~(C3DiF_Program | C3DiF_VshCode | C3DiF_GshCode);
 	}
+	C3Di_STATS_ADD(C3D_STAT_PROGRAM);
 
 	if (ctx->flags & C3DiF_FrameBuf)
 	{
@@ -191,6 +262,7 @@ void C3Di_UpdateContext(void)
 		ctx->flags &= ~C3DiF_Scissor;
 		GPUCMD_AddIncrementalWrites(GPUREG_SCISSORTEST_MODE, ctx->scissor, 3);
 	}
+	C3Di_STATS_ADD(C3D_STAT_FRAMEBUF);
 
 	if (ctx->flags & C3DiF_AttrInfo)
 	{
@@ -203,12 +275,14 @@ void C3Di_UpdateContext(void)
 		ctx->flags &= ~C3DiF_BufInfo;
 		C3Di_BufInfoBind(&ctx->bufInfo);
 	}
+	C3Di_STATS_ADD(C3D_STAT_ATTRIB);
 
 	if (ctx->flags & C3DiF_Effect)
 	{
 		ctx->flags &= ~C3DiF_Effect;
-		C3Di_EffectBind(&ctx->effect);
+		C3Di_EffectBind(C3Di_OverdrawEffect(&ctx->effect));
 	}
+	C3Di_STATS_ADD(C3D_STAT_EFFECT);
 
 	if (ctx->flags & C3DiF_TexAll)
 	{
@@ -240,14 +314,7 @@ void C3Di_UpdateContext(void)
 
 	if (ctx->flags & (C3DiF_ProcTex | C3DiF_ProcTexColorLut | C3DiF_ProcTexLutAll))
 		C3Di_ProcTexUpdate(ctx);
-
-	if (ctx->flags & C3DiF_TexEnvBuf)
-	{
-		ctx->flags &= ~C3DiF_TexEnvBuf;
-		GPUCMD_AddMaskedWrite(GPUREG_TEXENV_UPDATE_BUFFER, 0x7, ctx->texEnvBuf);
-		GPUCMD_AddWrite(GPUREG_TEXENV_BUFFER_COLOR, ctx->texEnvBufClr);
-		GPUCMD_AddWrite(GPUREG_FOG_COLOR, ctx->fogClr);
-	}
+	C3Di_STATS_ADD(C3D_STAT_TEXTURE);
 
 	if (ctx->flags & C3DiF_FogLut)
 	{
@@ -258,16 +325,26 @@ void C3Di_UpdateContext(void)
 			GPUCMD_AddWrites(GPUREG_FOG_LUT_DATA0, ctx->fogLut->data, 128);
 		}
 	}
+	C3Di_STATS_ADD(C3D_STAT_FOG);
+
+	if (ctx->flags & C3DiF_TexEnvBuf)
+	{
+		ctx->flags &= ~C3DiF_TexEnvBuf;
+		GPUCMD_AddMaskedWrite(GPUREG_TEXENV_UPDATE_BUFFER, 0x7, C3Di_OverdrawTexEnvBuf(ctx->texEnvBuf));
+		GPUCMD_AddWrite(GPUREG_TEXENV_BUFFER_COLOR, ctx->texEnvBufClr);
+		GPUCMD_AddWrite(GPUREG_FOG_COLOR, ctx->fogClr);
+	}
 
 	if (ctx->flags & C3DiF_TexEnvAll)
 	{
 		for (i = 0; i < 6; i ++)
 		{
 			if (!(ctx->flags & C3DiF_TexEnv(i))) continue;
-			C3Di_TexEnvBind(i, &ctx->texEnv[i]);
+			C3Di_TexEnvBind(i, C3Di_OverdrawTexEnv(i, &ctx->texEnv[i]));
 		}
 		ctx->flags &= ~C3DiF_TexEnvAll;
 	}
+	C3Di_STATS_ADD(C3D_STAT_TEXENV);
 
 	C3D_LightEnv* env = ctx->lightEnv;
 
@@ -281,6 +358,7 @@ void C3Di_UpdateContext(void)
 
 	if (env)
 		C3Di_LightEnvUpdate(env);
+	C3Di_STATS_ADD(C3D_STAT_LIGHTING);
 
 	if (ctx->fixedAttribDirty)
 	{
@@ -294,9 +372,11 @@ void C3Di_UpdateContext(void)
 		}
 		ctx->fixedAttribDirty = 0;
 	}
+	C3Di_STATS_ADD(C3D_STAT_ATTRIB);
 
 	C3D_UpdateUniforms(GPU_VERTEX_SHADER);
 	C3D_UpdateUniforms(GPU_GEOMETRY_SHADER);
+	C3Di_STATS_ADD(C3D_STAT_UNIFORMS);
 }
 
 bool C3Di_SplitFrame(u32** pBuf, u32* pSize)
@@ -352,6 +432,9 @@ void C3D_Fini(void)
 		return;
 
 	C3Di_RenderQueueExit();
+	C3Di_ShadowPoolExit();
+	C3Di_TimingExit();
+	C3Di_CaptureExit();
 	aptUnhook(&hookCookie);
 	gxCmdQueueStop(&ctx->gxQueue);
 	gxCmdQueueWait(&ctx->gxQueue, -1);
@@ -0,0 +1,277 @@
+#include "internal.h"
+#include <stdlib.h>
+
+#define BUFPOOL_MIN_ALIGN 16
+
+typedef struct
+{
+	u64 key; // (block<<32) | offset
+	u32 id;
+} BufPoolSortKey;
+
+static inline u32 alignUp(u32 x, u32 align)
+{
+	return (x + align-1) &~ (align-1);
+}
+
+static int sortKeyCompare(const void* a, const void* b)
+{
+	u64 ka = ((const BufPoolSortKey*)a)->key, kb = ((const BufPoolSortKey*)b)->key;
+	return ka < kb ? -1 : ka > kb ? 1 : 0;
+}
+
+static C3D_BufPoolEntry* entryGet(const C3D_BufPool* pool, C3D_BufHandle handle)
+{
+	if (!handle || handle > pool->numEntries)
+		return NULL;
+	C3D_BufPoolEntry* e = &pool->entries[handle-1];
+	return e->align ? e : NULL;
+}
+
+static void blockInfoReset(C3D_BufPoolBlock* block)
+{
+	BufInfo_Init(&block->info);
+	block->info.base_paddr = osConvertVirtToPhys(block->data);
+}
+
+static int blockAdd(C3D_BufPool* pool, u32 size)
+{
+	C3D_BufPoolBlock* blocks = (C3D_BufPoolBlock*)realloc(pool->blocks, (pool->numBlocks+1)*sizeof(C3D_BufPoolBlock));
+	if (!blocks)
+		return -1;
+	pool->blocks = blocks;
+
+	C3D_BufPoolBlock* block = &blocks[pool->numBlocks];
+	memset(block, 0, sizeof(*block));
+	block->data = linearMemAlign(size, C3D_BUFPOOL_MAX_ALIGN);
+	if (!block->data)
+		return -1;
+	block->size = size;
+	blockInfoReset(block);
+	return pool->numBlocks++;
+}
+
+static u32 entryAdd(C3D_BufPool* pool)
+{
+	u32 id;
+	if (pool->freeEntry)
+	{
+		id = pool->freeEntry-1;
+		pool->freeEntry = pool->entries[id].offset;
+		return id+1;
+	}
+
+	if (pool->numEntries == pool->maxEntries)
+	{
+		u32 maxEntries = pool->maxEntries ? pool->maxEntries*2 : 64;
+		C3D_BufPoolEntry* entries = (C3D_BufPoolEntry*)realloc(pool->entries, maxEntries*sizeof(C3D_BufPoolEntry));
+		if (!entries)
+			return 0;
+		pool->entries = entries;
+		pool->maxEntries = maxEntries;
+	}
+	return ++pool->numEntries;
+}
+
+void BufPool_Init(C3D_BufPool* pool, u32 blockSize)
+{
+	memset(pool, 0, sizeof(*pool));
+	pool->blockSize = alignUp(blockSize, C3D_BUFPOOL_MAX_ALIGN);
+}
+
+void BufPool_Fini(C3D_BufPool* pool)
+{
+	int i;
+	for (i = 0; i < pool->numBlocks; i ++)
+		linearFree(pool->blocks[i].data);
+	free(pool->blocks);
+	free(pool->entries);
+	memset(pool, 0, sizeof(*pool));
+}
+
+C3D_BufHandle BufPool_Alloc(C3D_BufPool* pool, u32 size, u32 align)
+{
+	int i;
+	u32 offset = 0;
+
+	if (align < BUFPOOL_MIN_ALIGN)
+		align = BUFPOOL_MIN_ALIGN;
+	if (!size || (align & (align-1)) || align > C3D_BUFPOOL_MAX_ALIGN)
+		return 0;
+
+	// First fit; blocks only grow until they are emptied or compacted
+	for (i = 0; i < pool->numBlocks; i ++)
+	{
+		C3D_BufPoolBlock* block = &pool->blocks[i];
+		offset = alignUp(block->used, align);
+		if (offset + size <= block->size)
+			break;
+	}
+
+	if (i == pool->numBlocks)
+	{
+		// Buffers larger than a block get one to themselves
+		i = blockAdd(pool, size > pool->blockSize ? alignUp(size, C3D_BUFPOOL_MAX_ALIGN) : pool->blockSize);
+		if (i < 0)
+			return 0;
+		offset = 0;
+	}
+
+	C3D_BufHandle handle = entryAdd(pool);
+	if (!handle)
+		return 0;
+
+	C3D_BufPoolBlock* block = &pool->blocks[i];
+	C3D_BufPoolEntry* e = &pool->entries[handle-1];
+	e->offset = offset;
+	e->size = size;
+	e->block = i;
+	e->align = align;
+	block->used = offset + size;
+	block->live += size;
+	block->count ++;
+	return handle;
+}
+
+C3D_BufHandle BufPool_Upload(C3D_BufPool* pool, const void* data, u32 size, u32 align)
+{
+	C3D_BufHandle handle = BufPool_Alloc(pool, size, align);
+	if (handle)
+	{
+		void* ptr = BufPool_Get(pool, handle);
+		memcpy(ptr, data, size);
+		GSPGPU_FlushDataCache(ptr, size);
+	}
+	return handle;
+}
+
+void BufPool_Free(C3D_BufPool* pool, C3D_BufHandle handle)
+{
+	C3D_BufPoolEntry* e = entryGet(pool, handle);
+	if (!e)
+		return;
+
+	C3D_BufPoolBlock* block = &pool->blocks[e->block];
+	block->live -= e->size;
+	if (!--block->count)
+		block->used = 0;
+	else if (e->offset + e->size == block->used)
+		block->used = e->offset;
+
+	e->align = 0;
+	e->offset = pool->freeEntry;
+	pool->freeEntry = handle;
+}
+
+void* BufPool_Get(const C3D_BufPool* pool, C3D_BufHandle handle)
+{
+	C3D_BufPoolEntry* e = entryGet(pool, handle);
+	if (!e)
+		return NULL;
+	return (u8*)pool->blocks[e->block].data + e->offset;
+}
+
+int BufPool_Block(const C3D_BufPool* pool, C3D_BufHandle handle)
+{
+	C3D_BufPoolEntry* e = entryGet(pool, handle);
+	return e ? e->block : -1;
+}
+
+C3D_BufInfo* BufPool_GetBufInfo(C3D_BufPool* pool, C3D_BufHandle handle)
+{
+	C3D_BufPoolEntry* e = entryGet(pool, handle);
+	return e ? &pool->blocks[e->block].info : NULL;
+}
+
+u32 BufPool_Compact(C3D_BufPool* pool)
+{
+	u32 i, count = 0, released = 0;
+	int b, numBlocks;
+
+	for (i = 0; i < pool->numEntries; i ++)
+		if (pool->entries[i].align)
+			count ++;
+
+	BufPoolSortKey* keys = (BufPoolSortKey*)malloc(count*sizeof(BufPoolSortKey) + 1);
+	int* remap = (int*)malloc(pool->numBlocks*sizeof(int) + 1);
+	if (!keys || !remap)
+	{
+		free(keys);
+		free(remap);
+		return 0;
+	}
+
+	count = 0;
+	for (i = 0; i < pool->numEntries; i ++)
+	{
+		const C3D_BufPoolEntry* e = &pool->entries[i];
+		if (!e->align)
+			continue;
+		keys[count].key = ((u64)e->block << 32) | e->offset;
+		keys[count].id = i;
+		count ++;
+	}
+	qsort(keys, count, sizeof(BufPoolSortKey), sortKeyCompare);
+
+	for (b = 0; b < pool->numBlocks; b ++)
+	{
+		C3D_BufPoolBlock* block = &pool->blocks[b];
+		block->used = block->live = block->count = 0;
+	}
+
+	// Slide every allocation down as far as it goes. An allocation always fits at or before its
+	// current place, so the cursor never passes it and the memory it lands on is already free.
+	b = 0;
+	u32 cursor = 0;
+	for (i = 0; i < count; i ++)
+	{
+		C3D_BufPoolEntry* e = &pool->entries[keys[i].id];
+		u32 offset = alignUp(cursor, e->align);
+		while (offset + e->size > pool->blocks[b].size)
+		{
+			b ++;
+			offset = 0;
+		}
+
+		C3D_BufPoolBlock* block = &pool->blocks[b];
+		if (b != e->block || offset != e->offset)
+			memmove((u8*)block->data + offset, (u8*)pool->blocks[e->block].data + e->offset, e->size);
+		e->block = b;
+		e->offset = offset;
+		cursor = offset + e->size;
+		block->used = cursor;
+		block->live += e->size;
+		block->count ++;
+	}
+
+	// Release emptied blocks. Buffer offsets change, so shared buffer configurations start over.
+	numBlocks = 0;
+	for (b = 0; b < pool->numBlocks; b ++)
+	{
+		C3D_BufPoolBlock* block = &pool->blocks[b];
+		if (!block->count)
+		{
+			released += block->size;
+			linearFree(block->data);
+			remap[b] = -1;
+			continue;
+		}
+
+		GSPGPU_FlushDataCache(block->data, block->used);
+		remap[b] = numBlocks;
+		pool->blocks[numBlocks] = *block;
+		blockInfoReset(&pool->blocks[numBlocks]);
+		numBlocks ++;
+	}
+	pool->numBlocks = numBlocks;
+
+	for (i = 0; i < count; i ++)
+	{
+		C3D_BufPoolEntry* e = &pool->entries[keys[i].id];
+		e->block = remap[e->block];
+	}
+
+	free(keys);
+	free(remap);
+	return released;
+}
@@ -2,7 +2,10 @@
 
 void C3D_DrawArrays(GPU_Primitive_t primitive, int first, int size)
 {
+	C3D_PROFILE_SCOPE("C3D_DrawArrays");
+
 	C3Di_UpdateContext();
+	C3Di_STATS_MARK();
 
 	// Set primitive type
 	GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 2, primitive);
@@ -26,6 +29,8 @@ void C3D_DrawArrays(GPU_Primitive_t primitive, int first, int size)
 	GPUCMD_AddMaskedWrite(GPUREG_GEOSTAGE_CONFIG2, 1, 0);
 	// Clear the post-vertex cache
 	GPUCMD_AddWrite(GPUREG_VTX_FUNC, 1);
+	C3Di_STATS_ADD(C3D_STAT_DRAW);
+	C3Di_STATS_DRAW(1, size, 0);
 
 	C3Di_GetContext()->flags |= C3DiF_DrawUsed;
 }
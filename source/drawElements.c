@@ -6,8 +6,10 @@ void C3D_DrawElements(GPU_Primitive_t primitive, int count, int type, const void
 	u32 pa = osConvertVirtToPhys(indices);
 	u32 base = ctx->bufInfo.base_paddr;
 	if (pa < base) return;
+	C3D_PROFILE_SCOPE("C3D_DrawElements");
 
 	C3Di_UpdateContext();
+	C3Di_STATS_MARK();
 
 	// Set primitive type
 	GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 2, primitive != GPU_TRIANGLES ? primitive : GPU_GEOMETRY_PRIM);
@@ -41,6 +43,60 @@ void C3D_DrawElements(GPU_Primitive_t primitive, int count, int type, const void
 	GPUCMD_AddWrite(GPUREG_VTX_FUNC, 1);
 	GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 0x8, 0);
 	GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 0x8, 0);
+	C3Di_STATS_ADD(C3D_STAT_DRAW);
+	C3Di_STATS_DRAW(1, 0, count);
 
 	C3Di_GetContext()->flags |= C3DiF_DrawUsed;
 }
+
+void C3D_DrawElementsRanges(GPU_Primitive_t primitive, int type, const void* indices, const u32* ranges, int numRanges)
+{
+	C3D_Context* ctx = C3Di_GetContext();
+	u32 pa = osConvertVirtToPhys(indices);
+	u32 base = ctx->bufInfo.base_paddr;
+	int i;
+	if (pa < base || numRanges <= 0) return;
+	C3D_PROFILE_SCOPE("C3D_DrawElementsRanges");
+
+	C3Di_UpdateContext();
+	C3Di_STATS_MARK();
+
+	// Set primitive type
+	GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 2, primitive != GPU_TRIANGLES ? primitive : GPU_GEOMETRY_PRIM);
+	// First vertex
+	GPUCMD_AddWrite(GPUREG_VERTEX_OFFSET, 0);
+	// Enable triangle element drawing mode if necessary
+	if (primitive == GPU_TRIANGLES)
+	{
+		GPUCMD_AddMaskedWrite(GPUREG_GEOSTAGE_CONFIG, 2, 0x100);
+		GPUCMD_AddMaskedWrite(GPUREG_GEOSTAGE_CONFIG2, 2, 0x100);
+	}
+
+	// Each range is an (offset, count) pair in indices; all of them share the same vertex
+	// buffers, so the post-vertex cache is only cleared once at the end
+	for (i = 0; i < numRanges; i ++)
+	{
+		u32 offset = ranges[i*2] << (type ? 1 : 0);
+		GPUCMD_AddWrite(GPUREG_RESTART_PRIMITIVE, 1);
+		GPUCMD_AddWrite(GPUREG_INDEXBUFFER_CONFIG, (pa + offset - base) | (type << 31));
+		GPUCMD_AddWrite(GPUREG_NUMVERTICES, ranges[i*2+1]);
+		GPUCMD_AddMaskedWrite(GPUREG_START_DRAW_FUNC0, 1, 0);
+		GPUCMD_AddWrite(GPUREG_DRAWELEMENTS, 1);
+		GPUCMD_AddMaskedWrite(GPUREG_START_DRAW_FUNC0, 1, 1);
+		C3Di_STATS_DRAW(1, 0, ranges[i*2+1]);
+	}
+
+	// Disable triangle element drawing mode if necessary
+	if (primitive == GPU_TRIANGLES)
+	{
+		GPUCMD_AddMaskedWrite(GPUREG_GEOSTAGE_CONFIG, 2, 0);
+		GPUCMD_AddMaskedWrite(GPUREG_GEOSTAGE_CONFIG2, 2, 0);
+	}
+	// Clear the post-vertex cache
+	GPUCMD_AddWrite(GPUREG_VTX_FUNC, 1);
+	GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 0x8, 0);
+	GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 0x8, 0);
+	C3Di_STATS_ADD(C3D_STAT_DRAW);
+
+	ctx->flags |= C3DiF_DrawUsed;
+}
@@ -1,4 +1,8 @@
 #include "internal.h"
+#include <stdlib.h>
+#if defined(__ARM_FEATURE_SIMD32) && defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#endif
 
 void FogLut_FromArray(C3D_FogLut* lut, const float data[256])
 {
@@ -43,6 +47,96 @@ void FogLut_Exp(C3D_FogLut* lut, float density, float gradient, float near, floa
 	FogLut_FromArray(lut, data);
 }
 
+// Keyframes are stored with the value in the upper halfword and the signed difference
+// in the lower halfword, so that both can be interpolated with a single SIMD operation.
+static inline u32 C3Di_FogKeyUnpack(u32 data)
+{
+	s32 diff = (s32)(data << 19) >> 19;
+	return (diff & 0xFFFF) | ((data >> 13) << 16);
+}
+
+static inline u32 C3Di_FogKeyPack(u32 key)
+{
+	return (key & 0x1FFF) | ((key >> 16) << 13);
+}
+
+#if defined(__ARM_FEATURE_SIMD32) && defined(__ARM_FEATURE_DSP)
+static inline u32 C3Di_FogKeyLerp(u32 a, u32 b, s32 w)
+{
+	int16x2_t d = __ssub16(b, a);
+	s32 lo = __smulbb(d, w) >> 8;
+	s32 hi = __smultb(d, w) >> 8;
+	return __sadd16(a, (lo & 0xFFFF) | ((u32)hi << 16));
+}
+#else
+static inline u32 C3Di_FogKeyLerp(u32 a, u32 b, s32 w)
+{
+	s32 lo = (s16)a + ((((s16)b - (s16)a) * w) >> 8);
+	s32 hi = ((s32)a >> 16) + (((((s32)b >> 16) - ((s32)a >> 16)) * w) >> 8);
+	return (lo & 0xFFFF) | ((u32)hi << 16);
+}
+#endif
+
+bool FogAnim_Init(C3D_FogAnim* anim, const C3D_FogLut* keys, int numKeys)
+{
+	int i, j;
+	if (numKeys < 1)
+		return false;
+
+	anim->keys = (u32*)malloc(numKeys*128*sizeof(u32));
+	if (!anim->keys)
+		return false;
+
+	for (i = 0; i < numKeys; i ++)
+		for (j = 0; j < 128; j ++)
+			anim->keys[i*128+j] = C3Di_FogKeyUnpack(keys[i].data[j]);
+
+	anim->numKeys = numKeys;
+	anim->curPos = 0;
+	memcpy(anim->lut.data, keys[0].data, sizeof(anim->lut.data));
+	return true;
+}
+
+void FogAnim_Free(C3D_FogAnim* anim)
+{
+	free(anim->keys);
+	anim->keys = NULL;
+	anim->numKeys = 0;
+}
+
+bool FogAnim_Update(C3D_FogAnim* anim, float pos)
+{
+	int i;
+
+	// Position in 1/256ths of a keyframe
+	s32 ipos = (s32)(pos*256.0f + 0.5f);
+	if (ipos < 0) ipos = 0;
+	else if (ipos > (anim->numKeys-1)*256) ipos = (anim->numKeys-1)*256;
+	if (ipos == anim->curPos)
+		return false;
+	anim->curPos = ipos;
+
+	s32 w = ipos & 0xFF;
+	const u32* a = &anim->keys[(ipos >> 8)*128];
+	const u32* b = w ? (a + 128) : a;
+	u32 changed = 0;
+
+	for (i = 0; i < 128; i ++)
+	{
+		u32 data = C3Di_FogKeyPack(C3Di_FogKeyLerp(a[i], b[i], w));
+		changed |= data ^ anim->lut.data[i];
+		anim->lut.data[i] = data;
+	}
+
+	if (!changed)
+		return false;
+
+	C3D_Context* ctx = C3Di_GetContext();
+	if ((ctx->flags & C3DiF_Active) && ctx->fogLut == &anim->lut)
+		ctx->flags |= C3DiF_FogLut;
+	return true;
+}
+
 void C3D_FogGasMode(GPU_FOGMODE fogMode, GPU_GASMODE gasMode, bool zFlip)
 {
 	C3D_Context* ctx = C3Di_GetContext();
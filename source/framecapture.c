@@ -0,0 +1,71 @@
+#include "internal.h"
+#include <c3d/renderqueue.h>
+#include <c3d/capture.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char* capturePath;
+static bool capturing;
+static C3D_Capture capture;
+
+static const void* C3Di_CaptureMemory(u32 paddr, u32 size, C3D_UNUSED void* user)
+{
+	extern u32 __ctru_linear_heap;
+	extern u32 __ctru_linear_heap_size;
+
+	// The linear heap is physically contiguous, so a single offset maps it back
+	u32 linearPa = osConvertVirtToPhys((void*)__ctru_linear_heap);
+	if (paddr >= linearPa && size <= __ctru_linear_heap_size && paddr - linearPa <= __ctru_linear_heap_size - size)
+		return (const void*)(__ctru_linear_heap + (paddr - linearPa));
+	if (paddr >= OS_VRAM_PADDR && size <= OS_VRAM_SIZE && paddr - OS_VRAM_PADDR <= OS_VRAM_SIZE - size)
+		return (const void*)(OS_VRAM_VADDR + (paddr - OS_VRAM_PADDR));
+	return NULL;
+}
+
+void C3Di_CaptureFrameBegin(void)
+{
+	if (!capturePath || capturing)
+		return;
+	capturing = true;
+	C3Di_DirtyAll(C3Di_GetContext());
+}
+
+void C3Di_CaptureList(u32* cmdBuf, u32 cmdBufSize)
+{
+	if (!capturing)
+		return;
+
+	// Snapshot what the list reads before the application moves on and rewrites it for the next one
+	if (!C3D_CaptureAddList(&capture, cmdBuf, cmdBufSize) || !C3D_CaptureAddMemory(&capture, C3Di_CaptureMemory, NULL))
+		C3Di_CaptureExit(); // Out of memory, give up on this capture
+}
+
+void C3Di_CaptureFrameEnd(void)
+{
+	if (!capturing)
+		return;
+
+	// Every list has been snapshotted already, memory that differs now was rewritten within the frame
+	if (capture.numLists)
+	{
+		C3D_CaptureMarkRewritten(&capture, C3Di_CaptureMemory, NULL);
+		C3D_CaptureSave(&capture, capturePath);
+	}
+	C3Di_CaptureExit();
+}
+
+void C3Di_CaptureExit(void)
+{
+	C3D_CaptureFree(&capture);
+	free(capturePath);
+	capturePath = NULL;
+	capturing = false;
+}
+
+bool C3D_FrameCapture(const char* path)
+{
+	if (capturePath)
+		return false;
+	capturePath = strdup(path);
+	return capturePath != NULL;
+}
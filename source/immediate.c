@@ -1,8 +1,14 @@
 #include "internal.h"
 
+#ifdef C3D_STATS
+// Attributes sent since C3D_ImmDrawBegin, and where they start in the command buffer
+static u32 immAttribs, immStatsStart;
+#endif
+
 void C3D_ImmDrawBegin(GPU_Primitive_t primitive)
 {
 	C3Di_UpdateContext();
+	C3Di_STATS_MARK();
 
 	// Set primitive type
 	GPUCMD_AddMaskedWrite(GPUREG_PRIMITIVE_CONFIG, 2, primitive);
@@ -16,6 +22,12 @@ void C3D_ImmDrawBegin(GPU_Primitive_t primitive)
 	GPUCMD_AddMaskedWrite(GPUREG_START_DRAW_FUNC0, 1, 0);
 	// Begin immediate-mode vertex submission
 	GPUCMD_AddWrite(GPUREG_FIXEDATTRIB_INDEX, 0xF);
+	C3Di_STATS_ADD(C3D_STAT_DRAW);
+	C3Di_STATS_DRAW(1, 0, 0);
+#ifdef C3D_STATS
+	immAttribs = 0;
+	immStatsStart = gpuCmdBufOffset;
+#endif
 }
 
 static inline void write24(u8* p, u32 val)
@@ -52,16 +64,27 @@ void C3D_ImmSendAttrib(float x, float y, float z, float w)
 
 	// Send the attribute
 	GPUCMD_AddIncrementalWrites(GPUREG_FIXEDATTRIB_DATA0, param.packed, 3);
+#ifdef C3D_STATS
+	immAttribs ++;
+#endif
 }
 
 void C3D_ImmDrawEnd(void)
 {
+#ifdef C3D_STATS
+	// A vertex is one attribute for each shader input
+	u32 numInputs = C3Di_GetContext()->attrInfo.attrCount;
+	C3Di_Stats.words[C3D_STAT_DRAW] += gpuCmdBufOffset - immStatsStart;
+	C3Di_STATS_DRAW(0, immAttribs / (numInputs ? numInputs : 1), 0);
+#endif
+	C3Di_STATS_MARK();
 	// Go back to configuration mode
 	GPUCMD_AddMaskedWrite(GPUREG_START_DRAW_FUNC0, 1, 1);
 	// Disable vertex submission mode
 	GPUCMD_AddMaskedWrite(GPUREG_GEOSTAGE_CONFIG2, 1, 0);
 	// Clear the post-vertex cache
 	GPUCMD_AddWrite(GPUREG_VTX_FUNC, 1);
+	C3Di_STATS_ADD(C3D_STAT_DRAW);
 
 	C3Di_GetContext()->flags |= C3DiF_DrawUsed;
 }
@@ -6,6 +6,8 @@
 #include <c3d/framebuffer.h>
 #include <c3d/texenv.h>
 #include <c3d/fog.h>
+#include <c3d/profile.h>
+#include <c3d/stats.h>
 
 #define C3D_UNUSED __attribute__((unused))
 
@@ -47,6 +49,9 @@ typedef struct
 	u32 texShadow;
 	C3D_Tex* tex[3];
 	C3D_TexEnv texEnv[6];
+	C3D_TexEnv texEnvHw[6]; // Canonical setups last sent to the GPU
+	u32 texEnvHash[6];
+	u8 texEnvHwValid;
 
 	u32 texEnvBuf, texEnvBufClr;
 	u32 fogClr;
@@ -109,6 +114,7 @@ static inline bool C3Di_TexIs2D(C3D_Tex* tex)
 }
 
 void C3Di_UpdateContext(void);
+void C3Di_DirtyAll(C3D_Context* ctx);
 void C3Di_AttrInfoBind(C3D_AttrInfo* info);
 void C3Di_BufInfoBind(C3D_BufInfo* info);
 void C3Di_FrameBufBind(C3D_FrameBuf* fb);
@@ -116,10 +122,57 @@ void C3Di_TexEnvBind(int id, C3D_TexEnv* env);
 void C3Di_SetTex(int unit, C3D_Tex* tex);
 void C3Di_EffectBind(C3D_Effect* effect);
 
-void C3Di_LightMtlBlend(C3D_Light* light);
+bool C3Di_LightMtlBlend(C3D_Light* light);
+void C3Di_LightMtlCacheClear(C3D_Light* light);
 
 void C3Di_DirtyUniforms(GPU_SHADER_TYPE type);
 void C3Di_LoadShaderUniforms(shaderInstance_s* si);
 void C3Di_ClearShaderUniforms(GPU_SHADER_TYPE type);
 
 bool C3Di_SplitFrame(u32** pBuf, u32* pSize);
+
+#ifdef C3D_STATS
+extern C3D_Stats C3Di_Stats;
+void C3Di_StatsFrameEnd(void);
+
+// Command words are measured as gpuCmdBufOffset deltas, so a mark must not span a command list split
+#define C3Di_STATS_MARK() u32 C3Di_statsMark = gpuCmdBufOffset
+#define C3Di_STATS_ADD(_cat) do \
+{ \
+	if (gpuCmdBufOffset != C3Di_statsMark) \
+	{ \
+		C3Di_Stats.words[_cat] += gpuCmdBufOffset - C3Di_statsMark; \
+		C3Di_Stats.changes[_cat] ++; \
+		C3Di_statsMark = gpuCmdBufOffset; \
+	} \
+} while (0)
+#define C3Di_STATS_DRAW(_draws, _vertices, _indices) do \
+{ \
+	C3Di_Stats.draws += (_draws); \
+	C3Di_Stats.vertices += (_vertices); \
+	C3Di_Stats.indices += (_indices); \
+} while (0)
+#else
+#define C3Di_STATS_MARK() do { } while (0)
+#define C3Di_STATS_ADD(_cat) do { } while (0)
+#define C3Di_STATS_DRAW(_draws, _vertices, _indices) do { } while (0)
+#endif
+
+void C3Di_CaptureFrameBegin(void);
+void C3Di_CaptureList(u32* cmdBuf, u32 cmdBufSize);
+void C3Di_CaptureFrameEnd(void);
+void C3Di_CaptureExit(void);
+
+void C3Di_RenderQueueWaitDone(void);
+u32 C3Di_QueueDisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags);
+
+void C3Di_OverdrawFrameBegin(void);
+void C3Di_OverdrawDraw(C3D_Context* ctx);
+C3D_Effect* C3Di_OverdrawEffect(C3D_Effect* e);
+C3D_TexEnv* C3Di_OverdrawTexEnv(int id, C3D_TexEnv* env);
+u32 C3Di_OverdrawTexEnvBuf(u32 texEnvBuf);
+
+void C3Di_TimingSubmit(void);
+void C3Di_TimingFrameEnd(void);
+
+void C3Di_ShadowPoolExit(void);
@@ -1,10 +1,9 @@
 #include "internal.h"
 
-void C3Di_LightMtlBlend(C3D_Light* light)
+static void C3Di_LightMtlCalc(C3D_Light* light, C3D_LightMatConf* conf)
 {
 	int i;
 	C3D_Material* mtl = &light->parent->material;
-	C3D_LightMatConf* conf = &light->conf.material;
 	memset(conf, 0, sizeof(*conf));
 
 	for (i = 0; i < 3; i ++)
@@ -16,6 +15,54 @@ void C3Di_LightMtlBlend(C3D_Light* light)
 	}
 }
 
+bool C3Di_LightMtlBlend(C3D_Light* light)
+{
+	int i;
+	u32 tag = light->parent->mtlTag;
+	C3D_LightMatCache* entry = NULL;
+	C3D_LightMatConf conf;
+
+	if (tag)
+	{
+		for (i = 0; i < C3D_MTLCACHE_SIZE; i ++)
+		{
+			if (light->mtlCache[i].mtlTag == tag)
+			{
+				entry = &light->mtlCache[i];
+				break;
+			}
+		}
+	}
+
+	if (entry)
+		conf = entry->conf;
+	else
+	{
+		C3Di_LightMtlCalc(light, &conf);
+		if (tag)
+		{
+			entry = &light->mtlCache[light->mtlCacheNext];
+			light->mtlCacheNext = (light->mtlCacheNext + 1) % C3D_MTLCACHE_SIZE;
+			entry->mtlTag = tag;
+			entry->conf = conf;
+		}
+	}
+
+	// Only report a change (and thus a register upload) if the colors differ
+	if (memcmp(&light->conf.material, &conf, sizeof(conf)) == 0)
+		return false;
+
+	light->conf.material = conf;
+	return true;
+}
+
+void C3Di_LightMtlCacheClear(C3D_Light* light)
+{
+	int i;
+	for (i = 0; i < C3D_MTLCACHE_SIZE; i ++)
+		light->mtlCache[i].mtlTag = 0;
+}
+
 int C3D_LightInit(C3D_Light* light, C3D_LightEnv* env)
 {
 	int i;
@@ -76,6 +123,7 @@ void C3D_LightAmbient(C3D_Light* light, float r, float g, float b)
 	light->ambient[1] = g;
 	light->ambient[2] = r;
 	light->flags |= C3DF_Light_MatDirty;
+	C3Di_LightMtlCacheClear(light);
 }
 
 void C3D_LightDiffuse(C3D_Light* light, float r, float g, float b)
@@ -84,6 +132,7 @@ void C3D_LightDiffuse(C3D_Light* light, float r, float g, float b)
 	light->diffuse[1] = g;
 	light->diffuse[2] = r;
 	light->flags |= C3DF_Light_MatDirty;
+	C3Di_LightMtlCacheClear(light);
 }
 
 void C3D_LightSpecular0(C3D_Light* light, float r, float g, float b)
@@ -92,6 +141,7 @@ void C3D_LightSpecular0(C3D_Light* light, float r, float g, float b)
 	light->specular0[1] = g;
 	light->specular0[2] = r;
 	light->flags |= C3DF_Light_MatDirty;
+	C3Di_LightMtlCacheClear(light);
 }
 
 void C3D_LightSpecular1(C3D_Light* light, float r, float g, float b)
@@ -100,6 +150,7 @@ void C3D_LightSpecular1(C3D_Light* light, float r, float g, float b)
 	light->specular1[1] = g;
 	light->specular1[2] = r;
 	light->flags |= C3DF_Light_MatDirty;
+	C3Di_LightMtlCacheClear(light);
 }
 
 void C3D_LightPosition(C3D_Light* light, C3D_FVec* pos)
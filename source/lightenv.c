@@ -106,9 +106,9 @@ void C3Di_LightEnvUpdate(C3D_LightEnv* env)
 
 		if (light->flags & C3DF_Light_MatDirty)
 		{
-			C3Di_LightMtlBlend(light);
+			if (C3Di_LightMtlBlend(light))
+				light->flags |= C3DF_Light_Dirty;
 			light->flags &= ~C3DF_Light_MatDirty;
-			light->flags |= C3DF_Light_Dirty;
 		}
 
 		if (light->flags & C3DF_Light_Dirty)
@@ -176,9 +176,37 @@ void C3D_LightEnvBind(C3D_LightEnv* env)
 	ctx->lightEnv = env;
 }
 
+static u32 C3Di_LightEnvMtlTag(C3D_LightEnv* env, const C3D_Material* mtl)
+{
+	int i;
+	for (i = 0; i < C3D_MTLCACHE_SIZE; i ++)
+		if (env->mtlCacheTags[i] && memcmp(&env->mtlCache[i], mtl, sizeof(*mtl)) == 0)
+			return env->mtlCacheTags[i];
+
+	if (!++env->mtlTagNext)
+	{
+		// Tags wrapped around, so forget every blended color cached by the lights
+		env->mtlTagNext = 1;
+		memset(env->mtlCacheTags, 0, sizeof(env->mtlCacheTags));
+		for (i = 0; i < 8; i ++)
+			if (env->lights[i])
+				C3Di_LightMtlCacheClear(env->lights[i]);
+	}
+
+	i = env->mtlCacheNext;
+	env->mtlCacheNext = (i + 1) % C3D_MTLCACHE_SIZE;
+	env->mtlCacheTags[i] = env->mtlTagNext;
+	memcpy(&env->mtlCache[i], mtl, sizeof(*mtl));
+	return env->mtlTagNext;
+}
+
 void C3D_LightEnvMaterial(C3D_LightEnv* env, const C3D_Material* mtl)
 {
 	int i;
+	if (env->mtlTag && memcmp(&env->material, mtl, sizeof(*mtl)) == 0)
+		return;
+
+	env->mtlTag = C3Di_LightEnvMtlTag(env, mtl);
 	memcpy(&env->material, mtl, sizeof(*mtl));
 	env->flags |= C3DF_LightEnv_MtlDirty;
 	for (i = 0; i < 8; i ++)
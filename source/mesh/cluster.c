@@ -0,0 +1,344 @@
+#include <c3d/mesh.h>
+#include <c3d/profile.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Minimum cosine between a triangle's normal and the running cluster axis
+#define CLUSTER_CONE_LIMIT 0.97f
+
+// Number of clusters tested per batch by the cull pass
+#define CULL_BLOCK 32
+
+static inline const float* vertexPos(const float* positions, u32 stride, u32 v)
+{
+	return (const float*)((const u8*)positions + v*stride);
+}
+
+static void triNormal(float* n, const float* a, const float* b, const float* c)
+{
+	float e1[3] = { b[0]-a[0], b[1]-a[1], b[2]-a[2] };
+	float e2[3] = { c[0]-a[0], c[1]-a[1], c[2]-a[2] };
+	n[0] = e1[1]*e2[2] - e1[2]*e2[1];
+	n[1] = e1[2]*e2[0] - e1[0]*e2[2];
+	n[2] = e1[0]*e2[1] - e1[1]*e2[0];
+
+	float len = sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+	if (len > 0.0f)
+	{
+		n[0] /= len;
+		n[1] /= len;
+		n[2] /= len;
+	}
+}
+
+static bool allocClusters(C3D_MeshClusters* out, u32 count)
+{
+	// One block holds every array
+	u8* mem = (u8*)malloc(count*(2*sizeof(u32) + 9*sizeof(float)) + 1);
+	if (!mem)
+		return false;
+
+	out->count      = count;
+	out->first      = (u32*)mem;   mem += count*sizeof(u32);
+	out->numIndices = (u32*)mem;   mem += count*sizeof(u32);
+	out->centerX    = (float*)mem; mem += count*sizeof(float);
+	out->centerY    = (float*)mem; mem += count*sizeof(float);
+	out->centerZ    = (float*)mem; mem += count*sizeof(float);
+	out->radius     = (float*)mem; mem += count*sizeof(float);
+	out->axisX      = (float*)mem; mem += count*sizeof(float);
+	out->axisY      = (float*)mem; mem += count*sizeof(float);
+	out->axisZ      = (float*)mem; mem += count*sizeof(float);
+	out->coneSin    = (float*)mem; mem += count*sizeof(float);
+	out->coneCos    = (float*)mem;
+	return true;
+}
+
+void Mesh_FreeClusters(C3D_MeshClusters* clusters)
+{
+	free(clusters->first);
+	memset(clusters, 0, sizeof(*clusters));
+}
+
+static void clusterBounds(C3D_MeshClusters* out, u32 id, const u16* indices, const float* normals, const float* positions, u32 stride)
+{
+	u32 i, first = out->first[id], count = out->numIndices[id];
+	float c[3] = { 0.0f, 0.0f, 0.0f };
+	float axis[3] = { 0.0f, 0.0f, 0.0f };
+	float radius = 0.0f, minDot = 1.0f;
+
+	for (i = 0; i < count; i ++)
+	{
+		const float* p = vertexPos(positions, stride, indices[first+i]);
+		c[0] += p[0];
+		c[1] += p[1];
+		c[2] += p[2];
+	}
+	c[0] /= count;
+	c[1] /= count;
+	c[2] /= count;
+
+	for (i = 0; i < count; i ++)
+	{
+		const float* p = vertexPos(positions, stride, indices[first+i]);
+		float dx = p[0]-c[0], dy = p[1]-c[1], dz = p[2]-c[2];
+		float d = sqrtf(dx*dx + dy*dy + dz*dz);
+		if (d > radius)
+			radius = d;
+	}
+
+	for (i = 0; i < count; i += 3)
+	{
+		const float* n = &normals[(first+i)];
+		axis[0] += n[0];
+		axis[1] += n[1];
+		axis[2] += n[2];
+	}
+	float len = sqrtf(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+	if (len > 0.0f)
+	{
+		axis[0] /= len;
+		axis[1] /= len;
+		axis[2] /= len;
+		for (i = 0; i < count; i += 3)
+		{
+			const float* n = &normals[(first+i)];
+			float d = n[0]*axis[0] + n[1]*axis[1] + n[2]*axis[2];
+			if (d < minDot)
+				minDot = d;
+		}
+	} else
+		minDot = -1.0f;
+
+	out->centerX[id] = c[0];
+	out->centerY[id] = c[1];
+	out->centerZ[id] = c[2];
+	out->radius[id]  = radius;
+	out->axisX[id]   = axis[0];
+	out->axisY[id]   = axis[1];
+	out->axisZ[id]   = axis[2];
+
+	// A spread of 90 degrees or more can never be back-facing as a whole
+	if (minDot <= 0.0f)
+	{
+		out->coneSin[id] = 1.0f;
+		out->coneCos[id] = 0.0f;
+	} else
+	{
+		out->coneSin[id] = sqrtf(1.0f - minDot*minDot);
+		out->coneCos[id] = minDot;
+	}
+}
+
+bool Mesh_BuildClusters(C3D_MeshClusters* out, u16* indices, u32 numIndices, const float* positions, u32 stride, u32 numVertices, u32 maxTriangles)
+{
+	u32 i, j, k, numTris = numIndices / 3;
+	u32 numClusters = 0, outTris = 0;
+	bool ok = false;
+	C3D_PROFILE_SCOPE("Mesh_BuildClusters");
+
+	memset(out, 0, sizeof(*out));
+	if (!maxTriangles)
+		maxTriangles = C3D_MESH_CLUSTER_MAX_TRIS;
+	for (i = 0; i < numTris*3; i ++)
+		if (indices[i] >= numVertices)
+			return false;
+
+	float* normals  = (float*)malloc(numTris*3*sizeof(float) + 1);
+	u32* offsets    = (u32*)calloc(numVertices+1, sizeof(u32));
+	u32* adjacency  = (u32*)malloc(numTris*3*sizeof(u32) + 1);
+	u32* fill       = (u32*)calloc(numVertices+1, sizeof(u32));
+	u32* clusterOf  = (u32*)malloc(numTris*sizeof(u32) + 1);
+	u32* queued     = (u32*)malloc(numTris*sizeof(u32) + 1);
+	u32* queue      = (u32*)malloc(numTris*sizeof(u32) + 1);
+	u32* order      = (u32*)malloc(numTris*sizeof(u32) + 1);
+	u32* clusterEnd = (u32*)malloc(numTris*sizeof(u32) + 1);
+	u16* sorted     = (u16*)malloc(numTris*3*sizeof(u16) + 1);
+	float* sortedN  = (float*)malloc(numTris*3*sizeof(float) + 1);
+	if (!normals || !offsets || !adjacency || !fill || !clusterOf || !queued || !queue || !order || !clusterEnd || !sorted || !sortedN)
+		goto _fail;
+
+	for (i = 0; i < numTris; i ++)
+	{
+		triNormal(&normals[i*3],
+			vertexPos(positions, stride, indices[i*3+0]),
+			vertexPos(positions, stride, indices[i*3+1]),
+			vertexPos(positions, stride, indices[i*3+2]));
+		clusterOf[i] = ~0U;
+		queued[i] = ~0U;
+	}
+
+	// Triangles sharing a vertex are neighbors
+	for (i = 0; i < numTris*3; i ++)
+		offsets[indices[i]+1] ++;
+	for (i = 0; i < numVertices; i ++)
+		offsets[i+1] += offsets[i];
+	for (i = 0; i < numTris*3; i ++)
+		adjacency[offsets[indices[i]] + fill[indices[i]]++] = i / 3;
+
+	// Grow clusters from seeds in input order, only accepting triangles facing roughly the same way
+	for (i = 0; i < numTris; i ++)
+	{
+		if (clusterOf[i] != ~0U)
+			continue;
+
+		u32 head = 0, tail = 0, size = 0;
+		float axis[3] = { 0.0f, 0.0f, 0.0f };
+		queue[tail++] = i;
+		queued[i] = numClusters;
+
+		while (head < tail && size < maxTriangles)
+		{
+			u32 t = queue[head++];
+			const float* n = &normals[t*3];
+			if (size)
+			{
+				float len = sqrtf(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+				if (n[0]*axis[0] + n[1]*axis[1] + n[2]*axis[2] < CLUSTER_CONE_LIMIT*len)
+					continue;
+			}
+
+			clusterOf[t] = numClusters;
+			order[outTris++] = t;
+			size ++;
+			axis[0] += n[0];
+			axis[1] += n[1];
+			axis[2] += n[2];
+
+			for (j = 0; j < 3; j ++)
+			{
+				u32 v = indices[t*3+j];
+				for (k = offsets[v]; k < offsets[v+1]; k ++)
+				{
+					u32 u = adjacency[k];
+					if (clusterOf[u] == ~0U && queued[u] != numClusters)
+					{
+						queued[u] = numClusters;
+						queue[tail++] = u;
+					}
+				}
+			}
+		}
+		clusterEnd[numClusters++] = outTris;
+	}
+
+	if (!allocClusters(out, numClusters))
+		goto _fail;
+
+	// Store the normal of each triangle next to its first index, so bounds can walk the new order
+	for (i = 0; i < numTris; i ++)
+	{
+		u32 t = order[i];
+		memcpy(&sorted[i*3], &indices[t*3], 3*sizeof(u16));
+		memcpy(&sortedN[i*3], &normals[t*3], 3*sizeof(float));
+	}
+	memcpy(indices, sorted, numTris*3*sizeof(u16));
+
+	for (i = 0; i < numClusters; i ++)
+	{
+		u32 start = i ? clusterEnd[i-1] : 0;
+		out->first[i] = start*3;
+		out->numIndices[i] = (clusterEnd[i] - start)*3;
+		clusterBounds(out, i, indices, sortedN, positions, stride);
+	}
+	ok = true;
+
+_fail:
+	free(normals);
+	free(offsets);
+	free(adjacency);
+	free(fill);
+	free(clusterOf);
+	free(queued);
+	free(queue);
+	free(order);
+	free(clusterEnd);
+	free(sorted);
+	free(sortedN);
+	return ok;
+}
+
+void Mesh_FrustumPlanes(C3D_FVec planes[6], const C3D_Mtx* clip)
+{
+	int i;
+	const C3D_FVec* r = clip->r;
+
+	// Points inside satisfy -w <= x <= w, -w <= y <= w and -w <= z <= 0
+	for (i = 0; i < 2; i ++)
+	{
+		planes[i*2+0] = (C3D_FVec){ .x = r[3].x+r[i].x, .y = r[3].y+r[i].y, .z = r[3].z+r[i].z, .w = r[3].w+r[i].w };
+		planes[i*2+1] = (C3D_FVec){ .x = r[3].x-r[i].x, .y = r[3].y-r[i].y, .z = r[3].z-r[i].z, .w = r[3].w-r[i].w };
+	}
+	planes[4] = (C3D_FVec){ .x = r[3].x+r[2].x, .y = r[3].y+r[2].y, .z = r[3].z+r[2].z, .w = r[3].w+r[2].w };
+	planes[5] = (C3D_FVec){ .x = -r[2].x, .y = -r[2].y, .z = -r[2].z, .w = -r[2].w };
+
+	for (i = 0; i < 6; i ++)
+	{
+		float len = sqrtf(planes[i].x*planes[i].x + planes[i].y*planes[i].y + planes[i].z*planes[i].z);
+		if (len > 0.0f)
+		{
+			planes[i].x /= len;
+			planes[i].y /= len;
+			planes[i].z /= len;
+			planes[i].w /= len;
+		}
+	}
+}
+
+u32 Mesh_CullClusters(u32* ranges, const C3D_MeshClusters* c, const C3D_FVec* planes, C3D_FVec eye)
+{
+	u8 visible[CULL_BLOCK];
+	u32 i, j, k, numRanges = 0;
+
+	for (i = 0; i < c->count; i += CULL_BLOCK)
+	{
+		u32 n = c->count-i < CULL_BLOCK ? c->count-i : CULL_BLOCK;
+		const float* cx = &c->centerX[i];
+		const float* cy = &c->centerY[i];
+		const float* cz = &c->centerZ[i];
+		const float* cr = &c->radius[i];
+
+		// Back-facing if the view direction stays within 90 degrees of every normal for every
+		// point of the bounding sphere: angle(axis, view) + cone + sphere half-angle <= 90 degrees
+		for (j = 0; j < n; j ++)
+		{
+			float dx = cx[j]-eye.x, dy = cy[j]-eye.y, dz = cz[j]-eye.z;
+			float d = sqrtf(dx*dx + dy*dy + dz*dz);
+			float sinB = d > cr[j] ? cr[j]/d : 1.0f;
+			float cosB = sqrtf(1.0f - sinB*sinB);
+			float sinA = c->coneSin[i+j], cosA = c->coneCos[i+j];
+			float sinAB = sinA*cosB + cosA*sinB;
+			float cosAB = cosA*cosB - sinA*sinB;
+			float dir = c->axisX[i+j]*dx + c->axisY[i+j]*dy + c->axisZ[i+j]*dz;
+			visible[j] = !(cosAB > 0.0f && dir >= sinAB*d);
+		}
+
+		if (planes)
+		{
+			for (k = 0; k < 6; k ++)
+			{
+				C3D_FVec p = planes[k];
+				for (j = 0; j < n; j ++)
+					visible[j] &= p.x*cx[j] + p.y*cy[j] + p.z*cz[j] + p.w >= -cr[j];
+			}
+		}
+
+		// Compact, merging clusters that are adjacent in the index buffer
+		for (j = 0; j < n; j ++)
+		{
+			if (!visible[j])
+				continue;
+
+			u32 first = c->first[i+j], count = c->numIndices[i+j];
+			if (numRanges && ranges[numRanges*2-2] + ranges[numRanges*2-1] == first)
+				ranges[numRanges*2-1] += count;
+			else
+			{
+				ranges[numRanges*2+0] = first;
+				ranges[numRanges*2+1] = count;
+				numRanges ++;
+			}
+		}
+	}
+	return numRanges;
+}
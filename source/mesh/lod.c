@@ -0,0 +1,383 @@
+#include <c3d/mesh.h>
+#include <c3d/profile.h>
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Weight of the planes that keep open borders in place, relative to the surface planes
+#define BORDER_WEIGHT 10.0f
+
+// A level is only kept if it removes at least this fraction of the previous one
+#define LOD_MIN_REDUCTION 0.1f
+
+// Symmetric 4x4 error quadric: xx xy xz xw yy yz yw zz zw ww
+typedef struct
+{
+	float a[10];
+	float w; // Total weight of the planes, used to turn the error into a distance
+} Quadric;
+
+typedef struct
+{
+	float cost;
+	u16 from, to;
+} Collapse;
+
+// Sort key carrying its own position, so the comparator needs no shared state
+typedef struct
+{
+	float pos[3];
+	u16 vertex;
+} PositionKey;
+
+static inline const float* vertexPos(const float* positions, u32 stride, u32 v)
+{
+	return (const float*)((const u8*)positions + v*stride);
+}
+
+static void quadricAddPlane(Quadric* q, float a, float b, float c, float d, float w)
+{
+	q->a[0] += w*a*a; q->a[1] += w*a*b; q->a[2] += w*a*c; q->a[3] += w*a*d;
+	q->a[4] += w*b*b; q->a[5] += w*b*c; q->a[6] += w*b*d;
+	q->a[7] += w*c*c; q->a[8] += w*c*d;
+	q->a[9] += w*d*d;
+}
+
+static void quadricAdd(Quadric* q, const Quadric* r)
+{
+	int i;
+	for (i = 0; i < 10; i ++)
+		q->a[i] += r->a[i];
+	q->w += r->w;
+}
+
+static float quadricEval(const Quadric* q, const float* p)
+{
+	float x = p[0], y = p[1], z = p[2];
+	const float* a = q->a;
+	float e = a[0]*x*x + 2.0f*a[1]*x*y + 2.0f*a[2]*x*z + 2.0f*a[3]*x
+	        + a[4]*y*y + 2.0f*a[5]*y*z + 2.0f*a[6]*y
+	        + a[7]*z*z + 2.0f*a[8]*z
+	        + a[9];
+	return e > 0.0f ? e : 0.0f;
+}
+
+static void cross(float* n, const float* a, const float* b, const float* c)
+{
+	float e1[3] = { b[0]-a[0], b[1]-a[1], b[2]-a[2] };
+	float e2[3] = { c[0]-a[0], c[1]-a[1], c[2]-a[2] };
+	n[0] = e1[1]*e2[2] - e1[2]*e2[1];
+	n[1] = e1[2]*e2[0] - e1[0]*e2[2];
+	n[2] = e1[0]*e2[1] - e1[1]*e2[0];
+}
+
+static int collapseCompare(const void* a, const void* b)
+{
+	float ca = ((const Collapse*)a)->cost, cb = ((const Collapse*)b)->cost;
+	return ca < cb ? -1 : ca > cb ? 1 : 0;
+}
+
+static int positionCompare(const void* a, const void* b)
+{
+	const float* pa = ((const PositionKey*)a)->pos;
+	const float* pb = ((const PositionKey*)b)->pos;
+	int i;
+	for (i = 0; i < 3; i ++)
+		if (pa[i] != pb[i])
+			return pa[i] < pb[i] ? -1 : 1;
+	return 0;
+}
+
+static void buildAdjacency(u32* offsets, u32* adjacency, const u16* indices, u32 numIndices, u32 numVertices)
+{
+	u32 i;
+	memset(offsets, 0, (numVertices+1)*sizeof(u32));
+	for (i = 0; i < numIndices; i ++)
+		offsets[indices[i]+1] ++;
+	for (i = 0; i < numVertices; i ++)
+		offsets[i+1] += offsets[i];
+	for (i = 0; i < numIndices; i ++)
+		adjacency[offsets[indices[i]]++] = i / 3;
+	// Filling shifted every offset by one bucket
+	for (i = numVertices; i > 0; i --)
+		offsets[i] = offsets[i-1];
+	offsets[0] = 0;
+}
+
+// Moving a vertex must not flip any of the triangles it keeps
+static bool collapseFlips(const u16* indices, const u32* offsets, const u32* adjacency, const float* positions, u32 stride, u32 from, u32 to)
+{
+	u32 i;
+	int j;
+	for (i = offsets[from]; i < offsets[from+1]; i ++)
+	{
+		const u16* t = &indices[adjacency[i]*3];
+		const float* p[3];
+		float before[3], after[3];
+		if (t[0] == to || t[1] == to || t[2] == to)
+			continue;
+
+		for (j = 0; j < 3; j ++)
+			p[j] = vertexPos(positions, stride, t[j]);
+		cross(before, p[0], p[1], p[2]);
+		for (j = 0; j < 3; j ++)
+			if (t[j] == from)
+				p[j] = vertexPos(positions, stride, to);
+		cross(after, p[0], p[1], p[2]);
+		if (before[0]*after[0] + before[1]*after[1] + before[2]*after[2] <= 0.0f)
+			return true;
+	}
+	return false;
+}
+
+u32 Mesh_Simplify(u16* out, float* outError, const u16* indices, u32 numIndices, const float* positions, u32 stride, u32 numVertices, u32 targetIndices, float maxError)
+{
+	u32 i, k, n = numIndices/3*3;
+	int j;
+	float error = 0.0f, maxCost = maxError*maxError;
+	C3D_PROFILE_SCOPE("Mesh_Simplify");
+
+	memmove(out, indices, n*sizeof(u16));
+	if (outError)
+		*outError = 0.0f;
+	for (i = 0; i < n; i ++)
+		if (out[i] >= numVertices)
+			return n;
+
+	Quadric* quadrics  = (Quadric*)calloc(numVertices, sizeof(Quadric));
+	u32* offsets       = (u32*)malloc((numVertices+1)*sizeof(u32));
+	u32* adjacency     = (u32*)malloc(n*sizeof(u32) + 1);
+	Collapse* collapse = (Collapse*)malloc(n*2*sizeof(Collapse) + 1);
+	u16* remap         = (u16*)malloc(numVertices*sizeof(u16) + 1);
+	PositionKey* order = (PositionKey*)malloc(numVertices*sizeof(PositionKey) + 1);
+	u8* seam           = (u8*)calloc(numVertices+1, 1);
+	u8* touched        = (u8*)malloc(numVertices + 1);
+	if (!quadrics || !offsets || !adjacency || !collapse || !remap || !order || !seam || !touched)
+		goto _done;
+
+	// Vertices sharing a position with another one (attribute seams) stay in place so no cracks open up
+	for (i = 0; i < numVertices; i ++)
+	{
+		memcpy(order[i].pos, vertexPos(positions, stride, i), sizeof(order[i].pos));
+		order[i].vertex = i;
+	}
+	qsort(order, numVertices, sizeof(PositionKey), positionCompare);
+	for (i = 1; i < numVertices; i ++)
+		if (positionCompare(&order[i-1], &order[i]) == 0)
+			seam[order[i-1].vertex] = seam[order[i].vertex] = 1;
+
+	buildAdjacency(offsets, adjacency, out, n, numVertices);
+	for (i = 0; i < n; i += 3)
+	{
+		const float* p[3];
+		float nrm[3];
+		for (j = 0; j < 3; j ++)
+			p[j] = vertexPos(positions, stride, out[i+j]);
+		cross(nrm, p[0], p[1], p[2]);
+		float len = sqrtf(nrm[0]*nrm[0] + nrm[1]*nrm[1] + nrm[2]*nrm[2]);
+		if (len <= 0.0f)
+			continue;
+		nrm[0] /= len;
+		nrm[1] /= len;
+		nrm[2] /= len;
+
+		float area = len*0.5f, d = -(nrm[0]*p[0][0] + nrm[1]*p[0][1] + nrm[2]*p[0][2]);
+		for (j = 0; j < 3; j ++)
+		{
+			Quadric* q = &quadrics[out[i+j]];
+			quadricAddPlane(q, nrm[0], nrm[1], nrm[2], d, area);
+			q->w += area;
+		}
+
+		// Edges used by a single triangle get a perpendicular plane
+		for (j = 0; j < 3; j ++)
+		{
+			u32 a = out[i+j], b = out[i+(j+1)%3], shared = 0;
+			for (k = offsets[a]; k < offsets[a+1]; k ++)
+			{
+				const u16* t = &out[adjacency[k]*3];
+				if (t[0] == b || t[1] == b || t[2] == b)
+					shared ++;
+			}
+			if (shared != 1)
+				continue;
+
+			float e[3] = { p[(j+1)%3][0]-p[j][0], p[(j+1)%3][1]-p[j][1], p[(j+1)%3][2]-p[j][2] };
+			float bn[3] = { e[1]*nrm[2] - e[2]*nrm[1], e[2]*nrm[0] - e[0]*nrm[2], e[0]*nrm[1] - e[1]*nrm[0] };
+			float blen = sqrtf(bn[0]*bn[0] + bn[1]*bn[1] + bn[2]*bn[2]);
+			if (blen <= 0.0f)
+				continue;
+			bn[0] /= blen;
+			bn[1] /= blen;
+			bn[2] /= blen;
+			float bd = -(bn[0]*p[j][0] + bn[1]*p[j][1] + bn[2]*p[j][2]);
+			float w = BORDER_WEIGHT*(e[0]*e[0] + e[1]*e[1] + e[2]*e[2]);
+			quadricAddPlane(&quadrics[a], bn[0], bn[1], bn[2], bd, w);
+			quadricAddPlane(&quadrics[b], bn[0], bn[1], bn[2], bd, w);
+			quadrics[a].w += w;
+			quadrics[b].w += w;
+		}
+	}
+
+	// Each pass sorts every half-edge collapse by cost, then applies the cheapest ones that
+	// don't touch each other until the target is met
+	while (n > targetIndices)
+	{
+		u32 numCollapses = 0, removed = 0;
+		bool any = false;
+
+		for (i = 0; i < n; i ++)
+		{
+			u32 from = out[i], to = out[i - i%3 + (i+1)%3];
+			for (j = 0; j < 2; j ++)
+			{
+				if (!seam[from])
+				{
+					Quadric q = quadrics[from];
+					quadricAdd(&q, &quadrics[to]);
+					Collapse* c = &collapse[numCollapses++];
+					c->cost = q.w > 0.0f ? quadricEval(&q, vertexPos(positions, stride, to)) / q.w : 0.0f;
+					c->from = from;
+					c->to = to;
+				}
+				u32 tmp = from; from = to; to = tmp;
+			}
+		}
+		qsort(collapse, numCollapses, sizeof(Collapse), collapseCompare);
+
+		for (i = 0; i < numVertices; i ++)
+			remap[i] = i;
+		memset(touched, 0, numVertices);
+
+		for (i = 0; i < numCollapses && n - removed*3 > targetIndices; i ++)
+		{
+			const Collapse* c = &collapse[i];
+			if (c->cost > maxCost)
+				break;
+			if (touched[c->from] || touched[c->to])
+				continue;
+			if (collapseFlips(out, offsets, adjacency, positions, stride, c->from, c->to))
+				continue;
+
+			// Lock the whole neighborhood, its triangles are stale until the pass ends
+			for (k = offsets[c->from]; k < offsets[c->from+1]; k ++)
+			{
+				const u16* t = &out[adjacency[k]*3];
+				if (t[0] == c->to || t[1] == c->to || t[2] == c->to)
+					removed ++;
+				touched[t[0]] = touched[t[1]] = touched[t[2]] = 1;
+			}
+			remap[c->from] = c->to;
+			quadricAdd(&quadrics[c->to], &quadrics[c->from]);
+			if (c->cost > error)
+				error = c->cost;
+			any = true;
+		}
+		if (!any)
+			break;
+
+		// Apply the pass and drop the triangles that collapsed
+		u32 outPos = 0;
+		for (i = 0; i < n; i += 3)
+		{
+			u16 a = remap[out[i+0]], b = remap[out[i+1]], c = remap[out[i+2]];
+			if (a == b || b == c || c == a)
+				continue;
+			out[outPos++] = a;
+			out[outPos++] = b;
+			out[outPos++] = c;
+		}
+		n = outPos;
+		buildAdjacency(offsets, adjacency, out, n, numVertices);
+	}
+
+	if (outError)
+		*outError = sqrtf(error);
+
+_done:
+	free(quadrics);
+	free(offsets);
+	free(adjacency);
+	free(collapse);
+	free(remap);
+	free(order);
+	free(seam);
+	free(touched);
+	return n;
+}
+
+int Mesh_BuildLods(u16* out, u32 outSize, C3D_MeshLod* lods, int maxLods, const u16* indices, u32 numIndices, const float* positions, u32 stride, u32 numVertices, float ratio)
+{
+	int level;
+	u32 pos = numIndices/3*3;
+
+	if (maxLods < 1 || outSize < pos)
+		return 0;
+
+	memmove(out, indices, pos*sizeof(u16));
+	lods[0].first = 0;
+	lods[0].numIndices = pos;
+	lods[0].error = 0.0f;
+
+	// Every level is simplified from the full mesh so that its error is measured against it
+	for (level = 1; level < maxLods; level ++)
+	{
+		const C3D_MeshLod* prev = &lods[level-1];
+		u32 target = (u32)(prev->numIndices*ratio)/3*3;
+		float error;
+		if (!target || outSize - pos < numIndices)
+			break;
+
+		u32 count = Mesh_Simplify(out + pos, &error, indices, numIndices, positions, stride, numVertices, target, FLT_MAX);
+		if (!count || count > prev->numIndices*(1.0f - LOD_MIN_REDUCTION))
+			break;
+
+		lods[level].first = pos;
+		lods[level].numIndices = count;
+		lods[level].error = error > prev->error ? error : prev->error;
+		pos += count;
+	}
+	return level;
+}
+
+u32 Mesh_SelectLods(C3D_MeshLodObject* objects, u32 count, const C3D_Mtx* proj, float width, float height, float threshold, float hysteresis)
+{
+	const C3D_FVec* r = proj->r;
+	u32 i, changed = 0;
+
+	// Pixels covered by one unit at w = 1, along either screen axis
+	float sx = sqrtf(r[0].x*r[0].x + r[0].y*r[0].y + r[0].z*r[0].z)*width*0.5f;
+	float sy = sqrtf(r[1].x*r[1].x + r[1].y*r[1].y + r[1].z*r[1].z)*height*0.5f;
+	float scale = sx > sy ? sx : sy;
+	float wScale = sqrtf(r[3].x*r[3].x + r[3].y*r[3].y + r[3].z*r[3].z);
+	float coarsen = threshold*(1.0f - hysteresis);
+
+	for (i = 0; i < count; i ++)
+	{
+		C3D_MeshLodObject* o = &objects[i];
+		C3D_FVec s = o->sphere;
+		int level, cur = o->level < o->numLods ? o->level : o->numLods-1;
+
+		// Closest point of the bounding sphere
+		float w = r[3].x*s.x + r[3].y*s.y + r[3].z*s.z + r[3].w - s.w*wScale;
+		if (w <= FLT_EPSILON || o->numLods < 2)
+			level = 0;
+		else
+		{
+			float k = scale / w;
+
+			// Coarsest level within the threshold, or within the tighter bound when that means coarsening
+			for (level = 0; level+1 < o->numLods && o->lods[level+1].error*k <= threshold; level ++);
+			if (level > cur)
+				for (level = cur; level+1 < o->numLods && o->lods[level+1].error*k <= coarsen; level ++);
+		}
+
+		if (level != o->level)
+		{
+			o->level = level;
+			changed ++;
+		}
+	}
+	return changed;
+}
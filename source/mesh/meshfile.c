@@ -0,0 +1,115 @@
+#include <c3d/mesh.h>
+#include <string.h>
+
+static inline u32 alignUp(u32 x, u32 align)
+{
+	return (x + align-1) &~ (align-1);
+}
+
+static void fileOffsets(const C3D_MeshFileDesc* desc, u32* uniformOffset, u32* vertexOffset, u32* indexOffset, u32* fileSize)
+{
+	const C3D_MeshLayout* layout = desc->layout;
+	*uniformOffset = sizeof(C3D_MeshFileHeader);
+	*vertexOffset  = alignUp(*uniformOffset + layout->numAttribs*2*4*sizeof(float), 16);
+	*indexOffset   = alignUp(*vertexOffset + layout->numVertices*layout->stride, 16);
+	*fileSize      = alignUp(*indexOffset + desc->numIndices*(desc->indexType == C3D_UNSIGNED_SHORT ? 2 : 1), 16);
+}
+
+size_t Mesh_FileSize(const C3D_MeshFileDesc* desc)
+{
+	u32 uniformOffset, vertexOffset, indexOffset, fileSize;
+	fileOffsets(desc, &uniformOffset, &vertexOffset, &indexOffset, &fileSize);
+	return fileSize;
+}
+
+size_t Mesh_FileWrite(void* out, size_t outSize, const C3D_MeshFileDesc* desc)
+{
+	const C3D_MeshLayout* layout = desc->layout;
+	C3D_MeshFileHeader hdr;
+	u32 uniformOffset, vertexOffset, indexOffset, fileSize;
+	u64 permutation = 0;
+	int i, j;
+	u32 v;
+
+	fileOffsets(desc, &uniformOffset, &vertexOffset, &indexOffset, &fileSize);
+	if (outSize < fileSize || layout->numAttribs < 1)
+		return 0;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic         = C3D_MESHFILE_MAGIC;
+	hdr.version       = C3D_MESHFILE_VERSION;
+	hdr.primitive     = desc->primitive;
+	hdr.fileSize      = fileSize;
+	hdr.numVertices   = layout->numVertices;
+	hdr.numIndices    = desc->numIndices;
+	hdr.indexType     = desc->indexType;
+	hdr.indexOffset   = indexOffset;
+	hdr.uniformOffset = uniformOffset;
+	hdr.numUniforms   = layout->numAttribs*2;
+
+	// Attribute loaders, built the same way as AttrInfo_AddLoader
+	hdr.attrFlags[1] = 0xFFF << 16;
+	for (i = 0; i < layout->numAttribs; i ++)
+	{
+		const C3D_MeshAttrib* a = &layout->attribs[i];
+		u32 fmt = (((a->count-1)<<2) | (a->format&3)) << ((i&7)*4);
+		hdr.attrFlags[i < 8 ? 0 : 1] |= fmt;
+		hdr.attrFlags[1] &= ~(1U << (i+16));
+		permutation |= (u64)(a->regId < 0 ? i : a->regId) << (i*4);
+	}
+	hdr.attrFlags[1] = (hdr.attrFlags[1] &~ 0xF0000000) | ((u32)(layout->numAttribs-1) << 28);
+	hdr.attrPermutation[0] = permutation;
+	hdr.attrPermutation[1] = permutation >> 32;
+	hdr.attrCount = layout->numAttribs;
+
+	// A single interleaved buffer, built the same way as BufInfo_Add
+	permutation = 0;
+	for (i = 0; i < layout->numAttribs; i ++)
+		permutation |= (u64)i << (i*4);
+	hdr.bufCount = 1;
+	hdr.buffers[0].offset = vertexOffset;
+	hdr.buffers[0].flags[0] = permutation;
+	hdr.buffers[0].flags[1] = (permutation >> 32) | (layout->stride << 16) | ((u32)layout->numAttribs << 28);
+
+	for (i = 0; i < 3; i ++)
+	{
+		hdr.boundsMin[i] = 0.0f;
+		hdr.boundsMax[i] = 0.0f;
+	}
+	for (i = 0; i < layout->numAttribs; i ++)
+	{
+		const C3D_MeshStream* s = layout->attribs[i].src;
+		if (s->regId != desc->positionReg || !layout->numVertices)
+			continue;
+
+		for (j = 0; j < s->count && j < 3; j ++)
+		{
+			hdr.boundsMin[j] = hdr.boundsMax[j] = s->data[j];
+			for (v = 1; v < layout->numVertices; v ++)
+			{
+				float val = ((const float*)((const u8*)s->data + v*s->stride))[j];
+				if (val < hdr.boundsMin[j]) hdr.boundsMin[j] = val;
+				if (val > hdr.boundsMax[j]) hdr.boundsMax[j] = val;
+			}
+		}
+		break;
+	}
+
+	memset(out, 0, fileSize);
+	memcpy(out, &hdr, sizeof(hdr));
+
+	float* unif = (float*)((u8*)out + uniformOffset);
+	for (i = 0; i < layout->numAttribs; i ++)
+	{
+		const C3D_MeshAttrib* a = &layout->attribs[i];
+		for (j = 0; j < 4; j ++)
+		{
+			unif[a->stream*8 + j]     = a->scale.c[3-j];
+			unif[a->stream*8 + 4 + j] = a->bias.c[3-j];
+		}
+	}
+
+	memcpy((u8*)out + vertexOffset, desc->vertices, layout->numVertices*layout->stride);
+	memcpy((u8*)out + indexOffset, desc->indices, desc->numIndices*(desc->indexType == C3D_UNSIGNED_SHORT ? 2 : 1));
+	return fileSize;
+}
@@ -0,0 +1,178 @@
+#include <c3d/mesh.h>
+#include <math.h>
+#include <string.h>
+
+// Same values as GPU_FORMATS, which is not available in host builds
+#define FMT_UNSIGNED_BYTE 1
+#define FMT_SHORT         2
+#define FMT_FLOAT         3
+
+static const u8 fmtSize[] = { 1, 1, 2, 4 };
+
+static inline float streamValue(const C3D_MeshStream* s, u32 vertex, int comp)
+{
+	return ((const float*)((const u8*)s->data + vertex*s->stride))[comp];
+}
+
+static inline void setComp(C3D_FVec* v, int comp, float val)
+{
+	// C3D_FVec stores its components in reverse order
+	v->c[3-comp] = val;
+}
+
+static inline float getComp(const C3D_FVec* v, int comp)
+{
+	return v->c[3-comp];
+}
+
+// Picks the smallest format for which every component stays within the error bound
+static void chooseFormat(C3D_MeshAttrib* a, const C3D_MeshStream* s, u32 numVertices)
+{
+	float minVal[4], range[4], maxRange = 0.0f;
+	u32 i;
+	int j;
+
+	a->format = FMT_FLOAT;
+	a->error = 0.0f;
+	for (j = 0; j < 4; j ++)
+	{
+		setComp(&a->scale, j, 1.0f);
+		setComp(&a->bias, j, 0.0f);
+	}
+	if (s->maxError <= 0.0f || !numVertices)
+		return;
+
+	for (j = 0; j < s->count; j ++)
+	{
+		float lo = streamValue(s, 0, j), hi = lo;
+		for (i = 1; i < numVertices; i ++)
+		{
+			float v = streamValue(s, i, j);
+			if (v < lo) lo = v;
+			if (v > hi) hi = v;
+		}
+		minVal[j] = lo;
+		range[j] = hi - lo;
+		if (range[j] > maxRange)
+			maxRange = range[j];
+	}
+
+	// Rounding to the nearest step leaves at most half a step of error
+	if (maxRange/255.0f*0.5f <= s->maxError)
+	{
+		a->format = FMT_UNSIGNED_BYTE;
+		a->error = maxRange/255.0f*0.5f;
+		for (j = 0; j < s->count; j ++)
+		{
+			setComp(&a->scale, j, range[j]/255.0f);
+			setComp(&a->bias, j, minVal[j]);
+		}
+	} else if (maxRange/65535.0f*0.5f <= s->maxError)
+	{
+		a->format = FMT_SHORT;
+		a->error = maxRange/65535.0f*0.5f;
+		for (j = 0; j < s->count; j ++)
+		{
+			float scale = range[j]/65535.0f;
+			setComp(&a->scale, j, scale);
+			setComp(&a->bias, j, minVal[j] + 32768.0f*scale);
+		}
+	}
+}
+
+bool Mesh_PackLayout(C3D_MeshLayout* out, const C3D_MeshStream* streams, int numStreams, u32 numVertices)
+{
+	int i, size;
+	u32 offset = 0, align = 1;
+
+	if (numStreams < 0 || numStreams > C3D_MESH_MAX_ATTRIBS)
+		return false;
+
+	memset(out, 0, sizeof(*out));
+	out->numVertices = numVertices;
+
+	// Attributes are sorted by component size so that no alignment padding is needed between them
+	for (size = 4; size >= 1; size >>= 1)
+	{
+		for (i = 0; i < numStreams; i ++)
+		{
+			C3D_MeshAttrib a;
+			const C3D_MeshStream* s = &streams[i];
+			if (s->count < 1 || s->count > 4)
+				return false;
+
+			chooseFormat(&a, s, numVertices);
+			if (fmtSize[a.format] != size)
+				continue;
+
+			a.regId = s->regId;
+			a.count = s->count;
+			a.src = s;
+			a.stream = i;
+			offset = (offset + size-1) &~ (size-1);
+			a.offset = offset;
+			offset += size*s->count;
+			if (size > align)
+				align = size;
+			out->attribs[out->numAttribs++] = a;
+		}
+	}
+
+	// Keep the next vertex aligned for its widest component
+	out->stride = (offset + align-1) &~ (align-1);
+	return out->stride <= 0xFF;
+}
+
+void Mesh_PackVertices(void* out, const C3D_MeshLayout* layout)
+{
+	u32 i;
+	int a, j;
+
+	for (i = 0; i < layout->numVertices; i ++)
+	{
+		u8* vtx = (u8*)out + i*layout->stride;
+		memset(vtx, 0, layout->stride);
+		for (a = 0; a < layout->numAttribs; a ++)
+		{
+			const C3D_MeshAttrib* attr = &layout->attribs[a];
+			u8* dst = vtx + attr->offset;
+			for (j = 0; j < attr->count; j ++)
+			{
+				float v = streamValue(attr->src, i, j);
+				float scale = getComp(&attr->scale, j);
+				float q = scale > 0.0f ? floorf((v - getComp(&attr->bias, j))/scale + 0.5f) : 0.0f;
+				switch (attr->format)
+				{
+					case FMT_UNSIGNED_BYTE:
+						dst[j] = q < 0.0f ? 0 : q > 255.0f ? 255 : (u8)q;
+						break;
+					case FMT_SHORT:
+					{
+						s16 sv = q < -32768.0f ? -32768 : q > 32767.0f ? 32767 : (s16)q;
+						memcpy(dst + j*2, &sv, 2);
+						break;
+					}
+					default:
+						memcpy(dst + j*4, &v, 4);
+						break;
+				}
+			}
+		}
+	}
+}
+
+int Mesh_PackIndices(void* out, const u16* indices, u32 numIndices, u32 numVertices)
+{
+	u32 i;
+
+	// Returns the index type to pass to C3D_DrawElements
+	if (numVertices <= 0x100)
+	{
+		for (i = 0; i < numIndices; i ++)
+			((u8*)out)[i] = indices[i];
+		return C3D_UNSIGNED_BYTE;
+	}
+
+	memmove(out, indices, numIndices*sizeof(u16));
+	return C3D_UNSIGNED_SHORT;
+}
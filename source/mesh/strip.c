@@ -0,0 +1,171 @@
+#include <c3d/mesh.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+	u32 key; // (from<<16) | to
+	u32 tri;
+} HalfEdge;
+
+typedef struct
+{
+	const u16* indices;
+	HalfEdge* edges;
+	u32 numEdges;
+	u8* used;
+} StripState;
+
+static int edgeCompare(const void* a, const void* b)
+{
+	u32 ka = ((const HalfEdge*)a)->key, kb = ((const HalfEdge*)b)->key;
+	return ka < kb ? -1 : ka > kb ? 1 : 0;
+}
+
+// Finds an unused triangle containing the half-edge from->to
+static s32 findTriangle(const StripState* s, u32 from, u32 to)
+{
+	u32 key = (from<<16) | to;
+	u32 lo = 0, hi = s->numEdges;
+	while (lo < hi)
+	{
+		u32 mid = (lo+hi)/2;
+		if (s->edges[mid].key < key)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	for (; lo < s->numEdges && s->edges[lo].key == key; lo ++)
+		if (!s->used[s->edges[lo].tri])
+			return s->edges[lo].tri;
+	return -1;
+}
+
+// Vertex of a triangle that is neither a nor b
+static inline u32 thirdVertex(const u16* tri, u32 a, u32 b)
+{
+	if (tri[0] != a && tri[0] != b) return tri[0];
+	if (tri[1] != a && tri[1] != b) return tri[1];
+	return tri[2];
+}
+
+static u32 freeNeighbors(const StripState* s, u32 tri)
+{
+	const u16* t = &s->indices[tri*3];
+	u32 i, count = 0;
+	for (i = 0; i < 3; i ++)
+		if (findTriangle(s, t[(i+1)%3], t[i]) >= 0)
+			count ++;
+	return count;
+}
+
+u32 Mesh_Stripify(u16* out, const u16* indices, u32 numIndices, u32* segEnds, u32* numSegs)
+{
+	StripState s;
+	u32 i, r, numTris = numIndices / 3;
+	u32 outPos = 0, segs = 0;
+
+	s.indices = indices;
+	s.numEdges = numTris*3;
+	s.edges = (HalfEdge*)malloc(s.numEdges*sizeof(HalfEdge) + 1);
+	s.used = (u8*)calloc(numTris+1, 1);
+	if (!s.edges || !s.used)
+	{
+		free(s.edges);
+		free(s.used);
+		return 0;
+	}
+
+	for (i = 0; i < s.numEdges; i ++)
+	{
+		s.edges[i].key = ((u32)indices[i]<<16) | indices[(i/3)*3 + (i+1)%3];
+		s.edges[i].tri = i / 3;
+	}
+	qsort(s.edges, s.numEdges, sizeof(HalfEdge), edgeCompare);
+
+	// Start strips in input order so that a cache optimized order is mostly kept
+	for (i = 0; i < numTris; i ++)
+	{
+		if (s.used[i])
+			continue;
+		s.used[i] = 1;
+
+		// Rotate the first triangle so that the strip continues towards the neighbor with
+		// the fewest free neighbors of its own, which leaves fewer isolated triangles behind
+		const u16* t = &indices[i*3];
+		u32 bestRot = 0, bestScore = ~0U;
+		for (r = 0; r < 3; r ++)
+		{
+			s32 next = findTriangle(&s, t[(r+2)%3], t[(r+1)%3]);
+			if (next >= 0)
+			{
+				u32 score = freeNeighbors(&s, next);
+				if (score < bestScore)
+				{
+					bestScore = score;
+					bestRot = r;
+				}
+			}
+		}
+
+		// Stitch to the previous strip with degenerate triangles, keeping the winding parity
+		u32 start = outPos;
+		if (!segEnds && outPos)
+		{
+			out[outPos] = out[outPos-1];
+			outPos ++;
+			out[outPos++] = t[bestRot];
+			if (outPos & 1)
+				out[outPos++] = t[bestRot];
+			start = outPos;
+		}
+
+		out[outPos++] = t[bestRot];
+		out[outPos++] = t[(bestRot+1)%3];
+		out[outPos++] = t[(bestRot+2)%3];
+
+		// Odd triangles in a strip have their first two vertices swapped, so the shared
+		// edge always appears reversed in the next triangle
+		for (;;)
+		{
+			u32 a = out[outPos-2], b = out[outPos-1];
+			s32 next = ((outPos-start) & 1) ? findTriangle(&s, b, a) : findTriangle(&s, a, b);
+			if (next < 0)
+				break;
+			s.used[next] = 1;
+			out[outPos++] = thirdVertex(&indices[next*3], a, b);
+		}
+
+		if (segEnds)
+			segEnds[segs] = outPos;
+		segs ++;
+	}
+
+	free(s.edges);
+	free(s.used);
+	if (numSegs)
+		*numSegs = segEnds ? segs : (segs ? 1 : 0);
+	return outPos;
+}
+
+u32 Mesh_StripOrList(u16* out, bool* isStrip, const u16* indices, u32 numIndices, u32 cacheSize)
+{
+	u32 numList = numIndices/3*3;
+	u16* strip = (u16*)malloc(C3D_MESH_STRIP_MAX(numIndices)*sizeof(u16) + 1);
+	u32 numStrip = strip ? Mesh_Stripify(strip, indices, numIndices, NULL, NULL) : 0;
+
+	// Transforming a vertex costs far more than fetching an index
+	u32 listCost  = Mesh_CacheMisses(indices, numList, cacheSize)*C3D_MESH_MISS_COST + numList;
+	u32 stripCost = numStrip ? Mesh_CacheMisses(strip, numStrip, cacheSize)*C3D_MESH_MISS_COST + numStrip : ~0U;
+
+	*isStrip = stripCost < listCost;
+	if (*isStrip)
+		memcpy(out, strip, numStrip*sizeof(u16));
+	else
+	{
+		memmove(out, indices, numList*sizeof(u16));
+		numStrip = numList;
+	}
+	free(strip);
+	return numStrip;
+}
@@ -0,0 +1,232 @@
+#include <c3d/mesh.h>
+#include <c3d/profile.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_CACHE_SIZE 64
+
+u32 Mesh_CacheMisses(const u16* indices, u32 numIndices, u32 cacheSize)
+{
+	u16 cache[MAX_CACHE_SIZE];
+	u32 i, j, pos = 0, used = 0, misses = 0;
+
+	if (cacheSize > MAX_CACHE_SIZE)
+		cacheSize = MAX_CACHE_SIZE;
+	if (!cacheSize)
+		return numIndices;
+
+	// FIFO replacement: hits do not refresh an entry
+	for (i = 0; i < numIndices; i ++)
+	{
+		for (j = 0; j < used; j ++)
+			if (cache[j] == indices[i])
+				break;
+		if (j < used)
+			continue;
+
+		misses ++;
+		cache[pos] = indices[i];
+		pos = (pos+1) % cacheSize;
+		if (used < cacheSize)
+			used ++;
+	}
+	return misses;
+}
+
+void Mesh_AnalyzeCache(C3D_MeshCacheStats* out, const u16* indices, u32 numIndices, u32 numVertices, u32 cacheSize)
+{
+	u32 i;
+	u8* seen = (u8*)calloc(numVertices, 1);
+
+	memset(out, 0, sizeof(*out));
+	out->misses = Mesh_CacheMisses(indices, numIndices, cacheSize);
+	out->triangles = numIndices / 3;
+
+	if (seen)
+	{
+		for (i = 0; i < numIndices; i ++)
+		{
+			if (indices[i] < numVertices && !seen[indices[i]])
+			{
+				seen[indices[i]] = 1;
+				out->vertices ++;
+			}
+		}
+		free(seen);
+	}
+
+	if (out->triangles)
+		out->acmr = (float)out->misses / out->triangles;
+	if (out->vertices)
+		out->atvr = (float)out->misses / out->vertices;
+}
+
+typedef struct
+{
+	u32* offsets;   // Start of each vertex's triangle list in 'adjacency'
+	u32* adjacency; // Triangles using each vertex
+	u32* live;      // Number of not yet emitted triangles using each vertex
+	u32* cacheTime; // Timestamp at which each vertex entered the cache
+	u32* deadEnd;   // Stack of recently emitted vertices
+	u32* candidates;
+	u8* emitted;
+} TipsifyState;
+
+static void tipsifyFree(TipsifyState* s)
+{
+	free(s->offsets);
+	free(s->adjacency);
+	free(s->live);
+	free(s->cacheTime);
+	free(s->deadEnd);
+	free(s->candidates);
+	free(s->emitted);
+}
+
+static s32 tipsifyNext(TipsifyState* s, u32 numCandidates, u32* deadEndTop, u32* cursor, u32 numVertices, u32 time, u32 cacheSize)
+{
+	u32 i;
+	s32 best = -1;
+	s32 bestPriority = -1;
+
+	// Prefer a vertex that will still be in the cache once its remaining triangles are emitted
+	for (i = 0; i < numCandidates; i ++)
+	{
+		u32 v = s->candidates[i];
+		if (!s->live[v])
+			continue;
+
+		s32 priority = 0;
+		if (time - s->cacheTime[v] + 2*s->live[v] <= cacheSize)
+			priority = time - s->cacheTime[v];
+		if (priority > bestPriority)
+		{
+			bestPriority = priority;
+			best = v;
+		}
+	}
+	if (best >= 0)
+		return best;
+
+	// Dead end: backtrack through recently emitted vertices, then scan in input order
+	while (*deadEndTop)
+	{
+		u32 v = s->deadEnd[--*deadEndTop];
+		if (s->live[v])
+			return v;
+	}
+	while (*cursor < numVertices)
+	{
+		u32 v = (*cursor)++;
+		if (s->live[v])
+			return v;
+	}
+	return -1;
+}
+
+bool Mesh_OptimizeCache(u16* out, const u16* indices, u32 numIndices, u32 numVertices, u32 cacheSize)
+{
+	TipsifyState s;
+	u32 i, j, numTris = numIndices / 3;
+	u32 time, cursor = 0, deadEndTop = 0, outPos = 0;
+	u16* result;
+	s32 fan;
+	C3D_PROFILE_SCOPE("Mesh_OptimizeCache");
+
+	for (i = 0; i < numTris*3; i ++)
+		if (indices[i] >= numVertices)
+			return false;
+
+	memset(&s, 0, sizeof(s));
+	s.offsets    = (u32*)calloc(numVertices+1, sizeof(u32));
+	s.adjacency  = (u32*)malloc(numTris*3*sizeof(u32) + 1);
+	s.live       = (u32*)calloc(numVertices, sizeof(u32));
+	s.cacheTime  = (u32*)calloc(numVertices, sizeof(u32));
+	s.deadEnd    = (u32*)malloc(numTris*3*sizeof(u32) + 1);
+	s.candidates = (u32*)malloc(numTris*3*sizeof(u32) + 1);
+	s.emitted    = (u8*)calloc(numTris+1, 1);
+	result       = (u16*)malloc(numIndices*sizeof(u16) + 1);
+	if (!s.offsets || !s.adjacency || !s.live || !s.cacheTime || !s.deadEnd || !s.candidates || !s.emitted || !result)
+	{
+		tipsifyFree(&s);
+		free(result);
+		return false;
+	}
+
+	// Build the vertex to triangle adjacency
+	for (i = 0; i < numTris*3; i ++)
+		s.live[indices[i]] ++;
+	for (i = 0; i < numVertices; i ++)
+		s.offsets[i+1] = s.offsets[i] + s.live[i];
+	for (i = 0; i < numVertices; i ++)
+		s.cacheTime[i] = s.offsets[i];
+	for (i = 0; i < numTris*3; i ++)
+		s.adjacency[s.cacheTime[indices[i]]++] = i / 3;
+	memset(s.cacheTime, 0, numVertices*sizeof(u32));
+
+	time = cacheSize + 1;
+	fan = numVertices ? 0 : -1;
+	while (fan >= 0)
+	{
+		u32 numCandidates = 0;
+		for (i = s.offsets[fan]; i < s.offsets[fan+1]; i ++)
+		{
+			u32 tri = s.adjacency[i];
+			if (s.emitted[tri])
+				continue;
+			s.emitted[tri] = 1;
+
+			for (j = 0; j < 3; j ++)
+			{
+				u32 v = indices[tri*3+j];
+				result[outPos++] = v;
+				s.deadEnd[deadEndTop++] = v;
+				s.candidates[numCandidates++] = v;
+				s.live[v] --;
+				if (time - s.cacheTime[v] > cacheSize)
+					s.cacheTime[v] = time++;
+			}
+		}
+		fan = tipsifyNext(&s, numCandidates, &deadEndTop, &cursor, numVertices, time, cacheSize);
+	}
+
+	// Trailing indices that do not form a triangle are kept as is
+	for (i = numTris*3; i < numIndices; i ++)
+		result[outPos++] = indices[i];
+
+	memcpy(out, result, numIndices*sizeof(u16));
+	free(result);
+	tipsifyFree(&s);
+	return true;
+}
+
+u32 Mesh_OptimizeFetch(u16* remap, u16* indices, u32 numIndices, u32 numVertices)
+{
+	u32 i, next = 0;
+
+	// Number vertices in order of first use so that fetches walk the buffer linearly
+	memset(remap, 0xFF, numVertices*sizeof(u16));
+	for (i = 0; i < numIndices; i ++)
+	{
+		u16 v = indices[i];
+		if (v >= numVertices)
+			continue;
+		if (remap[v] == 0xFFFF)
+			remap[v] = next++;
+		indices[i] = remap[v];
+	}
+
+	// Unreferenced vertices go to the end
+	u32 used = next;
+	for (i = 0; i < numVertices; i ++)
+		if (remap[i] == 0xFFFF)
+			remap[i] = next++;
+	return used;
+}
+
+void Mesh_RemapVertices(void* out, const void* in, u32 numVertices, u32 stride, const u16* remap)
+{
+	u32 i;
+	for (i = 0; i < numVertices; i ++)
+		memcpy((u8*)out + remap[i]*stride, (const u8*)in + i*stride, stride);
+}
@@ -0,0 +1,184 @@
+/** @file mesh3ds.c
+ *  @brief Mesh3DS routines
+ */
+#include "internal.h"
+#include <mesh3ds.h>
+#include <c3d/uniforms.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/** @brief Mesh3DS mesh
+ *  @note The file is loaded as is; vertex and index data follow the header
+ */
+struct Mesh3DS_Mesh_s
+{
+	C3D_MeshFileHeader hdr; ///< File header, with buffer offsets fixed up
+};
+
+static bool Mesh3DSi_Validate(const C3D_MeshFileHeader* hdr, size_t size)
+{
+	u32 i;
+	if (size < sizeof(*hdr) || hdr->magic != C3D_MESHFILE_MAGIC || hdr->version != C3D_MESHFILE_VERSION)
+		return false;
+	if (hdr->fileSize > size || hdr->bufCount > 12 || hdr->attrCount < 1 || hdr->attrCount > 12)
+		return false;
+	if (hdr->indexType > C3D_UNSIGNED_SHORT || (hdr->primitive & 0xFF) || hdr->primitive > GPU_GEOMETRY_PRIM)
+		return false;
+
+	// The data is loaded at the start of a linear allocation, so offsets also give the alignment: uniforms
+	// are read as floats and 16-bit indices as halfwords
+	if ((hdr->uniformOffset & 3) || (hdr->indexType == C3D_UNSIGNED_SHORT && (hdr->indexOffset & 1)))
+		return false;
+
+	// Sizes come from the file, so compare them without letting products or sums wrap
+	if (hdr->uniformOffset > hdr->fileSize || hdr->numUniforms > (hdr->fileSize - hdr->uniformOffset)/(4*sizeof(float)))
+		return false;
+	if (hdr->indexOffset > hdr->fileSize || hdr->numIndices > (hdr->fileSize - hdr->indexOffset)/(hdr->indexType ? 2 : 1))
+		return false;
+	for (i = 0; i < hdr->bufCount; i ++)
+	{
+		u32 offset = hdr->buffers[i].offset;
+		u32 stride = (hdr->buffers[i].flags[1] >> 16) & 0xFF;
+		if (offset > hdr->fileSize || (u64)hdr->numVertices*stride > hdr->fileSize - offset)
+			return false;
+	}
+	return true;
+}
+
+// Takes ownership of the linear allocation
+static Mesh3DS_Mesh Mesh3DSi_ImportCommon(void* data, size_t size)
+{
+	Mesh3DS_Mesh mesh = (Mesh3DS_Mesh)data;
+	C3D_BufInfo info;
+	u32 i;
+
+	if (!Mesh3DSi_Validate(&mesh->hdr, size))
+	{
+		linearFree(data);
+		return NULL;
+	}
+
+	// Turn file relative buffer offsets into offsets from the attribute buffer base
+	BufInfo_Init(&info);
+	u32 pa = osConvertVirtToPhys(data);
+	if (pa < info.base_paddr)
+	{
+		linearFree(data);
+		return NULL;
+	}
+	for (i = 0; i < mesh->hdr.bufCount; i ++)
+		mesh->hdr.buffers[i].offset += pa - info.base_paddr;
+
+	GSPGPU_FlushDataCache(data, mesh->hdr.fileSize);
+	return mesh;
+}
+
+Mesh3DS_Mesh Mesh3DS_MeshImport(const void* input, size_t insize)
+{
+	void* data = linearAlloc(insize);
+	if (!data)
+		return NULL;
+
+	memcpy(data, input, insize);
+	return Mesh3DSi_ImportCommon(data, insize);
+}
+
+Mesh3DS_Mesh Mesh3DS_MeshImportFD(int fd)
+{
+	struct stat st;
+	off_t pos = lseek(fd, 0, SEEK_CUR);
+	if (pos < 0 || fstat(fd, &st) != 0 || st.st_size <= pos)
+		return NULL;
+
+	size_t size = st.st_size - pos;
+	void* data = linearAlloc(size);
+	if (!data)
+		return NULL;
+
+	if (read(fd, data, size) != (ssize_t)size)
+	{
+		linearFree(data);
+		return NULL;
+	}
+	return Mesh3DSi_ImportCommon(data, size);
+}
+
+Mesh3DS_Mesh Mesh3DS_MeshImportStdio(FILE* fp)
+{
+	long pos = ftell(fp);
+	if (pos < 0 || fseek(fp, 0, SEEK_END) != 0)
+		return NULL;
+	long end = ftell(fp);
+	if (end <= pos || fseek(fp, pos, SEEK_SET) != 0)
+		return NULL;
+
+	size_t size = end - pos;
+	void* data = linearAlloc(size);
+	if (!data)
+		return NULL;
+
+	if (fread(data, 1, size, fp) != size)
+	{
+		linearFree(data);
+		return NULL;
+	}
+	return Mesh3DSi_ImportCommon(data, size);
+}
+
+void Mesh3DS_MeshBind(const Mesh3DS_Mesh mesh)
+{
+	const C3D_MeshFileHeader* hdr = &mesh->hdr;
+
+	C3D_AttrInfo* attrInfo = C3D_GetAttrInfo();
+	if (attrInfo)
+	{
+		AttrInfo_Init(attrInfo);
+		attrInfo->flags[0] = hdr->attrFlags[0];
+		attrInfo->flags[1] = hdr->attrFlags[1];
+		attrInfo->permutation = hdr->attrPermutation[0] | ((u64)hdr->attrPermutation[1] << 32);
+		attrInfo->attrCount = hdr->attrCount;
+	}
+
+	C3D_BufInfo* bufInfo = C3D_GetBufInfo();
+	if (bufInfo)
+	{
+		BufInfo_Init(bufInfo);
+		bufInfo->bufCount = hdr->bufCount;
+		memcpy(bufInfo->buffers, hdr->buffers, hdr->bufCount*sizeof(C3D_BufCfg));
+	}
+}
+
+void Mesh3DS_MeshSetUniforms(const Mesh3DS_Mesh mesh, int firstId)
+{
+	const C3D_MeshFileHeader* hdr = &mesh->hdr;
+	const float* unif = (const float*)((const u8*)mesh + hdr->uniformOffset);
+	u32 i;
+
+	C3D_FVec* ptr = C3D_FVUnifWritePtr(GPU_VERTEX_SHADER, firstId, hdr->numUniforms);
+	for (i = 0; i < hdr->numUniforms; i ++)
+		ptr[i] = FVec4_New(unif[i*4+0], unif[i*4+1], unif[i*4+2], unif[i*4+3]);
+}
+
+void Mesh3DS_MeshDraw(const Mesh3DS_Mesh mesh)
+{
+	const C3D_MeshFileHeader* hdr = &mesh->hdr;
+	C3D_DrawElements((GPU_Primitive_t)hdr->primitive, hdr->numIndices, hdr->indexType, Mesh3DS_MeshGetIndices(mesh));
+}
+
+const C3D_MeshFileHeader* Mesh3DS_MeshGetHeader(const Mesh3DS_Mesh mesh)
+{
+	return &mesh->hdr;
+}
+
+const void* Mesh3DS_MeshGetIndices(const Mesh3DS_Mesh mesh)
+{
+	return (const u8*)mesh + mesh->hdr.indexOffset;
+}
+
+void Mesh3DS_MeshFree(Mesh3DS_Mesh mesh)
+{
+	linearFree(mesh);
+}
@@ -0,0 +1,39 @@
+#include "internal.h"
+#include <c3d/mesh.h>
+#include <c3d/uniforms.h>
+
+void Mesh_LayoutAttrInfo(const C3D_MeshLayout* layout, C3D_AttrInfo* info)
+{
+	int i;
+	AttrInfo_Init(info);
+	for (i = 0; i < layout->numAttribs; i ++)
+	{
+		const C3D_MeshAttrib* a = &layout->attribs[i];
+		AttrInfo_AddLoader(info, a->regId, (GPU_FORMATS)a->format, a->count);
+	}
+}
+
+int Mesh_LayoutBufInfo(const C3D_MeshLayout* layout, C3D_BufInfo* info, const void* data)
+{
+	int i;
+	u64 permutation = 0;
+
+	// All attributes live in a single buffer, in loader order
+	for (i = 0; i < layout->numAttribs; i ++)
+		permutation |= (u64)i << (i*4);
+
+	BufInfo_Init(info);
+	return BufInfo_Add(info, data, layout->stride, layout->numAttribs, permutation);
+}
+
+void Mesh_LayoutUniforms(const C3D_MeshLayout* layout, int firstId)
+{
+	int i;
+	for (i = 0; i < layout->numAttribs; i ++)
+	{
+		const C3D_MeshAttrib* a = &layout->attribs[i];
+		C3D_FVec* ptr = C3D_FVUnifWritePtr(GPU_VERTEX_SHADER, firstId + 2*a->stream, 2);
+		ptr[0] = a->scale;
+		ptr[1] = a->bias;
+	}
+}
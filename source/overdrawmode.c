@@ -0,0 +1,103 @@
+#include "internal.h"
+#include <c3d/renderqueue.h>
+
+// Each counted fragment adds this to the color buffer, so the target doubles as a heatmap
+#define OVERDRAW_COLOR 0x00081020
+
+static bool enabled;
+static bool counting;
+static int isolated = -1;
+static u32 drawIndex;
+static C3D_Effect effect;
+static C3D_TexEnv texEnv;
+
+static void C3Di_OverdrawDirty(void)
+{
+	C3Di_GetContext()->flags |= C3DiF_Effect | C3DiF_TexEnvBuf | C3DiF_TexEnvAll;
+}
+
+void C3D_OverdrawMode(bool enable)
+{
+	if (enabled == enable)
+		return;
+	enabled = enable;
+	counting = isolated < 0;
+	C3Di_OverdrawDirty();
+}
+
+void C3D_OverdrawIsolate(int draw)
+{
+	isolated = draw;
+	if (enabled)
+		C3Di_OverdrawDirty();
+}
+
+void C3Di_OverdrawFrameBegin(void)
+{
+	drawIndex = 0;
+	if (enabled)
+		C3Di_OverdrawDirty();
+}
+
+void C3Di_OverdrawDraw(C3D_Context* ctx)
+{
+	if (!enabled)
+		return;
+	bool count = isolated < 0 || drawIndex == (u32)isolated;
+	drawIndex ++;
+	if (count != counting)
+	{
+		counting = count;
+		ctx->flags |= C3DiF_Effect | C3DiF_TexEnvAll;
+	}
+}
+
+C3D_Effect* C3Di_OverdrawEffect(C3D_Effect* e)
+{
+	if (!enabled)
+		return e;
+
+	// Depth testing stays as configured so occlusion still works, but every rasterized fragment is
+	// counted whether it passes or not: it has been through the fragment pipeline either way
+	GPU_STENCILOP op = counting ? GPU_STENCIL_INCR : GPU_STENCIL_KEEP;
+	effect = *e;
+	effect.alphaTest = 0;
+	effect.stencilMode = 1 | (GPU_ALWAYS << 4) | (0xFF << 8) | (0xFF << 24);
+	effect.stencilOp = GPU_STENCIL_KEEP | (op << 4) | (op << 8);
+	effect.alphaBlend = GPU_BLEND_ADD | (GPU_BLEND_ADD << 8) | (GPU_ONE << 16) | (GPU_ONE << 20) | (GPU_ONE << 24) | (GPU_ONE << 28);
+	effect.fragOpMode = (effect.fragOpMode &~ 0xFF00) | 0x0100;
+	return &effect;
+}
+
+C3D_TexEnv* C3Di_OverdrawTexEnv(int id, C3D_TexEnv* env)
+{
+	if (!enabled)
+		return env;
+
+	C3D_TexEnvInit(&texEnv);
+	if (id == 0)
+	{
+		C3D_TexEnvSrc(&texEnv, C3D_Both, GPU_CONSTANT, GPU_PRIMARY_COLOR, GPU_PRIMARY_COLOR);
+		C3D_TexEnvColor(&texEnv, counting ? OVERDRAW_COLOR : 0);
+	}
+	return &texEnv;
+}
+
+u32 C3Di_OverdrawTexEnvBuf(u32 texEnvBuf)
+{
+	// Fog and gas would blend the fog color over the count color
+	return enabled ? texEnvBuf &~ 0xF : texEnvBuf;
+}
+
+bool C3D_OverdrawRead(C3D_RenderTarget* target, C3D_OverdrawStats* out, u8* heatmap)
+{
+	C3D_FrameBuf* fb = &target->frameBuf;
+	if (!fb->depthBuf || fb->depthFmt != GPU_RB_DEPTH24_STENCIL8 || fb->block32)
+		return false;
+
+	C3Di_RenderQueueWaitDone();
+	u32 vaddr = (u32)fb->depthBuf;
+	if (vaddr < OS_VRAM_VADDR || vaddr >= OS_VRAM_VADDR + OS_VRAM_SIZE)
+		GSPGPU_InvalidateDataCache(fb->depthBuf, C3D_CalcDepthBufSize(fb->width, fb->height, fb->depthFmt));
+	return C3D_OverdrawCount(fb->depthBuf, fb->width, fb->height, out, heatmap);
+}
@@ -0,0 +1,246 @@
+#include <c3d/pixconv.h>
+#include <c3d/profile.h>
+#include <string.h>
+
+// The ARM11 has no vector unit, so the kernels process whole words: four RGB8 pixels are read as
+// three words, two 16-bit pixels share a word, and byte order is swapped with rev (bswap).
+
+static inline u32 rgbToRgba(u32 x)
+{
+	// x holds 0x??RRGGBB, the result has the bytes R, G, B, 0xFF in memory
+	return __builtin_bswap32(x << 8) | 0xFF000000;
+}
+
+static inline u32 rgbTo565(u32 x)
+{
+	return ((x >> 8) & 0xF800) | ((x >> 5) & 0x07E0) | ((x >> 3) & 0x001F);
+}
+
+static inline u32 expand565(u32 v)
+{
+	u32 r = (v >> 11) & 0x1F, g = (v >> 5) & 0x3F, b = v & 0x1F;
+	r = (r << 3) | (r >> 2);
+	g = (g << 2) | (g >> 4);
+	b = (b << 3) | (b >> 2);
+	return r | (g << 8) | (b << 16) | 0xFF000000;
+}
+
+static inline u32 expand5551(u32 v)
+{
+	u32 r = (v >> 11) & 0x1F, g = (v >> 6) & 0x1F, b = (v >> 1) & 0x1F;
+	r = (r << 3) | (r >> 2);
+	g = (g << 3) | (g >> 2);
+	b = (b << 3) | (b >> 2);
+	return r | (g << 8) | (b << 16) | ((v & 1) ? 0xFF000000 : 0);
+}
+
+static inline u32 expand4444(u32 v)
+{
+	// Spreading the nibbles to one per byte then multiplying by 0x11 replicates each of them
+	u32 x = ((v >> 12) & 0xF) | ((v >> 8) & 0xF) << 8 | ((v >> 4) & 0xF) << 16 | (v & 0xF) << 24;
+	return x * 0x11;
+}
+
+static inline u32 reduce4444(u32 v)
+{
+	u32 r = (v >> 12) & 0xF, g = (v >> 8) & 0xF, b = (v >> 4) & 0xF;
+	return (r << 12) | ((r >> 3) << 11) | (g << 7) | ((g >> 2) << 5) | (b << 1) | (b >> 3);
+}
+
+static void convertRgba(u32* dst, const void* src, C3D_PixFormat fmt, u32 n)
+{
+	const u32* s = (const u32*)src;
+	const u16* h = (const u16*)src;
+	u32 i;
+
+	switch (fmt)
+	{
+		case C3D_PIX_RGBA8:
+			for (i = 0; i < n; i ++)
+				dst[i] = __builtin_bswap32(s[i]);
+			break;
+		case C3D_PIX_RGB8:
+			for (i = 0; i + 4 <= n; i += 4, s += 3)
+			{
+				u32 w0 = s[0], w1 = s[1], w2 = s[2];
+				dst[i+0] = rgbToRgba(w0);
+				dst[i+1] = rgbToRgba((w0 >> 24) | (w1 << 8));
+				dst[i+2] = rgbToRgba((w1 >> 16) | (w2 << 16));
+				dst[i+3] = rgbToRgba(w2 >> 8);
+			}
+			for (; i < n; i ++)
+			{
+				const u8* p = (const u8*)src + i*3;
+				dst[i] = rgbToRgba(p[0] | (p[1] << 8) | (p[2] << 16));
+			}
+			break;
+		case C3D_PIX_RGB5A1:
+			for (i = 0; i < n; i ++)
+				dst[i] = expand5551(h[i]);
+			break;
+		case C3D_PIX_RGB565:
+			for (i = 0; i < n; i ++)
+				dst[i] = expand565(h[i]);
+			break;
+		case C3D_PIX_RGBA4:
+			for (i = 0; i < n; i ++)
+				dst[i] = expand4444(h[i]);
+			break;
+	}
+}
+
+static void convert565(u16* dst, const void* src, C3D_PixFormat fmt, u32 n)
+{
+	u32* d = (u32*)dst;
+	const u32* s = (const u32*)src;
+	const u16* h = (const u16*)src;
+	u32 i, w;
+
+	switch (fmt)
+	{
+		case C3D_PIX_RGBA8:
+			for (i = 0; i + 2 <= n; i += 2)
+				d[i/2] = rgbTo565(s[i] >> 8) | (rgbTo565(s[i+1] >> 8) << 16);
+			if (i < n)
+				dst[i] = rgbTo565(s[i] >> 8);
+			break;
+		case C3D_PIX_RGB8:
+			for (i = 0; i + 4 <= n; i += 4, s += 3)
+			{
+				u32 w0 = s[0], w1 = s[1], w2 = s[2];
+				d[i/2+0] = rgbTo565(w0) | (rgbTo565((w0 >> 24) | (w1 << 8)) << 16);
+				d[i/2+1] = rgbTo565((w1 >> 16) | (w2 << 16)) | (rgbTo565(w2 >> 8) << 16);
+			}
+			for (; i < n; i ++)
+			{
+				const u8* p = (const u8*)src + i*3;
+				dst[i] = rgbTo565(p[0] | (p[1] << 8) | (p[2] << 16));
+			}
+			break;
+		case C3D_PIX_RGB5A1:
+			for (i = 0; i + 2 <= n; i += 2)
+			{
+				// Red stays, green gains its top bit as the low bit, blue shifts down over alpha
+				w = h[i] | (h[i+1] << 16);
+				d[i/2] = (w & 0xFFC0FFC0) | ((w >> 1) & 0x001F001F) | ((w >> 5) & 0x00200020);
+			}
+			if (i < n)
+			{
+				w = h[i];
+				dst[i] = (w & 0xFFC0) | ((w >> 1) & 0x1F) | ((w >> 5) & 0x20);
+			}
+			break;
+		case C3D_PIX_RGB565:
+			memcpy(dst, src, n*2);
+			break;
+		case C3D_PIX_RGBA4:
+			for (i = 0; i < n; i ++)
+				dst[i] = reduce4444(h[i]);
+			break;
+	}
+}
+
+void C3D_PixConvert(void* dst, C3D_PixOutput out, const void* src, C3D_PixFormat fmt, u32 numPixels)
+{
+	if (out == C3D_PIXOUT_RGBA)
+		convertRgba((u32*)dst, src, fmt, numPixels);
+	else
+		convert565((u16*)dst, src, fmt, numPixels);
+}
+
+void C3D_PixDetile(void* dst, C3D_PixOutput out, const void* src, C3D_PixFormat fmt, u32 width, u32 height)
+{
+	// Within a tile, x takes bits 0, 2 and 4 of the pixel index and y bits 1, 3 and 5. Pixels 2n and
+	// 2n+1 of a tile row are adjacent, so rows are gathered a pair at a time into a small chunk that
+	// is then converted. The chunk covers 8 tiles.
+	static const u8 pairX[4] = { 0, 4, 16, 20 };
+	static const u8 rowY[8] = { 0, 2, 8, 10, 32, 34, 40, 42 };
+	u32 chunk[64]; // 64 pixels of at most 4 bytes
+	u32 size = C3D_PixSize(fmt), pair = size*2, tileSize = size*64;
+	u32 outPitch = width*C3D_PixOutputSize(out);
+	u32 ty, y, tx, i;
+	C3D_PROFILE_SCOPE("C3D_PixDetile");
+
+	if ((width & 7) || (height & 7))
+		return;
+
+	for (ty = 0; ty < height; ty += 8)
+	{
+		const u8* tileRow = (const u8*)src + ty*width*size;
+		for (y = 0; y < 8; y ++)
+		{
+			u8* d = (u8*)dst + (ty + y)*outPitch;
+			for (tx = 0; tx < width; tx += 64)
+			{
+				u32 tiles = (width - tx) < 64 ? (width - tx)/8 : 8;
+				const u8* tile = tileRow + (tx/8)*tileSize + rowY[y]*size;
+				u8* c = (u8*)chunk;
+				for (; tiles; tiles --, tile += tileSize)
+					for (i = 0; i < 4; i ++, c += pair)
+						memcpy(c, tile + pairX[i]*size, pair);
+				C3D_PixConvert(d + tx*C3D_PixOutputSize(out), out, chunk, fmt, (c - (u8*)chunk)/size);
+			}
+		}
+	}
+}
+
+static inline u32 clamp8(int x)
+{
+	return x < 0 ? 0 : x > 255 ? 255 : x; // usat on ARMv6
+}
+
+bool C3D_PixFromYUV420Tiled(void* dst, C3D_PixFormat fmt, u32 texWidth, u32 texHeight, const C3D_YUVFrame* src, u32 width, u32 y0, u32 y1)
+{
+	// A 2x2 block of pixels with even x and y is stored as 4 consecutive pixels within a tile, so each
+	// chroma sample produces one contiguous quad, upper row first. Quads start every 4 pixels of a tile:
+	// x bits 1 and 2 land on index bits 2 and 4, y bits 1 and 2 on index bits 3 and 5.
+	static const u8 quadX[4] = { 0, 4, 16, 20 };
+	static const u8 quadY[4] = { 0, 8, 32, 40 };
+	u32 x, y;
+	C3D_PROFILE_SCOPE("C3D_PixFromYUV420Tiled");
+
+	if ((fmt != C3D_PIX_RGB565 && fmt != C3D_PIX_RGB8) || (width & 1) || (y0 & 1) || (y1 & 1)
+		|| width > texWidth || y1 > texHeight || (texWidth & 7) || (texHeight & 7))
+		return false;
+
+	for (y = y0; y < y1; y += 2)
+	{
+		// Memory row 0 is the top of the texture (t=1), so image rows map straight onto texture rows
+		u32 base = (y >> 3)*texWidth*8 + quadY[(y >> 1) & 3];
+		const u8* ly0 = src->y + y*src->yStride;
+		const u8* ly1 = ly0 + src->yStride;
+		const u8* pu = src->u + (y >> 1)*src->uvStride;
+		const u8* pv = src->v + (y >> 1)*src->uvStride;
+
+		for (x = 0; x < width; x += 2)
+		{
+			int d = *pu++ - 128, e = *pv++ - 128;
+			int cr = 409*e + 128, cg = -100*d - 208*e + 128, cb = 516*d + 128;
+			int l[4] =
+			{
+				298*(ly0[x] - 16), 298*(ly0[x+1] - 16),
+				298*(ly1[x] - 16), 298*(ly1[x+1] - 16),
+			};
+			u32 idx = base + (x & ~7)*8 + quadX[(x >> 1) & 3];
+			u32 p[4], i;
+
+			if (fmt == C3D_PIX_RGB565)
+			{
+				for (i = 0; i < 4; i ++)
+					p[i] = ((clamp8((l[i] + cr) >> 8) >> 3) << 11) | ((clamp8((l[i] + cg) >> 8) >> 2) << 5) | (clamp8((l[i] + cb) >> 8) >> 3);
+				u32* out = (u32*)((u16*)dst + idx);
+				out[0] = p[0] | (p[1] << 16);
+				out[1] = p[2] | (p[3] << 16);
+			} else
+			{
+				for (i = 0; i < 4; i ++)
+					p[i] = (clamp8((l[i] + cr) >> 8) << 16) | (clamp8((l[i] + cg) >> 8) << 8) | clamp8((l[i] + cb) >> 8);
+				u32* out = (u32*)((u8*)dst + idx*3);
+				out[0] = p[0] | (p[1] << 24);
+				out[1] = (p[1] >> 8) | (p[2] << 16);
+				out[2] = (p[2] >> 16) | (p[3] << 8);
+			}
+		}
+	}
+	return true;
+}
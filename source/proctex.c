@@ -109,11 +109,18 @@ void C3D_ProcTexColorLutBind(C3D_ProcTexColorLut* lut)
 	if (!(ctx->flags & C3DiF_Active))
 		return;
 
-	ctx->procTexColorLut = lut;
 	if (lut)
+	{
+		// Binding a different LUT (or rebinding one without pending writes) uploads it entirely
+		if (lut != ctx->procTexColorLut || lut->dirtyStart >= lut->dirtyEnd)
+		{
+			lut->dirtyStart = 0;
+			lut->dirtyEnd = 256;
+		}
 		ctx->flags |= C3DiF_ProcTexColorLut;
-	else
+	} else
 		ctx->flags &= ~C3DiF_ProcTexColorLut;
+	ctx->procTexColorLut = lut;
 }
 
 static inline u32 calc_diff(u32 cur, u32 next, int pos)
@@ -139,6 +146,15 @@ void ProcTexColorLut_Write(C3D_ProcTexColorLut* out, const u32* in, int offset,
 			calc_diff(cur,next,24);
 	}
 	out->diff[offset+width-1] = 0;
+
+	if (out->dirtyStart > offset)
+		out->dirtyStart = offset;
+	if (out->dirtyEnd < offset+width)
+		out->dirtyEnd = offset+width;
+
+	C3D_Context* ctx = C3Di_GetContext();
+	if ((ctx->flags & C3DiF_Active) && ctx->procTexColorLut == out)
+		ctx->flags |= C3DiF_ProcTexColorLut;
 }
 
 void C3Di_ProcTexUpdate(C3D_Context* ctx)
@@ -169,12 +185,20 @@ void C3Di_ProcTexUpdate(C3D_Context* ctx)
 	if (ctx->flags & C3DiF_ProcTexColorLut)
 	{
 		ctx->flags &= ~C3DiF_ProcTexColorLut;
-		if (ctx->procTexColorLut)
+		C3D_ProcTexColorLut* lut = ctx->procTexColorLut;
+		if (lut)
 		{
-			GPUCMD_AddWrite(GPUREG_PROCTEX_LUT, GPU_LUT_COLOR<<8);
-			GPUCMD_AddWrites(GPUREG_PROCTEX_LUT_DATA0, ctx->procTexColorLut->color, 256);
-			GPUCMD_AddWrite(GPUREG_PROCTEX_LUT, GPU_LUT_COLORDIF<<8);
-			GPUCMD_AddWrites(GPUREG_PROCTEX_LUT_DATA0, ctx->procTexColorLut->diff, 256);
+			u32 start = lut->dirtyStart;
+			u32 end = lut->dirtyEnd < 256 ? lut->dirtyEnd : 256;
+			if (start < end)
+			{
+				GPUCMD_AddWrite(GPUREG_PROCTEX_LUT, (GPU_LUT_COLOR<<8) | start);
+				GPUCMD_AddWrites(GPUREG_PROCTEX_LUT_DATA0, &lut->color[start], end-start);
+				GPUCMD_AddWrite(GPUREG_PROCTEX_LUT, (GPU_LUT_COLORDIF<<8) | start);
+				GPUCMD_AddWrites(GPUREG_PROCTEX_LUT_DATA0, &lut->diff[start], end-start);
+			}
+			lut->dirtyStart = 256;
+			lut->dirtyEnd = 0;
 		}
 	}
 }
@@ -187,7 +211,11 @@ void C3Di_ProcTexDirty(C3D_Context* ctx)
 
 	ctx->flags |= C3DiF_ProcTex;
 	if (ctx->procTexColorLut)
+	{
+		ctx->procTexColorLut->dirtyStart = 0;
+		ctx->procTexColorLut->dirtyEnd = 256;
 		ctx->flags |= C3DiF_ProcTexColorLut;
+	}
 	for (i = 0; i < 3; i ++)
 		if (ctx->procTexLut[i])
 			ctx->flags |= C3DiF_ProcTexLut(i);
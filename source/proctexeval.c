@@ -0,0 +1,404 @@
+#include "internal.h"
+#include <math.h>
+
+// Coordinates are processed in batches so that each stage runs as a tight loop over a row
+#define PT_CHUNK 64
+
+typedef struct
+{
+	float freqU, freqV;
+	float phaseU, phaseV;
+	float amplU, amplV;
+} C3Di_ProcTexNoise;
+
+static float f16tof32(u16 x)
+{
+	union { float f; u32 i; } s;
+	u32 sign = x>>15;
+	u32 exponent = (x>>10)&0x1F;
+	u32 mantissa = x&0x3FF;
+
+	if (!exponent)
+	{
+		float f = ldexpf(mantissa, -24);
+		return sign ? -f : f;
+	}
+
+	if (exponent == 0x1F)
+		exponent = 0xFF;
+	else
+		exponent = exponent - 15 + 127;
+	s.i = (sign<<31) | (exponent<<23) | (mantissa<<13);
+	return s.f;
+}
+
+static inline float clamp01(float x)
+{
+	if (x < 0.0f) return 0.0f;
+	if (x > 1.0f) return 1.0f;
+	return x;
+}
+
+static inline float lutLookup(const C3D_ProcTexLut* lut, float coord)
+{
+	if (!lut)
+		return coord;
+
+	coord *= 128.0f;
+	int i = (int)coord;
+	if (i < 0) i = 0;
+	if (i > 127) i = 127;
+	float frac = coord - i;
+
+	// 12-bit unsigned value, 12-bit signed difference to the next entry
+	u32 entry = (*lut)[i];
+	s32 diff = (s32)(entry<<8)>>20;
+	return ((entry&0xFFF) + frac*diff) * (1.0f/0xFFF);
+}
+
+static inline u32 noiseRand1D(u32 v)
+{
+	static const u8 table[] = { 0, 4, 10, 8, 4, 9, 7, 12, 5, 15, 13, 14, 11, 15, 2, 11 };
+	return (((v%9 + 2)*3) & 0xF) ^ table[(v/9) & 0xF];
+}
+
+static inline float noiseRand2D(u32 x, u32 y)
+{
+	static const u8 table[] = { 10, 2, 15, 8, 0, 7, 4, 5, 5, 13, 2, 6, 13, 9, 3, 14 };
+	u32 u2 = noiseRand1D(x);
+	u32 v2 = noiseRand1D(y);
+	v2 += ((u2&3) == 1) ? 4 : 0;
+	v2 ^= (u2&1)*6;
+	v2 += 10 + u2;
+	v2 &= 0xF;
+	v2 ^= table[u2];
+	return -1.0f + v2*(2.0f/15.0f);
+}
+
+static float noiseCoef(const C3D_ProcTexLut* lut, const C3Di_ProcTexNoise* np, float u, float v)
+{
+	float x = 9.0f*np->freqU*fabsf(u + np->phaseU);
+	float y = 9.0f*np->freqV*fabsf(v + np->phaseV);
+	int xi = (int)x;
+	int yi = (int)y;
+	float xf = x - xi;
+	float yf = y - yi;
+
+	float g0 = noiseRand2D(xi,   yi)   * (xf + yf);
+	float g1 = noiseRand2D(xi+1, yi)   * (xf + yf - 1.0f);
+	float g2 = noiseRand2D(xi,   yi+1) * (xf + yf - 1.0f);
+	float g3 = noiseRand2D(xi+1, yi+1) * (xf + yf - 2.0f);
+	float xn = lutLookup(lut, xf);
+	float yn = lutLookup(lut, yf);
+
+	float a = g0 + (g1-g0)*xn;
+	float b = g2 + (g3-g2)*xn;
+	return a + (b-a)*yn;
+}
+
+static void shiftRow(float* out, const float* c, int n, u32 mode, u32 clamp)
+{
+	int i;
+	float offset = clamp == GPU_PT_MIRRORED_REPEAT ? 1.0f : 0.5f;
+	switch (mode)
+	{
+		case GPU_PT_ODD:
+			for (i = 0; i < n; i ++)
+				out[i] = offset*(((int)c[i]/2)&1);
+			break;
+		case GPU_PT_EVEN:
+			for (i = 0; i < n; i ++)
+				out[i] = offset*((((int)c[i]+1)/2)&1);
+			break;
+		default:
+			for (i = 0; i < n; i ++)
+				out[i] = 0.0f;
+			break;
+	}
+}
+
+static void clampRow(float* c, int n, u32 mode)
+{
+	int i;
+	switch (mode)
+	{
+		case GPU_PT_CLAMP_TO_ZERO:
+			for (i = 0; i < n; i ++)
+				c[i] = c[i] > 1.0f ? 0.0f : c[i];
+			break;
+		case GPU_PT_CLAMP_TO_EDGE:
+			for (i = 0; i < n; i ++)
+				c[i] = c[i] > 1.0f ? 1.0f : c[i];
+			break;
+		case GPU_PT_REPEAT:
+			for (i = 0; i < n; i ++)
+				c[i] -= floorf(c[i]);
+			break;
+		case GPU_PT_MIRRORED_REPEAT:
+			for (i = 0; i < n; i ++)
+			{
+				int whole = (int)c[i];
+				float frac = c[i] - whole;
+				c[i] = (whole&1) ? 1.0f-frac : frac;
+			}
+			break;
+		case GPU_PT_PULSE:
+			for (i = 0; i < n; i ++)
+				c[i] = c[i] > 0.5f ? 1.0f : 0.0f;
+			break;
+	}
+}
+
+static void combineRow(float* out, const float* u, const float* v, int n, u32 func, const C3D_ProcTexLut* lut)
+{
+	int i;
+	switch (func)
+	{
+		case GPU_PT_U:
+			for (i = 0; i < n; i ++)
+				out[i] = u[i];
+			break;
+		case GPU_PT_U2:
+			for (i = 0; i < n; i ++)
+				out[i] = u[i]*u[i];
+			break;
+		case GPU_PT_V:
+			for (i = 0; i < n; i ++)
+				out[i] = v[i];
+			break;
+		case GPU_PT_V2:
+			for (i = 0; i < n; i ++)
+				out[i] = v[i]*v[i];
+			break;
+		case GPU_PT_ADD:
+			for (i = 0; i < n; i ++)
+				out[i] = (u[i]+v[i])*0.5f;
+			break;
+		case GPU_PT_ADD2:
+			for (i = 0; i < n; i ++)
+				out[i] = (u[i]*u[i]+v[i]*v[i])*0.5f;
+			break;
+		case GPU_PT_SQRT2:
+			for (i = 0; i < n; i ++)
+				out[i] = fminf(sqrtf(u[i]*u[i]+v[i]*v[i]), 1.0f);
+			break;
+		case GPU_PT_MIN:
+			for (i = 0; i < n; i ++)
+				out[i] = fminf(u[i], v[i]);
+			break;
+		case GPU_PT_MAX:
+			for (i = 0; i < n; i ++)
+				out[i] = fmaxf(u[i], v[i]);
+			break;
+		case GPU_PT_RMAX:
+			for (i = 0; i < n; i ++)
+				out[i] = fminf(((u[i]+v[i])*0.5f + sqrtf(u[i]*u[i]+v[i]*v[i]))*0.5f, 1.0f);
+			break;
+		default:
+			for (i = 0; i < n; i ++)
+				out[i] = 0.0f;
+			break;
+	}
+
+	for (i = 0; i < n; i ++)
+		out[i] = lutLookup(lut, out[i]);
+}
+
+static void colorRow(u32* out, const float* f, int n, const C3D_ProcTex* pt, const C3D_ProcTexColorLut* lut)
+{
+	int i, j;
+	float base = pt->offset;
+	float scale = (int)pt->width - 1;
+
+	if (!lut)
+	{
+		for (i = 0; i < n; i ++)
+			out[i] = 0xFF000000 | (0x010101*(u32)(clamp01(f[i])*255.0f));
+		return;
+	}
+
+	for (i = 0; i < n; i ++)
+	{
+		float index = base + f[i]*scale;
+		if (index < 0.0f) index = 0.0f;
+		if (index > 255.0f) index = 255.0f;
+
+		if (!(pt->minFilter & 1))
+		{
+			out[i] = lut->color[(int)(index+0.5f)];
+			continue;
+		}
+
+		// The stored differences are halved, see ProcTexColorLut_Write
+		int k = (int)index;
+		float frac = index - k;
+		u32 color = lut->color[k];
+		u32 diff = lut->diff[k];
+		u32 res = 0;
+		for (j = 0; j < 32; j += 8)
+		{
+			int c = (int)(((color>>j)&0xFF) + frac*2*(s8)(diff>>j));
+			if (c < 0) c = 0;
+			if (c > 0xFF) c = 0xFF;
+			res |= (u32)c << j;
+		}
+		out[i] = res;
+	}
+}
+
+static void evalChunk(const C3D_ProcTexEval* ev, u32* out, const float* uin, const float* vin, int n)
+{
+	int i;
+	const C3D_ProcTex* pt = ev->pt;
+	float u[PT_CHUNK], v[PT_CHUNK];
+	float us[PT_CHUNK], vs[PT_CHUNK];
+	float f[PT_CHUNK];
+
+	for (i = 0; i < n; i ++)
+	{
+		u[i] = fabsf(uin[i]);
+		v[i] = fabsf(vin[i]);
+	}
+
+	// Shift offsets are derived from the coordinates before noise is applied
+	shiftRow(us, v, n, pt->uShift, pt->uClamp);
+	shiftRow(vs, u, n, pt->vShift, pt->vClamp);
+
+	if (pt->enableNoise)
+	{
+		C3Di_ProcTexNoise np;
+		np.freqU  = f16tof32(pt->uNoiseFreq);
+		np.freqV  = f16tof32(pt->vNoiseFreq);
+		np.phaseU = f16tof32(pt->uNoisePhase);
+		np.phaseV = f16tof32(pt->vNoisePhase);
+		np.amplU  = (s16)pt->uNoiseAmpl * (1.0f/0xFFF);
+		np.amplV  = (s16)pt->vNoiseAmpl * (1.0f/0xFFF);
+		for (i = 0; i < n; i ++)
+		{
+			float nu = noiseCoef(ev->noise, &np, u[i], v[i]);
+			float nv = noiseCoef(ev->noise, &np, v[i], u[i]);
+			u[i] = fabsf(u[i] + nu*np.amplU);
+			v[i] = fabsf(v[i] + nv*np.amplV);
+		}
+	}
+
+	for (i = 0; i < n; i ++)
+	{
+		u[i] += us[i];
+		v[i] += vs[i];
+	}
+	clampRow(u, n, pt->uClamp);
+	clampRow(v, n, pt->vClamp);
+
+	combineRow(f, u, v, n, pt->rgbFunc, ev->rgbMap);
+	colorRow(out, f, n, pt, ev->colorLut);
+
+	// Separate alpha bypasses the color LUT
+	if (pt->alphaSeparate)
+	{
+		combineRow(f, u, v, n, pt->alphaFunc, ev->alphaMap);
+		for (i = 0; i < n; i ++)
+			out[i] = (out[i]&0xFFFFFF) | ((u32)(clamp01(f[i])*255.0f)<<24);
+	}
+}
+
+u32 ProcTexEval_Sample(const C3D_ProcTexEval* ev, float u, float v)
+{
+	u32 out;
+	evalChunk(ev, &out, &u, &v, 1);
+	return out;
+}
+
+void ProcTexEval_Row(const C3D_ProcTexEval* ev, u32* out, const float* u, const float* v, int count)
+{
+	int i;
+	for (i = 0; i < count; i += PT_CHUNK)
+	{
+		int n = count-i < PT_CHUNK ? count-i : PT_CHUNK;
+		evalChunk(ev, &out[i], &u[i], &v[i], n);
+	}
+}
+
+static inline u32 tileOffset(u32 x, u32 y, u32 width)
+{
+	u32 tile = (y>>3)*(width>>3) + (x>>3);
+	u32 morton = (x&1) | ((y&1)<<1) | ((x&2)<<1) | ((y&2)<<2) | ((x&4)<<2) | ((y&4)<<3);
+	return tile*64 + morton;
+}
+
+static inline void storeTexel(u8* dst, u32 c, GPU_TEXCOLOR fmt)
+{
+	u32 r = c&0xFF, g = (c>>8)&0xFF, b = (c>>16)&0xFF, a = c>>24;
+	switch (fmt)
+	{
+		case GPU_RGBA8:
+			dst[0] = a;
+			dst[1] = b;
+			dst[2] = g;
+			dst[3] = r;
+			break;
+		case GPU_RGB8:
+			dst[0] = b;
+			dst[1] = g;
+			dst[2] = r;
+			break;
+		case GPU_RGBA5551:
+			*(u16*)dst = ((r>>3)<<11) | ((g>>3)<<6) | ((b>>3)<<1) | (a>>7);
+			break;
+		case GPU_RGB565:
+			*(u16*)dst = ((r>>3)<<11) | ((g>>2)<<5) | (b>>3);
+			break;
+		case GPU_RGBA4:
+			*(u16*)dst = ((r>>4)<<12) | ((g>>4)<<8) | ((b>>4)<<4) | (a>>4);
+			break;
+		default:
+			break;
+	}
+}
+
+bool ProcTexEval_Bake(const C3D_ProcTexEval* ev, C3D_Tex* tex, float u0, float v0, float u1, float v1)
+{
+	int x, y, i;
+	u32 bpp;
+	float u[PT_CHUNK], v[PT_CHUNK];
+	u32 color[PT_CHUNK];
+
+	if (!C3Di_TexIs2D(tex))
+		return false;
+
+	switch (tex->fmt)
+	{
+		case GPU_RGBA8:    bpp = 4; break;
+		case GPU_RGB8:     bpp = 3; break;
+		case GPU_RGBA5551:
+		case GPU_RGB565:
+		case GPU_RGBA4:    bpp = 2; break;
+		default:           return false;
+	}
+
+	int w = tex->width, h = tex->height;
+	float du = (u1-u0)/w;
+	float dv = (v1-v0)/h;
+	u8* data = (u8*)tex->data;
+
+	for (y = 0; y < h; y ++)
+	{
+		// Memory row 0 is the top of the texture (v≈v1)
+		float vy = v0 + (h-1-y+0.5f)*dv;
+		for (x = 0; x < w; x += PT_CHUNK)
+		{
+			int n = w-x < PT_CHUNK ? w-x : PT_CHUNK;
+			for (i = 0; i < n; i ++)
+			{
+				u[i] = u0 + (x+i+0.5f)*du;
+				v[i] = vy;
+			}
+			evalChunk(ev, color, u, v, n);
+			for (i = 0; i < n; i ++)
+				storeTexel(data + tileOffset(x+i, y, w)*bpp, color[i], tex->fmt);
+		}
+	}
+
+	C3D_TexFlush(tex);
+	return true;
+}
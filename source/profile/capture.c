@@ -0,0 +1,372 @@
+#include <c3d/capture.h>
+#include <c3d/cmdstream.h>
+#include <c3d/profile.h>
+#include <3ds/gpu/registers.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+	u32 start, end;
+} CaptureSpan;
+
+typedef struct
+{
+	CaptureSpan* spans;
+	u32 count, capacity;
+} CaptureSpanList;
+
+static bool C3Di_SpanAdd(CaptureSpanList* list, u32 start, u32 size)
+{
+	if (!size) return true;
+	if (list->count == list->capacity)
+	{
+		u32 capacity = list->capacity ? list->capacity*2 : 64;
+		CaptureSpan* spans = (CaptureSpan*)realloc(list->spans, capacity*sizeof(CaptureSpan));
+		if (!spans) return false;
+		list->spans = spans;
+		list->capacity = capacity;
+	}
+	list->spans[list->count].start = start;
+	list->spans[list->count].end = start + size;
+	list->count ++;
+	return true;
+}
+
+static int C3Di_SpanCompare(const void* a, const void* b)
+{
+	u32 sa = ((const CaptureSpan*)a)->start, sb = ((const CaptureSpan*)b)->start;
+	return sa < sb ? -1 : sa > sb ? 1 : 0;
+}
+
+static u32 C3Di_TexBitsPerPixel(u32 fmt)
+{
+	static const u8 bpp[] = { 32, 24, 16, 16, 16, 16, 16, 8, 8, 8, 4, 4, 4, 8 };
+	fmt &= 0xF;
+	return fmt < sizeof(bpp) ? bpp[fmt] : 0;
+}
+
+static u32 C3Di_TexSize(u32 dim, u32 lod, u32 fmt)
+{
+	u32 width = dim >> 16, height = dim & 0x7FF;
+	u32 maxLevel = (lod >> 16) & 0xF;
+	u32 bpp = C3Di_TexBitsPerPixel(fmt);
+	u32 size = 0, i;
+	for (i = 0; i <= maxLevel && width >= 8 && height >= 8; i ++, width /= 2, height /= 2)
+		size += width*height*bpp/8;
+	return size;
+}
+
+static bool C3Di_CaptureTextures(CaptureSpanList* list, const u32* regs)
+{
+	static const u16 units[3][4] =
+	{
+		{ GPUREG_TEXUNIT0_DIM, GPUREG_TEXUNIT0_LOD, GPUREG_TEXUNIT0_ADDR1, GPUREG_TEXUNIT0_TYPE },
+		{ GPUREG_TEXUNIT1_DIM, GPUREG_TEXUNIT1_LOD, GPUREG_TEXUNIT1_ADDR,  GPUREG_TEXUNIT1_TYPE },
+		{ GPUREG_TEXUNIT2_DIM, GPUREG_TEXUNIT2_LOD, GPUREG_TEXUNIT2_ADDR,  GPUREG_TEXUNIT2_TYPE },
+	};
+	int i, j;
+	for (i = 0; i < 3; i ++)
+	{
+		if (!(regs[GPUREG_TEXUNIT_CONFIG] & (1 << i)))
+			continue;
+		u32 size = C3Di_TexSize(regs[units[i][0]], regs[units[i][1]], regs[units[i][3]]);
+		u32 addr = regs[units[i][2]];
+		if (!C3Di_SpanAdd(list, addr << 3, size))
+			return false;
+
+		// Cube maps are only supported by unit 0; the other faces share the upper address bits of the first one
+		u32 type = (regs[GPUREG_TEXUNIT0_PARAM] >> 28) & 7;
+		if (i == 0 && (type == 1 || type == 4))
+		{
+			for (j = 1; j < 6; j ++)
+			{
+				u32 face = (addr &~ 0x3FFFFF) | (regs[GPUREG_TEXUNIT0_ADDR1+j] & 0x3FFFFF);
+				if (!C3Di_SpanAdd(list, face << 3, size))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool C3Di_CaptureDraw(CaptureSpanList* list, const u32* regs, bool elements, C3D_CaptureResolveCb resolve, void* user)
+{
+	u32 base = regs[GPUREG_ATTRIBBUFFERS_LOC] << 3;
+	u32 count = regs[GPUREG_NUMVERTICES];
+	u32 numVertices = regs[GPUREG_VERTEX_OFFSET] + count;
+	int i;
+
+	if (elements)
+	{
+		u32 config = regs[GPUREG_INDEXBUFFER_CONFIG];
+		u32 indexAddr = base + (config & 0x0FFFFFFF);
+		u32 indexSize = (config >> 31) ? 2 : 1;
+		if (!C3Di_SpanAdd(list, indexAddr, count*indexSize))
+			return false;
+
+		// The vertex range depends on the largest index
+		const void* indices = resolve(indexAddr, count*indexSize, user);
+		numVertices = 0;
+		for (i = 0; indices && i < (int)count; i ++)
+		{
+			u32 index = indexSize == 2 ? ((const u16*)indices)[i] : ((const u8*)indices)[i];
+			if (index >= numVertices)
+				numVertices = index+1;
+		}
+	}
+
+	for (i = 0; i < 12; i ++)
+	{
+		u32 offset = regs[GPUREG_ATTRIBBUFFER0_OFFSET+i*3];
+		u32 config2 = regs[GPUREG_ATTRIBBUFFER0_OFFSET+i*3+2];
+		u32 stride = (config2 >> 16) & 0xFF;
+		if (!(config2 >> 28) || !stride)
+			continue;
+		if (!C3Di_SpanAdd(list, base + offset, numVertices*stride))
+			return false;
+	}
+
+	return C3Di_CaptureTextures(list, regs);
+}
+
+bool C3D_CaptureAddList(C3D_Capture* cap, const u32* words, u32 numWords)
+{
+	C3D_CaptureList* lists = (C3D_CaptureList*)realloc(cap->lists, (cap->numLists+1)*sizeof(C3D_CaptureList));
+	if (!lists) return false;
+	cap->lists = lists;
+
+	u32* copy = (u32*)malloc(numWords*4 + 4);
+	if (!copy) return false;
+	memcpy(copy, words, numWords*4);
+	lists[cap->numLists].words = copy;
+	lists[cap->numLists].numWords = numWords;
+	cap->numLists ++;
+	return true;
+}
+
+bool C3D_CaptureAddMemory(C3D_Capture* cap, C3D_CaptureResolveCb resolve, void* user)
+{
+	CaptureSpanList list = { NULL, 0, 0 };
+	C3D_CmdWrite* writes = NULL;
+	u32* regs = (u32*)calloc(C3D_CMD_NUM_REGS, sizeof(u32));
+	bool ok = regs != NULL;
+	u32 i, j;
+	C3D_PROFILE_SCOPE("C3D_CaptureAddMemory");
+
+	// Replay the register writes of every list, recording what each draw reads
+	for (i = 0; ok && i < cap->numLists; i ++)
+	{
+		const C3D_CaptureList* l = &cap->lists[i];
+		u32 count = C3D_CmdDecode(l->words, l->numWords, NULL, 0);
+		free(writes);
+		writes = (C3D_CmdWrite*)malloc(count*sizeof(C3D_CmdWrite) + 1);
+		if (!writes)
+		{
+			ok = false;
+			break;
+		}
+		C3D_CmdDecode(l->words, l->numWords, writes, count);
+
+		for (j = 0; ok && j < count; j ++)
+		{
+			const C3D_CmdWrite* w = &writes[j];
+			u32 bytes = (w->mask & 1 ? 0xFF : 0) | (w->mask & 2 ? 0xFF00 : 0) | (w->mask & 4 ? 0xFF0000 : 0) | (w->mask & 8 ? 0xFF000000 : 0);
+			regs[w->reg] = (regs[w->reg] &~ bytes) | (w->value & bytes);
+			if (w->reg == GPUREG_DRAWARRAYS || w->reg == GPUREG_DRAWELEMENTS)
+				ok = C3Di_CaptureDraw(&list, regs, w->reg == GPUREG_DRAWELEMENTS, resolve, user);
+		}
+	}
+	free(writes);
+	free(regs);
+
+	// Include the ranges captured so far, then merge everything into disjoint ranges
+	for (i = 0; ok && i < cap->numRanges; i ++)
+		ok = C3Di_SpanAdd(&list, cap->ranges[i].paddr, cap->ranges[i].size);
+	if (!ok)
+	{
+		free(list.spans);
+		return false;
+	}
+
+	qsort(list.spans, list.count, sizeof(CaptureSpan), C3Di_SpanCompare);
+	u32 numMerged = 0;
+	for (i = 0; i < list.count; i ++)
+	{
+		if (numMerged && list.spans[i].start <= list.spans[numMerged-1].end)
+		{
+			if (list.spans[i].end > list.spans[numMerged-1].end)
+				list.spans[numMerged-1].end = list.spans[i].end;
+		} else
+			list.spans[numMerged++] = list.spans[i];
+	}
+
+	C3D_CaptureRange* ranges = (C3D_CaptureRange*)calloc(numMerged + 1, sizeof(C3D_CaptureRange));
+	u32 numRanges = 0, prev = 0;
+	for (i = 0; ranges && i < numMerged; i ++)
+	{
+		u32 start = list.spans[i].start, size = list.spans[i].end - start;
+		u32 firstPrev = prev;
+		while (prev < cap->numRanges && cap->ranges[prev].paddr < list.spans[i].end)
+			prev ++;
+
+		const void* src = resolve(start, size, user);
+		if (!src && !C3D_CaptureResolve(start, size, cap))
+			continue; // Not in accessible memory, e.g. a bogus address of a disabled unit
+
+		C3D_CaptureRange* r = &ranges[numRanges];
+		r->data = malloc(size);
+		if (!r->data)
+			break;
+		if (src)
+			memcpy(r->data, src, size);
+
+		// Memory captured by earlier calls keeps the contents it had then
+		for (j = firstPrev; j < prev; j ++)
+		{
+			const C3D_CaptureRange* p = &cap->ranges[j];
+			if (p->paddr < start)
+				continue;
+			memcpy((u8*)r->data + (p->paddr - start), p->data, p->size);
+			r->flags |= p->flags;
+		}
+		r->paddr = start;
+		r->size = size;
+		numRanges ++;
+	}
+	free(list.spans);
+
+	if (!ranges || i < numMerged)
+	{
+		for (j = 0; j < numRanges; j ++)
+			free(ranges[j].data);
+		free(ranges);
+		return false;
+	}
+
+	for (i = 0; i < cap->numRanges; i ++)
+		free(cap->ranges[i].data);
+	free(cap->ranges);
+	cap->ranges = ranges;
+	cap->numRanges = numRanges;
+	return true;
+}
+
+u32 C3D_CaptureMarkRewritten(C3D_Capture* cap, C3D_CaptureResolveCb resolve, void* user)
+{
+	u32 count = 0, i;
+	for (i = 0; i < cap->numRanges; i ++)
+	{
+		C3D_CaptureRange* r = &cap->ranges[i];
+		const void* src = resolve(r->paddr, r->size, user);
+		if (src && memcmp(src, r->data, r->size) != 0)
+			r->flags |= C3D_CAPTURERANGE_REWRITTEN;
+		if (r->flags & C3D_CAPTURERANGE_REWRITTEN)
+			count ++;
+	}
+	return count;
+}
+
+const void* C3D_CaptureResolve(u32 paddr, u32 size, void* user)
+{
+	const C3D_Capture* cap = (const C3D_Capture*)user;
+	u32 lo = 0, hi = cap->numRanges;
+	while (lo < hi)
+	{
+		u32 mid = (lo + hi) / 2;
+		const C3D_CaptureRange* r = &cap->ranges[mid];
+		if (paddr < r->paddr)
+			hi = mid;
+		else if (paddr - r->paddr >= r->size)
+			lo = mid + 1;
+		else
+			return size <= r->size - (paddr - r->paddr) ? (const u8*)r->data + (paddr - r->paddr) : NULL;
+	}
+	return NULL;
+}
+
+bool C3D_CaptureSave(const C3D_Capture* cap, const char* path)
+{
+	FILE* f = fopen(path, "wb");
+	if (!f) return false;
+
+	u32 header[4] = { C3D_CAPTURE_MAGIC, C3D_CAPTURE_VERSION, cap->numLists, cap->numRanges };
+	bool ok = fwrite(header, sizeof(header), 1, f) == 1;
+	u32 i;
+	for (i = 0; ok && i < cap->numLists; i ++)
+	{
+		const C3D_CaptureList* l = &cap->lists[i];
+		ok = fwrite(&l->numWords, 4, 1, f) == 1 && fwrite(l->words, 4, l->numWords, f) == l->numWords;
+	}
+	for (i = 0; ok && i < cap->numRanges; i ++)
+	{
+		const C3D_CaptureRange* r = &cap->ranges[i];
+		static const u8 pad[4];
+		ok = fwrite(&r->paddr, 4, 1, f) == 1 && fwrite(&r->size, 4, 1, f) == 1 && fwrite(&r->flags, 4, 1, f) == 1
+			&& fwrite(r->data, 1, r->size, f) == r->size
+			&& fwrite(pad, 1, -r->size & 3, f) == (-r->size & 3);
+	}
+
+	if (fclose(f) != 0)
+		ok = false;
+	return ok;
+}
+
+bool C3D_CaptureLoad(C3D_Capture* cap, const char* path)
+{
+	memset(cap, 0, sizeof(*cap));
+	FILE* f = fopen(path, "rb");
+	if (!f) return false;
+
+	u32 header[4];
+	bool ok = fread(header, sizeof(header), 1, f) == 1
+		&& header[0] == C3D_CAPTURE_MAGIC && header[1] >= 1 && header[1] <= C3D_CAPTURE_VERSION
+		&& header[2] < 0x100000 && header[3] < 0x100000; // Keeps the allocations below from wrapping
+	if (ok)
+	{
+		cap->lists = (C3D_CaptureList*)calloc(header[2] + 1, sizeof(C3D_CaptureList));
+		cap->ranges = (C3D_CaptureRange*)calloc(header[3] + 1, sizeof(C3D_CaptureRange));
+		ok = cap->lists && cap->ranges;
+	}
+
+	u32 i;
+	for (i = 0; ok && i < header[2]; i ++)
+	{
+		C3D_CaptureList* l = &cap->lists[i];
+		ok = fread(&l->numWords, 4, 1, f) == 1 && l->numWords < 0x4000000
+			&& (l->words = (u32*)malloc(l->numWords*4 + 4)) != NULL;
+		if (ok)
+			cap->numLists ++;
+		ok = ok && fread(l->words, 4, l->numWords, f) == l->numWords;
+	}
+	for (i = 0; ok && i < header[3]; i ++)
+	{
+		C3D_CaptureRange* r = &cap->ranges[i];
+		u8 pad[4];
+		ok = fread(&r->paddr, 4, 1, f) == 1 && fread(&r->size, 4, 1, f) == 1 && r->size < 0x10000000
+			&& (header[1] < 2 || fread(&r->flags, 4, 1, f) == 1)
+			&& (r->data = malloc(r->size + 1)) != NULL;
+		if (ok)
+			cap->numRanges ++;
+		ok = ok && fread(r->data, 1, r->size, f) == r->size
+			&& fread(pad, 1, -r->size & 3, f) == (-r->size & 3);
+	}
+
+	fclose(f);
+	if (!ok)
+		C3D_CaptureFree(cap);
+	return ok;
+}
+
+void C3D_CaptureFree(C3D_Capture* cap)
+{
+	u32 i;
+	for (i = 0; i < cap->numLists; i ++)
+		free(cap->lists[i].words);
+	for (i = 0; i < cap->numRanges; i ++)
+		free(cap->ranges[i].data);
+	free(cap->lists);
+	free(cap->ranges);
+	memset(cap, 0, sizeof(*cap));
+}
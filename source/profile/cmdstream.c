@@ -0,0 +1,286 @@
+#include <c3d/cmdstream.h>
+#include <c3d/profile.h>
+#include <3ds/gpu/registers.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REG(_n) [GPUREG_##_n] = "GPUREG_" #_n
+
+#define TEXENV(_n) \
+	[GPUREG_TEXENV##_n##_SOURCE+0] = "GPUREG_TEXENV" #_n "_SOURCE", \
+	[GPUREG_TEXENV##_n##_SOURCE+1] = "GPUREG_TEXENV" #_n "_OPERAND", \
+	[GPUREG_TEXENV##_n##_SOURCE+2] = "GPUREG_TEXENV" #_n "_COMBINER", \
+	[GPUREG_TEXENV##_n##_SOURCE+3] = "GPUREG_TEXENV" #_n "_COLOR", \
+	[GPUREG_TEXENV##_n##_SOURCE+4] = "GPUREG_TEXENV" #_n "_SCALE"
+
+#define LIGHT(_n) \
+	[GPUREG_LIGHT0_SPECULAR0+_n*0x10+0x0] = "GPUREG_LIGHT" #_n "_SPECULAR0", \
+	[GPUREG_LIGHT0_SPECULAR0+_n*0x10+0x1] = "GPUREG_LIGHT" #_n "_SPECULAR1", \
+	[GPUREG_LIGHT0_SPECULAR0+_n*0x10+0x2] = "GPUREG_LIGHT" #_n "_DIFFUSE", \
+	[GPUREG_LIGHT0_SPECULAR0+_n*0x10+0x3] = "GPUREG_LIGHT" #_n "_AMBIENT", \
+	[GPUREG_LIGHT0_SPECULAR0+_n*0x10+0x4] = "GPUREG_LIGHT" #_n "_XY", \
+	[GPUREG_LIGHT0_SPECULAR0+_n*0x10+0x5] = "GPUREG_LIGHT" #_n "_Z", \
+	[GPUREG_LIGHT0_SPECULAR0+_n*0x10+0x6] = "GPUREG_LIGHT" #_n "_SPOTDIR_XY", \
+	[GPUREG_LIGHT0_SPECULAR0+_n*0x10+0x7] = "GPUREG_LIGHT" #_n "_SPOTDIR_Z", \
+	[GPUREG_LIGHT0_SPECULAR0+_n*0x10+0x9] = "GPUREG_LIGHT" #_n "_CONFIG", \
+	[GPUREG_LIGHT0_SPECULAR0+_n*0x10+0xA] = "GPUREG_LIGHT" #_n "_ATTENUATION_BIAS", \
+	[GPUREG_LIGHT0_SPECULAR0+_n*0x10+0xB] = "GPUREG_LIGHT" #_n "_ATTENUATION_SCALE"
+
+#define ATTRIBBUFFER(_n) \
+	[GPUREG_ATTRIBBUFFER0_OFFSET+_n*3+0] = "GPUREG_ATTRIBBUFFER" #_n "_OFFSET", \
+	[GPUREG_ATTRIBBUFFER0_OFFSET+_n*3+1] = "GPUREG_ATTRIBBUFFER" #_n "_CONFIG1", \
+	[GPUREG_ATTRIBBUFFER0_OFFSET+_n*3+2] = "GPUREG_ATTRIBBUFFER" #_n "_CONFIG2"
+
+static const char* const regNames[C3D_CMD_NUM_REGS] =
+{
+	REG(FINALIZE),
+	REG(FACECULLING_CONFIG),
+	REG(VIEWPORT_WIDTH), REG(VIEWPORT_INVW), REG(VIEWPORT_HEIGHT), REG(VIEWPORT_INVH),
+	REG(FRAGOP_CLIP), REG(FRAGOP_CLIP_DATA0),
+	REG(DEPTHMAP_SCALE), REG(DEPTHMAP_OFFSET),
+	REG(SH_OUTMAP_TOTAL), REG(SH_OUTMAP_O0),
+	REG(EARLYDEPTH_FUNC), REG(EARLYDEPTH_TEST1), REG(EARLYDEPTH_CLEAR),
+	REG(SH_OUTATTR_MODE),
+	REG(SCISSORTEST_MODE), REG(SCISSORTEST_POS), REG(SCISSORTEST_DIM),
+	REG(VIEWPORT_XY),
+	REG(EARLYDEPTH_DATA),
+	REG(DEPTHMAP_ENABLE),
+	REG(RENDERBUF_DIM),
+	REG(SH_OUTATTR_CLOCK),
+	REG(TEXUNIT_CONFIG),
+	REG(TEXUNIT0_BORDER_COLOR), REG(TEXUNIT0_DIM), REG(TEXUNIT0_PARAM), REG(TEXUNIT0_LOD),
+	REG(TEXUNIT0_ADDR1), REG(TEXUNIT0_ADDR2), REG(TEXUNIT0_ADDR3),
+	REG(TEXUNIT0_ADDR4), REG(TEXUNIT0_ADDR5), REG(TEXUNIT0_ADDR6),
+	REG(TEXUNIT0_SHADOW), REG(TEXUNIT0_TYPE),
+	REG(LIGHTING_ENABLE0),
+	REG(TEXUNIT1_BORDER_COLOR), REG(TEXUNIT1_DIM), REG(TEXUNIT1_PARAM), REG(TEXUNIT1_LOD),
+	REG(TEXUNIT1_ADDR), REG(TEXUNIT1_TYPE),
+	REG(TEXUNIT2_BORDER_COLOR), REG(TEXUNIT2_DIM), REG(TEXUNIT2_PARAM), REG(TEXUNIT2_LOD),
+	REG(TEXUNIT2_ADDR), REG(TEXUNIT2_TYPE),
+	REG(TEXUNIT3_PROCTEX0), REG(TEXUNIT3_PROCTEX1), REG(TEXUNIT3_PROCTEX2),
+	REG(TEXUNIT3_PROCTEX3), REG(TEXUNIT3_PROCTEX4), REG(TEXUNIT3_PROCTEX5),
+	REG(PROCTEX_LUT),
+	TEXENV(0), TEXENV(1), TEXENV(2), TEXENV(3), TEXENV(4), TEXENV(5),
+	REG(TEXENV_UPDATE_BUFFER), REG(FOG_COLOR),
+	REG(GAS_ATTENUATION), REG(GAS_ACCMAX),
+	REG(FOG_LUT_INDEX),
+	REG(TEXENV_BUFFER_COLOR),
+	REG(COLOR_OPERATION), REG(BLEND_FUNC), REG(LOGIC_OP), REG(BLEND_COLOR),
+	REG(FRAGOP_ALPHA_TEST), REG(STENCIL_TEST), REG(STENCIL_OP), REG(DEPTH_COLOR_MASK),
+	REG(FRAMEBUFFER_INVALIDATE), REG(FRAMEBUFFER_FLUSH),
+	REG(COLORBUFFER_READ), REG(COLORBUFFER_WRITE), REG(DEPTHBUFFER_READ), REG(DEPTHBUFFER_WRITE),
+	REG(DEPTHBUFFER_FORMAT), REG(COLORBUFFER_FORMAT),
+	REG(EARLYDEPTH_TEST2),
+	REG(FRAMEBUFFER_BLOCK32),
+	REG(DEPTHBUFFER_LOC), REG(COLORBUFFER_LOC), REG(FRAMEBUFFER_DIM),
+	REG(FRAGOP_SHADOW),
+	LIGHT(0), LIGHT(1), LIGHT(2), LIGHT(3), LIGHT(4), LIGHT(5), LIGHT(6), LIGHT(7),
+	REG(LIGHTING_AMBIENT), REG(LIGHTING_NUM_LIGHTS),
+	REG(LIGHTING_CONFIG0), REG(LIGHTING_CONFIG1),
+	REG(LIGHTING_LUT_INDEX), REG(LIGHTING_ENABLE1),
+	REG(LIGHTING_LUTINPUT_ABS), REG(LIGHTING_LUTINPUT_SELECT), REG(LIGHTING_LUTINPUT_SCALE),
+	REG(LIGHTING_LIGHT_PERMUTATION),
+	REG(ATTRIBBUFFERS_LOC), REG(ATTRIBBUFFERS_FORMAT_LOW), REG(ATTRIBBUFFERS_FORMAT_HIGH),
+	ATTRIBBUFFER(0), ATTRIBBUFFER(1), ATTRIBBUFFER(2), ATTRIBBUFFER(3),
+	ATTRIBBUFFER(4), ATTRIBBUFFER(5), ATTRIBBUFFER(6), ATTRIBBUFFER(7),
+	ATTRIBBUFFER(8), ATTRIBBUFFER(9), ATTRIBBUFFER(10), ATTRIBBUFFER(11),
+	REG(INDEXBUFFER_CONFIG), REG(NUMVERTICES), REG(GEOSTAGE_CONFIG), REG(VERTEX_OFFSET),
+	REG(POST_VERTEX_CACHE_NUM),
+	REG(DRAWARRAYS), REG(DRAWELEMENTS),
+	REG(VTX_FUNC),
+	REG(FIXEDATTRIB_INDEX),
+	REG(CMDBUF_SIZE0), REG(CMDBUF_ADDR0), REG(CMDBUF_JUMP0),
+	REG(VSH_NUM_ATTR), REG(VSH_COM_MODE),
+	REG(START_DRAW_FUNC0),
+	REG(VSH_OUTMAP_TOTAL1), REG(VSH_OUTMAP_TOTAL2),
+	REG(GSH_MISC0), REG(GEOSTAGE_CONFIG2), REG(GSH_MISC1),
+	REG(PRIMITIVE_CONFIG), REG(RESTART_PRIMITIVE),
+	REG(GSH_BOOLUNIFORM), REG(GSH_INTUNIFORM_I0),
+	REG(GSH_INPUTBUFFER_CONFIG), REG(GSH_ENTRYPOINT),
+	REG(GSH_FLOATUNIFORM_CONFIG),
+	REG(GSH_CODETRANSFER_CONFIG),
+	REG(GSH_OPDESCS_CONFIG),
+	REG(VSH_BOOLUNIFORM),
+	REG(VSH_INTUNIFORM_I0), REG(VSH_INTUNIFORM_I1), REG(VSH_INTUNIFORM_I2), REG(VSH_INTUNIFORM_I3),
+	REG(VSH_INPUTBUFFER_CONFIG), REG(VSH_ENTRYPOINT),
+	REG(VSH_ATTRIBUTES_PERMUTATION_LOW), REG(VSH_ATTRIBUTES_PERMUTATION_HIGH),
+	REG(VSH_OUTMAP_MASK),
+	REG(VSH_CODETRANSFER_END),
+	REG(VSH_FLOATUNIFORM_CONFIG),
+	REG(VSH_CODETRANSFER_CONFIG),
+	REG(VSH_OPDESCS_CONFIG),
+};
+
+// Data ports stream into memory behind an auto-incrementing index, so repeated writes are not redundant
+static const struct
+{
+	u16 base, count;
+	const char* name;
+} dataPorts[] =
+{
+	{ GPUREG_PROCTEX_LUT_DATA0,       8, "GPUREG_PROCTEX_LUT_DATA"       },
+	{ GPUREG_FOG_LUT_DATA0,           8, "GPUREG_FOG_LUT_DATA"           },
+	{ GPUREG_LIGHTING_LUT_DATA0,      8, "GPUREG_LIGHTING_LUT_DATA"      },
+	{ GPUREG_FIXEDATTRIB_DATA0,       3, "GPUREG_FIXEDATTRIB_DATA"       },
+	{ GPUREG_GSH_FLOATUNIFORM_DATA,   8, "GPUREG_GSH_FLOATUNIFORM_DATA"  },
+	{ GPUREG_GSH_CODETRANSFER_DATA,   8, "GPUREG_GSH_CODETRANSFER_DATA"  },
+	{ GPUREG_GSH_OPDESCS_DATA,        8, "GPUREG_GSH_OPDESCS_DATA"       },
+	{ GPUREG_VSH_FLOATUNIFORM_DATA,   8, "GPUREG_VSH_FLOATUNIFORM_DATA"  },
+	{ GPUREG_VSH_CODETRANSFER_DATA,   8, "GPUREG_VSH_CODETRANSFER_DATA"  },
+	{ GPUREG_VSH_OPDESCS_DATA,        8, "GPUREG_VSH_OPDESCS_DATA"       },
+};
+
+enum
+{
+	REGCLASS_STATE,
+	REGCLASS_PORT,    // Data ports and the index registers that address them
+	REGCLASS_TRIGGER, // Writes that act on the current state instead of storing a value
+};
+
+static int C3Di_CmdRegClass(u16 reg)
+{
+	unsigned i;
+	for (i = 0; i < sizeof(dataPorts)/sizeof(dataPorts[0]); i ++)
+		if (reg >= dataPorts[i].base && reg < dataPorts[i].base + dataPorts[i].count)
+			return reg == GPUREG_FIXEDATTRIB_DATA0+2 ? REGCLASS_TRIGGER : REGCLASS_PORT;
+
+	switch (reg)
+	{
+		case GPUREG_PROCTEX_LUT:
+		case GPUREG_FOG_LUT_INDEX:
+		case GPUREG_LIGHTING_LUT_INDEX:
+		case GPUREG_FIXEDATTRIB_INDEX:
+		case GPUREG_GSH_FLOATUNIFORM_CONFIG:
+		case GPUREG_GSH_CODETRANSFER_CONFIG:
+		case GPUREG_GSH_OPDESCS_CONFIG:
+		case GPUREG_VSH_FLOATUNIFORM_CONFIG:
+		case GPUREG_VSH_CODETRANSFER_CONFIG:
+		case GPUREG_VSH_OPDESCS_CONFIG:
+			return REGCLASS_PORT;
+		case GPUREG_FINALIZE:
+		case GPUREG_EARLYDEPTH_CLEAR:
+		case GPUREG_FRAMEBUFFER_INVALIDATE:
+		case GPUREG_FRAMEBUFFER_FLUSH:
+		case GPUREG_DRAWARRAYS:
+		case GPUREG_DRAWELEMENTS:
+		case GPUREG_VTX_FUNC:
+		case GPUREG_CMDBUF_JUMP0:
+		case GPUREG_CMDBUF_JUMP0+1:
+		case GPUREG_RESTART_PRIMITIVE:
+		case GPUREG_VSH_CODETRANSFER_END:
+			return REGCLASS_TRIGGER;
+	}
+	return REGCLASS_STATE;
+}
+
+const char* C3D_CmdRegName(u16 reg)
+{
+	unsigned i;
+	if (reg >= C3D_CMD_NUM_REGS)
+		return NULL;
+	if (regNames[reg])
+		return regNames[reg];
+	for (i = 0; i < sizeof(dataPorts)/sizeof(dataPorts[0]); i ++)
+		if (reg >= dataPorts[i].base && reg < dataPorts[i].base + dataPorts[i].count)
+			return dataPorts[i].name;
+	return NULL;
+}
+
+u32 C3D_CmdDecode(const u32* cmdBuf, u32 numWords, C3D_CmdWrite* out, u32 maxWrites)
+{
+	u32 pos = 0, count = 0;
+	while (pos + 2 <= numWords)
+	{
+		u32 header = cmdBuf[pos+1];
+		u32 numParams = ((header >> 20) & 0xFF) + 1;
+		u32 size = (numParams + 2) &~ 1; // Commands are padded to a multiple of 8 bytes
+		if (pos + size > numWords)
+			break;
+
+		u16 reg = header & 0x3FF;
+		bool incremental = (header >> 31) != 0;
+		u32 i;
+		for (i = 0; i < numParams; i ++, count ++)
+		{
+			if (count >= maxWrites) continue;
+			C3D_CmdWrite* w = &out[count];
+			w->offset = pos;
+			w->reg    = incremental ? (reg + i) & 0x3FF : reg;
+			w->mask   = (header >> 16) & 0xF;
+			w->flags  = 0;
+			w->value  = i ? cmdBuf[pos+1+i] : cmdBuf[pos];
+		}
+		pos += size;
+	}
+	return count;
+}
+
+typedef struct
+{
+	u32 value[C3D_CMD_NUM_REGS];
+	u32 pending[C3D_CMD_NUM_REGS]; // Index+1 of the last write that nothing has used yet
+	u32 epoch[C3D_CMD_NUM_REGS];
+	u8 known[C3D_CMD_NUM_REGS];    // Byte mask of the value bytes written so far
+} C3Di_CmdState;
+
+static inline u32 C3Di_ByteMask(u8 mask)
+{
+	return (mask & 1 ? 0xFF : 0) | (mask & 2 ? 0xFF00 : 0) | (mask & 4 ? 0xFF0000 : 0) | (mask & 8 ? 0xFF000000 : 0);
+}
+
+bool C3D_CmdAnalyze(C3D_CmdWrite* writes, u32 count, C3D_CmdStats* stats)
+{
+	C3Di_CmdState* st = (C3Di_CmdState*)calloc(1, sizeof(C3Di_CmdState));
+	if (!st) return false;
+	C3D_PROFILE_SCOPE("C3D_CmdAnalyze");
+
+	memset(stats, 0, sizeof(*stats));
+	stats->writes = count;
+
+	// Triggers start a new epoch; writes pending from an older epoch have been used
+	u32 epoch = 1;
+	u32 i;
+	for (i = 0; i < count; i ++)
+	{
+		C3D_CmdWrite* w = &writes[i];
+		u16 reg = w->reg;
+		stats->regWrites[reg] ++;
+
+		int cls = C3Di_CmdRegClass(reg);
+		if (cls == REGCLASS_TRIGGER)
+		{
+			if (reg == GPUREG_DRAWARRAYS || reg == GPUREG_DRAWELEMENTS)
+				stats->draws ++;
+			epoch ++;
+			continue;
+		}
+		if (cls != REGCLASS_STATE)
+			continue;
+
+		stats->stateWrites ++;
+		u32 bytes = C3Di_ByteMask(w->mask);
+		if ((st->known[reg] & w->mask) == w->mask && ((st->value[reg] ^ w->value) & bytes) == 0)
+		{
+			w->flags |= C3D_CMDWRITE_REDUNDANT;
+			stats->redundant ++;
+		}
+
+		u32 prev = st->pending[reg];
+		if (prev && st->epoch[reg] == epoch && (writes[prev-1].mask &~ w->mask) == 0 && w->mask)
+		{
+			writes[prev-1].flags |= C3D_CMDWRITE_OVERWRITTEN;
+			stats->overwritten ++;
+		}
+
+		st->value[reg] = (st->value[reg] &~ bytes) | (w->value & bytes);
+		st->known[reg] |= w->mask;
+		if (w->mask)
+		{
+			st->pending[reg] = i+1;
+			st->epoch[reg] = epoch;
+		}
+	}
+
+	free(st);
+	return true;
+}
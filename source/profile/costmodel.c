@@ -0,0 +1,224 @@
+#include <c3d/costmodel.h>
+#include <c3d/profile.h>
+#include <3ds/types.h>
+#include <3ds/gpu/enums.h>
+#include <3ds/gpu/registers.h>
+#include <stdlib.h>
+#include <string.h>
+
+void C3D_CostParamsDefault(C3D_CostParams* params)
+{
+	// Starting points only; measure a few reference scenes on the console and adjust
+	params->clockHz             = 268111856.0f;
+	params->vertexBase          = 8.0f;
+	params->vertexPerAttribByte = 0.25f;
+	params->vertexPerShaderWord = 0.25f;
+	params->indexMissRatio      = 0.6f;
+	params->setupPerPrim        = 20.0f;
+	params->fragmentsPerPrim    = 64.0f;
+	params->maxOverdraw         = 4.0f;
+	params->fragBase            = 0.5f;
+	params->fragPerTexEnv       = 0.125f;
+	params->fragPerTexel        = 0.25f;
+	params->fragPerLight        = 1.0f;
+	params->fragPerLightLut     = 0.5f;
+	params->fragProcTex         = 1.0f;
+	params->fragFog             = 0.25f;
+	params->fragPerFbByte       = 0.125f;
+}
+
+static u32 C3Di_AttribBytes(const u32* regs)
+{
+	static const u8 typeSize[] = { 1, 1, 2, 4 };
+	u32 high = regs[GPUREG_ATTRIBBUFFERS_FORMAT_HIGH];
+	u32 count = (high >> 28) + 1;
+	u32 bytes = 0, i;
+	for (i = 0; i < count && i < 12; i ++)
+	{
+		if (high & (1 << (16+i)))
+			continue; // Fixed attribute, nothing to fetch
+		u32 fmt = i < 8 ? (regs[GPUREG_ATTRIBBUFFERS_FORMAT_LOW] >> (i*4)) : (high >> ((i-8)*4));
+		bytes += typeSize[fmt & 3] * (((fmt >> 2) & 3) + 1);
+	}
+	return bytes;
+}
+
+static u32 C3Di_Primitives(const u32* regs, u32 vertices)
+{
+	switch ((regs[GPUREG_PRIMITIVE_CONFIG] >> 8) & 3)
+	{
+		case 1: // Strip
+		case 2: // Fan
+			return vertices >= 3 ? vertices - 2 : 0;
+		default:
+			return vertices / 3;
+	}
+}
+
+static u32 C3Di_ActiveTexEnvStages(const u32* regs)
+{
+	static const u16 stages[6] =
+	{
+		GPUREG_TEXENV0_SOURCE, GPUREG_TEXENV1_SOURCE, GPUREG_TEXENV2_SOURCE,
+		GPUREG_TEXENV3_SOURCE, GPUREG_TEXENV4_SOURCE, GPUREG_TEXENV5_SOURCE,
+	};
+	u32 count = 0, i;
+	for (i = 0; i < 6; i ++)
+	{
+		u32 src = regs[stages[i]];
+		u32 combiner = regs[stages[i]+2];
+		// Replacing with the previous stage's output leaves the value untouched
+		bool passthrough = combiner == 0 && (src & 0xF) == 0xF && ((src >> 16) & 0xF) == 0xF;
+		if (!passthrough)
+			count ++;
+	}
+	return count;
+}
+
+static float C3Di_TexelBytes(const u32* regs)
+{
+	static const u8 bpp[] = { 32, 24, 16, 16, 16, 16, 16, 8, 8, 8, 4, 4, 4, 8 };
+	static const u16 types[3] = { GPUREG_TEXUNIT0_TYPE, GPUREG_TEXUNIT1_TYPE, GPUREG_TEXUNIT2_TYPE };
+	float bytes = 0.0f;
+	int i;
+	for (i = 0; i < 3; i ++)
+	{
+		u32 fmt = regs[types[i]] & 0xF;
+		if ((regs[GPUREG_TEXUNIT_CONFIG] & (1 << i)) && fmt < sizeof(bpp))
+			bytes += bpp[fmt] / 8.0f;
+	}
+	return bytes;
+}
+
+static float C3Di_FbBytes(const u32* regs)
+{
+	static const u8 depthSize[] = { 2, 0, 3, 4 };
+	u32 colorBytes = 2 + (regs[GPUREG_COLORBUFFER_FORMAT] & 3);
+	u32 depthBytes = depthSize[regs[GPUREG_DEPTHBUFFER_FORMAT] & 3];
+	float bytes = 0.0f;
+	if (regs[GPUREG_COLORBUFFER_READ] & 0xF)  bytes += colorBytes;
+	if (regs[GPUREG_COLORBUFFER_WRITE] & 0xF) bytes += colorBytes;
+	if (regs[GPUREG_DEPTHBUFFER_READ] & 3)    bytes += depthBytes;
+	if (regs[GPUREG_DEPTHBUFFER_WRITE] & 3)   bytes += depthBytes;
+	return bytes;
+}
+
+// Indexed draws shade fewer vertices than they submit thanks to the post-vertex cache
+static void C3Di_CostDraw(const u32* regs, u32 submitted, u32 vertices, u32 shaderWords, const C3D_CostParams* p, C3D_CostEstimate* out)
+{
+	u32 prims = C3Di_Primitives(regs, submitted);
+	out->draws ++;
+	out->vertices += vertices;
+	out->primitives += prims;
+
+	out->vertex += vertices * (p->vertexBase + p->vertexPerAttribByte*C3Di_AttribBytes(regs) + p->vertexPerShaderWord*shaderWords);
+	out->setup += prims * p->setupPerPrim;
+
+	u32 dim = regs[GPUREG_FRAMEBUFFER_DIM];
+	float area = (float)(dim & 0xFFF) * (float)(((dim >> 12) & 0xFFF) + 1);
+	float frags = prims * p->fragmentsPerPrim;
+	if (frags > area*p->maxOverdraw)
+		frags = area*p->maxOverdraw;
+	out->fragments += frags;
+
+	float fill = p->fragBase + p->fragPerTexEnv*C3Di_ActiveTexEnvStages(regs) + p->fragPerFbByte*C3Di_FbBytes(regs);
+	if (regs[GPUREG_TEXUNIT_CONFIG] & (1 << 3))
+		fill += p->fragProcTex;
+	u32 fogMode = regs[GPUREG_TEXENV_UPDATE_BUFFER] & 7;
+	if (fogMode == 5 || fogMode == 7)
+		fill += p->fragFog;
+	out->fill += frags * fill;
+	out->texture += frags * p->fragPerTexel * C3Di_TexelBytes(regs);
+
+	if (regs[GPUREG_LIGHTING_ENABLE0] & 1)
+	{
+		// The common LUTs have one disable bit each, SP and DA have one per light
+		static const u32 lutBits[] =
+		{
+			GPU_LC1_LUTBIT(GPU_LUT_D0), GPU_LC1_LUTBIT(GPU_LUT_D1), GPU_LC1_LUTBIT(GPU_LUT_FR),
+			GPU_LC1_LUTBIT(GPU_LUT_RB), GPU_LC1_LUTBIT(GPU_LUT_RG), GPU_LC1_LUTBIT(GPU_LUT_RR),
+		};
+		u32 config = regs[GPUREG_LIGHTING_CONFIG1];
+		u32 numLights = (regs[GPUREG_LIGHTING_NUM_LIGHTS] & 7) + 1;
+		u32 numLuts = 0, i;
+		for (i = 0; i < sizeof(lutBits)/sizeof(lutBits[0]); i ++)
+			if (!(config & lutBits[i]))
+				numLuts ++;
+		for (i = 0; i < numLights; i ++)
+		{
+			u32 id = (regs[GPUREG_LIGHTING_LIGHT_PERMUTATION] >> (i*4)) & 7;
+			if (!(config & GPU_LC1_SPOTBIT(id)))
+				numLuts ++;
+			if (!(config & GPU_LC1_ATTNBIT(id)))
+				numLuts ++;
+		}
+		out->lighting += frags * (p->fragPerLight*numLights + p->fragPerLightLut*numLuts);
+	}
+}
+
+void C3D_CostEstimateStream(const C3D_CmdWrite* writes, u32 count, const C3D_CostParams* params, C3D_CostEstimate* out)
+{
+	u32 regs[C3D_CMD_NUM_REGS];
+	u32 shaderPos = 0, shaderWords = 0, immAttribs = 0;
+	u32 i;
+	C3D_PROFILE_SCOPE("C3D_CostEstimateStream");
+
+	memset(regs, 0, sizeof(regs));
+	memset(out, 0, sizeof(*out));
+	regs[GPUREG_START_DRAW_FUNC0] = 1; // Configuration mode
+
+	for (i = 0; i < count; i ++)
+	{
+		const C3D_CmdWrite* w = &writes[i];
+		u32 bytes = (w->mask & 1 ? 0xFF : 0) | (w->mask & 2 ? 0xFF00 : 0) | (w->mask & 4 ? 0xFF0000 : 0) | (w->mask & 8 ? 0xFF000000 : 0);
+		u32 value = (regs[w->reg] &~ bytes) | (w->value & bytes);
+
+		switch (w->reg)
+		{
+			case GPUREG_VSH_CODETRANSFER_CONFIG:
+				shaderPos = value & 0xFFF;
+				if (!shaderPos)
+					shaderWords = 0;
+				break;
+			case GPUREG_VSH_CODETRANSFER_DATA:
+			case GPUREG_VSH_CODETRANSFER_DATA+1:
+			case GPUREG_VSH_CODETRANSFER_DATA+2:
+			case GPUREG_VSH_CODETRANSFER_DATA+3:
+			case GPUREG_VSH_CODETRANSFER_DATA+4:
+			case GPUREG_VSH_CODETRANSFER_DATA+5:
+			case GPUREG_VSH_CODETRANSFER_DATA+6:
+			case GPUREG_VSH_CODETRANSFER_DATA+7:
+				if (++shaderPos > shaderWords)
+					shaderWords = shaderPos;
+				break;
+			case GPUREG_DRAWARRAYS:
+			case GPUREG_DRAWELEMENTS:
+			{
+				u32 submitted = regs[GPUREG_NUMVERTICES];
+				u32 vertices = submitted;
+				if (w->reg == GPUREG_DRAWELEMENTS)
+					vertices = (u32)(submitted * params->indexMissRatio + 0.5f);
+				C3Di_CostDraw(regs, submitted, vertices, shaderWords, params, out);
+				break;
+			}
+			case GPUREG_FIXEDATTRIB_DATA0+2:
+				// Completes an immediate mode attribute while drawing
+				if (!(regs[GPUREG_START_DRAW_FUNC0] & 1) && regs[GPUREG_FIXEDATTRIB_INDEX] == 0xF)
+					immAttribs ++;
+				break;
+			case GPUREG_START_DRAW_FUNC0:
+				if ((value & 1) && immAttribs)
+				{
+					// A vertex takes one attribute per shader input
+					u32 vertices = immAttribs / ((regs[GPUREG_VSH_NUM_ATTR] & 0xF) + 1);
+					C3Di_CostDraw(regs, vertices, vertices, shaderWords, params, out);
+					immAttribs = 0;
+				}
+				break;
+		}
+		regs[w->reg] = value;
+	}
+
+	out->total = out->vertex + out->setup + out->fill + out->texture + out->lighting;
+	out->ms = out->total * 1000.0f / params->clockHz;
+}
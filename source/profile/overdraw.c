@@ -0,0 +1,42 @@
+#include <c3d/overdraw.h>
+#include <c3d/profile.h>
+#include <string.h>
+
+bool C3D_OverdrawCount(const void* depthBuf, u32 width, u32 height, C3D_OverdrawStats* out, u8* heatmap)
+{
+	static u8 mortonX[64], mortonY[64];
+	const u8* p = (const u8*)depthBuf;
+	u32 tx, ty, i;
+	C3D_PROFILE_SCOPE("C3D_OverdrawCount");
+
+	memset(out, 0, sizeof(*out));
+	if (!depthBuf || !width || !height || (width & 7) || (height & 7))
+		return false;
+
+	if (!mortonX[63])
+	{
+		// Pixels within a tile are stored in Z-order, x taking the low bit of each pair
+		for (i = 0; i < 64; i ++)
+		{
+			mortonX[i] = (i & 1) | ((i >> 1) & 2) | ((i >> 2) & 4);
+			mortonY[i] = ((i >> 1) & 1) | ((i >> 2) & 2) | ((i >> 3) & 4);
+		}
+	}
+
+	out->pixels = width*height;
+	for (ty = 0; ty < height; ty += 8)
+		for (tx = 0; tx < width; tx += 8, p += 64*4)
+			for (i = 0; i < 64; i ++)
+			{
+				u32 count = p[i*4+3]; // Stencil is the top byte of each D24S8 pixel
+				out->fragments += count;
+				out->histogram[count < C3D_OVERDRAW_BUCKETS ? count : C3D_OVERDRAW_BUCKETS-1] ++;
+				if (count)
+					out->covered ++;
+				if (count > out->maxLayers)
+					out->maxLayers = count;
+				if (heatmap)
+					heatmap[(ty + mortonY[i])*width + tx + mortonX[i]] = count;
+			}
+	return true;
+}
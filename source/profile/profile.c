@@ -0,0 +1,140 @@
+#include <c3d/profile.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _3DS
+#include <3ds.h>
+#define TICKS_PER_USEC (SYSCLOCK_ARM11/1000000.0)
+#else
+#include <time.h>
+#define TICKS_PER_USEC 1000.0
+#endif
+
+static C3D_ProfileEvent defaultRing[C3D_PROFILE_CAPACITY];
+static C3D_ProfileEvent* ring = defaultRing;
+static u32 ringSize = C3D_PROFILE_CAPACITY;
+static u32 ringPos;
+static bool enabled = true;
+
+bool C3D_ProfileInit(u32 capacity)
+{
+	C3D_ProfileEvent* events = defaultRing;
+	if (capacity && capacity != C3D_PROFILE_CAPACITY)
+	{
+		events = (C3D_ProfileEvent*)malloc(capacity*sizeof(C3D_ProfileEvent));
+		if (!events)
+			return false;
+	} else
+		capacity = C3D_PROFILE_CAPACITY;
+
+	if (ring != defaultRing)
+		free(ring);
+	ring = events;
+	ringSize = capacity;
+	C3D_ProfileClear();
+	return true;
+}
+
+u64 C3D_ProfileTicks(void)
+{
+#ifdef _3DS
+	return svcGetSystemTick();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static u32 profileThread(void)
+{
+#ifdef _3DS
+	// NULL for the main thread
+	return (u32)threadGetCurrent();
+#else
+	return 0;
+#endif
+}
+
+void C3D_ProfileEnable(bool enable)
+{
+	enabled = enable;
+}
+
+void C3D_ProfileRecord(const char* name, u64 start, u64 end)
+{
+	if (!enabled)
+		return;
+
+	// Writers only contend on the index; a slot being read during export may be torn
+	u32 idx = __atomic_fetch_add(&ringPos, 1, __ATOMIC_RELAXED);
+	C3D_ProfileEvent* e = &ring[idx % ringSize];
+	e->name = name;
+	e->start = start;
+	e->duration = end - start;
+	e->thread = profileThread();
+}
+
+void C3D_ProfileClear(void)
+{
+	__atomic_store_n(&ringPos, 0, __ATOMIC_RELAXED);
+}
+
+u32 C3D_ProfileEvents(C3D_ProfileEvent* out, u32 maxEvents)
+{
+	u32 pos = __atomic_load_n(&ringPos, __ATOMIC_RELAXED);
+	u32 count = pos < ringSize ? pos : ringSize;
+	u32 i;
+
+	// Oldest first
+	if (count > maxEvents)
+		count = maxEvents;
+	for (i = 0; i < count; i ++)
+		out[i] = ring[(pos - count + i) % ringSize];
+	return count;
+}
+
+u32 C3D_ProfileDropped(void)
+{
+	u32 pos = __atomic_load_n(&ringPos, __ATOMIC_RELAXED);
+	return pos > ringSize ? pos - ringSize : 0;
+}
+
+size_t C3D_ProfileExport(char* out, size_t size)
+{
+	u32 pos = __atomic_load_n(&ringPos, __ATOMIC_RELAXED);
+	u32 count = pos < ringSize ? pos : ringSize;
+	u32 i;
+	size_t len = 0;
+	u64 base = ~0ULL;
+
+	// Returns the length the trace needs, like snprintf; nothing past size-1 is written
+	for (i = 0; i < count; i ++)
+	{
+		const C3D_ProfileEvent* e = &ring[(pos - count + i) % ringSize];
+		if (e->start < base)
+			base = e->start;
+	}
+
+#define EMIT(...) \
+	len += snprintf(len < size ? out + len : NULL, len < size ? size - len : 0, __VA_ARGS__)
+
+	EMIT("{\"traceEvents\":[");
+	for (i = 0; i < count; i ++)
+	{
+		const C3D_ProfileEvent* e = &ring[(pos - count + i) % ringSize];
+		const char* c;
+		EMIT("%s{\"name\":\"", i ? "," : "");
+		for (c = e->name; *c; c ++)
+			EMIT((*c == '"' || *c == '\\') ? "\\%c" : "%c", *c);
+		EMIT("\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%lu}",
+			(e->start - base)/TICKS_PER_USEC, e->duration/TICKS_PER_USEC, (unsigned long)e->thread);
+	}
+	// Overwritten events leave a hole at the start of the trace, say so rather than hide it
+	EMIT("],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":%lu}}\n",
+		(unsigned long)(pos > ringSize ? pos - ringSize : 0));
+
+#undef EMIT
+	return len;
+}
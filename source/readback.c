@@ -0,0 +1,86 @@
+#include "internal.h"
+#include <c3d/readback.h>
+
+static inline u32 C3Di_TransferPixelSize(GX_TRANSFER_FORMAT fmt)
+{
+	return fmt == GX_TRANSFER_FMT_RGBA8 ? 4 : fmt == GX_TRANSFER_FMT_RGB8 ? 3 : 2;
+}
+
+// GX transfer formats and GPU color buffer formats disagree on the order of RGB565 and RGB5A1
+static GX_TRANSFER_FORMAT C3Di_ColorBufTransferFormat(GPU_COLORBUF fmt)
+{
+	switch (fmt)
+	{
+		case GPU_RB_RGBA5551: return GX_TRANSFER_FMT_RGB5A1;
+		case GPU_RB_RGB565:   return GX_TRANSFER_FMT_RGB565;
+		default:              return (GX_TRANSFER_FORMAT)fmt;
+	}
+}
+
+static C3D_PixFormat C3Di_TransferPixFormat(GX_TRANSFER_FORMAT fmt)
+{
+	switch (fmt)
+	{
+		case GX_TRANSFER_FMT_RGB5A1: return C3D_PIX_RGB5A1;
+		case GX_TRANSFER_FMT_RGB565: return C3D_PIX_RGB565;
+		default:                     return (C3D_PixFormat)fmt;
+	}
+}
+
+bool C3D_ReadbackInit(C3D_Readback* rb, u16 width, u16 height, GX_TRANSFER_FORMAT fmt)
+{
+	memset(rb, 0, sizeof(*rb));
+	if (!width || !height || (width & 7) || (height & 7) || fmt > GX_TRANSFER_FMT_RGBA4)
+		return false;
+
+	rb->data = linearAlloc(width*height*C3Di_TransferPixelSize(fmt));
+	if (!rb->data)
+		return false;
+	rb->width = width;
+	rb->height = height;
+	rb->fmt = fmt;
+	return true;
+}
+
+void C3D_ReadbackDelete(C3D_Readback* rb)
+{
+	if (rb->queued)
+		C3D_FenceWait(rb->fence);
+	if (rb->data)
+		linearFree(rb->data);
+	memset(rb, 0, sizeof(*rb));
+}
+
+bool C3D_ReadbackQueue(C3D_Readback* rb, C3D_RenderTarget* target)
+{
+	C3D_FrameBuf* fb = &target->frameBuf;
+	if (!rb->data || !fb->colorBuf || fb->block32 || fb->width != rb->width || fb->height != rb->height)
+		return false;
+
+	u32 dim = GX_BUFFER_DIM((u32)fb->width, (u32)fb->height);
+	u32 flags = GX_TRANSFER_FLIP_VERT(0) | GX_TRANSFER_OUT_TILED(0) | GX_TRANSFER_RAW_COPY(0)
+		| GX_TRANSFER_IN_FORMAT(C3Di_ColorBufTransferFormat(fb->colorFmt)) | GX_TRANSFER_OUT_FORMAT(rb->fmt)
+		| GX_TRANSFER_SCALING(GX_TRANSFER_SCALE_NO);
+	rb->fence = C3Di_QueueDisplayTransfer((u32*)fb->colorBuf, dim, (u32*)rb->data, dim, flags);
+	rb->queued = true;
+	return true;
+}
+
+bool C3D_ReadbackReady(const C3D_Readback* rb)
+{
+	return rb->queued && C3D_FenceReached(rb->fence);
+}
+
+bool C3D_ReadbackConvert(C3D_Readback* rb, void* dst, C3D_PixOutput out)
+{
+	u32 numPixels = rb->width*rb->height;
+	C3D_PROFILE_SCOPE("C3D_ReadbackConvert");
+	if (!rb->queued || !C3D_FenceWait(rb->fence))
+		return false;
+
+	// The CPU may still hold lines of an earlier copy
+	GSPGPU_InvalidateDataCache(rb->data, numPixels*C3Di_TransferPixelSize(rb->fmt));
+	C3D_PixConvert(dst, out, rb->data, C3Di_TransferPixFormat(rb->fmt), numPixels);
+	rb->queued = false;
+	return true;
+}
@@ -0,0 +1,433 @@
+#include "internal.h"
+#include <c3d/rendergraph.h>
+
+typedef struct
+{
+	u32* start;
+	u32 value;
+	u32* end;
+	u16 control;
+} C3Di_Fill;
+
+static inline int C3Di_RenderGraphPhys(const C3D_RenderGraph* rg, int res)
+{
+	return rg->res[res].alias >= 0 ? rg->res[res].alias : res;
+}
+
+static void C3Di_RenderGraphRelease(C3D_RenderGraph* rg)
+{
+	int i;
+	for (i = 0; i < rg->numRes; i ++)
+	{
+		C3D_RenderGraphRes* r = &rg->res[i];
+		if (!r->transient)
+			continue;
+		if (r->alias < 0 && r->target)
+		{
+			C3D_RenderTargetDelete(r->target);
+			C3D_TexDelete(&r->ownTex);
+		}
+		r->target = NULL;
+		r->tex = NULL;
+		r->alias = -1;
+	}
+	rg->compiled = false;
+}
+
+void C3D_RenderGraphInit(C3D_RenderGraph* rg)
+{
+	memset(rg, 0, sizeof(*rg));
+}
+
+void C3D_RenderGraphDelete(C3D_RenderGraph* rg)
+{
+	C3Di_RenderGraphRelease(rg);
+	C3D_RenderGraphInit(rg);
+}
+
+int C3D_RenderGraphImport(C3D_RenderGraph* rg, C3D_RenderTarget* target, C3D_Tex* tex)
+{
+	if (rg->numRes == C3D_RG_MAX_RESOURCES)
+		return -1;
+
+	int id = rg->numRes++;
+	C3D_RenderGraphRes* r = &rg->res[id];
+	memset(r, 0, sizeof(*r));
+	r->target   = target;
+	r->tex      = tex;
+	r->width    = target->frameBuf.width;
+	r->height   = target->frameBuf.height;
+	r->colorFmt = (GPU_TEXCOLOR)target->frameBuf.colorFmt;
+	r->depthFmt = target->frameBuf.depthBuf ? (s8)target->frameBuf.depthFmt : -1;
+	r->alias    = -1;
+	rg->compiled = false;
+	return id;
+}
+
+int C3D_RenderGraphTransient(C3D_RenderGraph* rg, u16 width, u16 height, GPU_TEXCOLOR colorFmt, C3D_DEPTHTYPE depthFmt)
+{
+	if (rg->numRes == C3D_RG_MAX_RESOURCES)
+		return -1;
+
+	int id = rg->numRes++;
+	C3D_RenderGraphRes* r = &rg->res[id];
+	memset(r, 0, sizeof(*r));
+	r->width     = width;
+	r->height    = height;
+	r->colorFmt  = colorFmt;
+	r->depthFmt  = C3D_DEPTHTYPE_OK(depthFmt) ? (s8)C3D_DEPTHTYPE_VAL(depthFmt) : -1;
+	r->transient = true;
+	r->alias     = -1;
+	rg->compiled = false;
+	return id;
+}
+
+int C3D_RenderGraphAddPass(C3D_RenderGraph* rg, int target, C3D_RenderPassCb cb, void* param)
+{
+	if (rg->numPasses == C3D_RG_MAX_PASSES || target < 0 || target >= rg->numRes)
+		return -1;
+
+	int id = rg->numPasses++;
+	C3D_RenderGraphPass* p = &rg->passes[id];
+	memset(p, 0, sizeof(*p));
+	p->cb = cb;
+	p->param = param;
+	p->target = target;
+	p->transferSrc = -1;
+	rg->compiled = false;
+	return id;
+}
+
+int C3D_RenderGraphAddTransfer(C3D_RenderGraph* rg, int src, int dst, u32 transferFlags)
+{
+	if (src < 0 || src >= rg->numRes || src == dst)
+		return -1;
+
+	int id = C3D_RenderGraphAddPass(rg, dst, NULL, NULL);
+	if (id >= 0)
+	{
+		rg->passes[id].transferSrc = src;
+		rg->passes[id].transferFlags = transferFlags;
+	}
+	return id;
+}
+
+bool C3D_RenderGraphRead(C3D_RenderGraph* rg, int pass, int res)
+{
+	if (pass < 0 || pass >= rg->numPasses)
+		return false;
+
+	// A target can't be sampled while it is being drawn into
+	C3D_RenderGraphPass* p = &rg->passes[pass];
+	if (p->numReads == C3D_RG_MAX_READS || res < 0 || res >= rg->numRes || res == p->target)
+		return false;
+
+	p->reads[p->numReads++] = res;
+	rg->compiled = false;
+	return true;
+}
+
+void C3D_RenderGraphClear(C3D_RenderGraph* rg, int pass, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth)
+{
+	if (pass < 0 || pass >= rg->numPasses)
+		return;
+
+	C3D_RenderGraphPass* p = &rg->passes[pass];
+	p->clearBits = clearBits;
+	p->clearColor = clearColor;
+	p->clearDepth = clearDepth;
+}
+
+static bool C3Di_RenderGraphReads(const C3D_RenderGraphPass* p, int res)
+{
+	int i;
+	if (p->transferSrc == res)
+		return true;
+	for (i = 0; i < p->numReads; i ++)
+		if (p->reads[i] == res)
+			return true;
+	return false;
+}
+
+static void C3Di_RenderGraphTouch(C3D_RenderGraphRes* r, int pos)
+{
+	if (r->first < 0)
+		r->first = pos;
+	r->last = pos;
+}
+
+bool C3D_RenderGraphCompile(C3D_RenderGraph* rg)
+{
+	u32 live = 0, needed = 0, done = 0;
+	u32 deps[C3D_RG_MAX_PASSES];
+	s8 busyUntil[C3D_RG_MAX_RESOURCES];
+	int i, j, numLive = 0, lastTarget = -1;
+	bool changed;
+
+	C3Di_RenderGraphRelease(rg);
+	for (i = 0; i < rg->numRes; i ++)
+		busyUntil[i] = -1;
+
+	// Keep the passes that end up in an imported resource
+	for (i = 0; i < rg->numRes; i ++)
+		if (!rg->res[i].transient)
+			needed |= BIT(i);
+	do
+	{
+		changed = false;
+		for (i = 0; i < rg->numPasses; i ++)
+		{
+			C3D_RenderGraphPass* p = &rg->passes[i];
+			if ((live & BIT(i)) || !(needed & BIT(p->target)))
+				continue;
+			live |= BIT(i);
+			numLive ++;
+			for (j = 0; j < p->numReads; j ++)
+				needed |= BIT(p->reads[j]);
+			if (p->transferSrc >= 0)
+				needed |= BIT(p->transferSrc);
+			changed = true;
+		}
+	} while (changed);
+
+	// Readers wait for every writer, writers of the same resource keep their declaration order
+	for (i = 0; i < rg->numPasses; i ++)
+	{
+		deps[i] = 0;
+		if (!(live & BIT(i)))
+			continue;
+		for (j = 0; j < rg->numPasses; j ++)
+		{
+			const C3D_RenderGraphPass* q = &rg->passes[j];
+			if (j == i || !(live & BIT(j)))
+				continue;
+			if (C3Di_RenderGraphReads(&rg->passes[i], q->target) || (q->target == rg->passes[i].target && j < i))
+				deps[i] |= BIT(j);
+		}
+	}
+
+	// Topological order, staying on the same target when possible to avoid framebuffer switches
+	rg->numOrdered = 0;
+	while (rg->numOrdered < numLive)
+	{
+		int pick = -1;
+		for (i = 0; i < rg->numPasses; i ++)
+		{
+			if (!(live & BIT(i)) || (done & BIT(i)) || (deps[i] &~ done))
+				continue;
+			if (pick < 0)
+				pick = i;
+			if (rg->passes[i].target == lastTarget)
+			{
+				pick = i;
+				break;
+			}
+		}
+		if (pick < 0)
+			return false;
+
+		rg->order[rg->numOrdered++] = pick;
+		done |= BIT(pick);
+		lastTarget = rg->passes[pick].target;
+	}
+
+	for (i = 0; i < rg->numRes; i ++)
+		rg->res[i].first = rg->res[i].last = -1;
+	for (i = 0; i < rg->numOrdered; i ++)
+	{
+		const C3D_RenderGraphPass* p = &rg->passes[rg->order[i]];
+		C3Di_RenderGraphTouch(&rg->res[p->target], i);
+		if (p->transferSrc >= 0)
+			C3Di_RenderGraphTouch(&rg->res[p->transferSrc], i);
+		for (j = 0; j < p->numReads; j ++)
+			C3Di_RenderGraphTouch(&rg->res[p->reads[j]], i);
+	}
+
+	// Transient resources with the same description and disjoint lifetimes share memory
+	for (i = 0; i < rg->numOrdered; i ++)
+	{
+		for (j = 0; j < rg->numRes; j ++)
+		{
+			C3D_RenderGraphRes* r = &rg->res[j];
+			int k;
+			if (!r->transient || r->first != i)
+				continue;
+
+			for (k = 0; k < rg->numRes; k ++)
+			{
+				C3D_RenderGraphRes* o = &rg->res[k];
+				if (!o->transient || o->alias >= 0 || !o->target || busyUntil[k] >= r->first)
+					continue;
+				if (o->width != r->width || o->height != r->height || o->colorFmt != r->colorFmt || o->depthFmt != r->depthFmt)
+					continue;
+				r->alias = k;
+				busyUntil[k] = r->last;
+				break;
+			}
+			if (r->alias >= 0)
+				continue;
+
+			if (!C3D_TexInitVRAM(&r->ownTex, r->width, r->height, r->colorFmt))
+				goto _fail;
+			r->target = C3D_RenderTargetCreateFromTex(&r->ownTex, GPU_TEXFACE_2D, 0, (int)r->depthFmt);
+			if (!r->target)
+			{
+				C3D_TexDelete(&r->ownTex);
+				goto _fail;
+			}
+			r->tex = &r->ownTex;
+			busyUntil[j] = r->last;
+		}
+	}
+
+	rg->compiled = true;
+	return true;
+
+_fail:
+	C3Di_RenderGraphRelease(rg);
+	return false;
+}
+
+static int C3Di_RenderGraphFills(C3Di_Fill* fills, const C3D_FrameBuf* fb, C3D_ClearBits clearBits, u32 clearColor, u32 clearDepth)
+{
+	u32 pixels = (u32)fb->width * fb->height;
+	int n = 0;
+	if ((clearBits & C3D_CLEAR_COLOR) && fb->colorBuf)
+	{
+		u32 size = C3D_CalcColorBufSize(fb->width, fb->height, fb->colorFmt);
+		fills[n].start   = (u32*)fb->colorBuf;
+		fills[n].value   = clearColor;
+		fills[n].end     = (u32*)((u8*)fb->colorBuf + size);
+		fills[n].control = BIT(0) | ((size/pixels - 2) << 8);
+		n ++;
+	}
+	if ((clearBits & C3D_CLEAR_DEPTH) && fb->depthBuf)
+	{
+		u32 size = C3D_CalcDepthBufSize(fb->width, fb->height, fb->depthFmt);
+		fills[n].start   = (u32*)fb->depthBuf;
+		fills[n].value   = clearDepth;
+		fills[n].end     = (u32*)((u8*)fb->depthBuf + size);
+		fills[n].control = BIT(0) | ((size/pixels - 2) << 8);
+		n ++;
+	}
+	return n;
+}
+
+static void C3Di_RenderGraphSubmitFills(const C3Di_Fill* fills, int count)
+{
+	int i;
+
+	// The memory fill unit has two channels, so buffers are cleared in pairs
+	for (i = 0; i < count; i += 2)
+	{
+		if (i+1 < count)
+			GX_MemoryFill(fills[i].start, fills[i].value, fills[i].end, fills[i].control,
+				fills[i+1].start, fills[i+1].value, fills[i+1].end, fills[i+1].control);
+		else
+			GX_MemoryFill(fills[i].start, fills[i].value, fills[i].end, fills[i].control,
+				NULL, 0, NULL, 0);
+	}
+}
+
+// Imported targets that the render queue cleared at the end of the previous frame, and that haven't
+// been drawn into since, don't need the same clear again
+static bool C3Di_RenderGraphAutoCleared(const C3D_RenderGraphRes* r, const C3D_RenderGraphPass* p)
+{
+	const C3D_RenderTarget* t = r->target;
+	if (r->transient || !t->autoCleared || (p->clearBits &~ t->clearBits))
+		return false;
+	if ((p->clearBits & C3D_CLEAR_COLOR) && p->clearColor != t->clearColor)
+		return false;
+	if ((p->clearBits & C3D_CLEAR_DEPTH) && p->clearDepth != t->clearDepth)
+		return false;
+	return true;
+}
+
+void C3D_RenderGraphExecute(C3D_RenderGraph* rg)
+{
+	C3Di_Fill fills[C3D_RG_MAX_PASSES*2];
+	u32 seen = 0, pending = 0, pendingReads = 0, cleared = 0;
+	bool skipClear[C3D_RG_MAX_PASSES];
+	const C3D_RenderGraphPass* lastClear[C3D_RG_MAX_RESOURCES];
+	C3D_RenderTarget* cur = NULL;
+	int i, numFills = 0;
+
+	if (!rg->compiled)
+		return;
+
+	// Clears of targets that haven't been touched yet this frame are all done up front
+	for (i = 0; i < rg->numOrdered; i ++)
+	{
+		const C3D_RenderGraphPass* p = &rg->passes[rg->order[i]];
+		int t = C3Di_RenderGraphPhys(rg, p->target);
+		const C3D_RenderGraphRes* r = &rg->res[t];
+
+		skipClear[i] = !(seen & BIT(t)) && p->transferSrc < 0 && p->clearBits;
+		seen |= BIT(t);
+		if (!skipClear[i] || C3Di_RenderGraphAutoCleared(&rg->res[p->target], p))
+			continue;
+		numFills += C3Di_RenderGraphFills(&fills[numFills], &r->target->frameBuf, p->clearBits, p->clearColor, p->clearDepth);
+		lastClear[t] = p;
+		cleared |= BIT(t);
+	}
+	C3Di_RenderGraphSubmitFills(fills, numFills);
+
+	for (i = 0; i < rg->numOrdered; i ++)
+	{
+		const C3D_RenderGraphPass* p = &rg->passes[rg->order[i]];
+		int t = C3Di_RenderGraphPhys(rg, p->target);
+		C3D_RenderTarget* target = rg->res[t].target;
+		int j;
+
+		// Transfers and clears run on the GX queue, ahead of draws that haven't been submitted yet, so
+		// those draws are submitted first if they draw into or read from the memory being overwritten
+		if (p->transferSrc >= 0)
+		{
+			int s = C3Di_RenderGraphPhys(rg, p->transferSrc);
+			C3D_FrameBuf* src = &rg->res[s].target->frameBuf;
+			if ((pending & BIT(s)) || ((pending | pendingReads) & BIT(t)))
+			{
+				C3D_FrameSplit(0);
+				pending = pendingReads = 0;
+			}
+			GX_DisplayTransfer((u32*)src->colorBuf, GX_BUFFER_DIM((u32)src->width, (u32)src->height),
+				(u32*)target->frameBuf.colorBuf, GX_BUFFER_DIM((u32)target->frameBuf.width, (u32)target->frameBuf.height),
+				p->transferFlags);
+			cleared &= ~BIT(t);
+			continue;
+		}
+
+		// Clearing again with nothing drawn in between does nothing
+		if (p->clearBits && !skipClear[i] && (cleared & BIT(t)))
+		{
+			const C3D_RenderGraphPass* c = lastClear[t];
+			if (c->clearBits == p->clearBits && c->clearColor == p->clearColor && c->clearDepth == p->clearDepth)
+				skipClear[i] = true;
+		}
+
+		if (p->clearBits && !skipClear[i])
+		{
+			if ((pending | pendingReads) & BIT(t))
+			{
+				C3D_FrameSplit(0);
+				pending = pendingReads = 0;
+			}
+			C3D_FrameBufClear(&target->frameBuf, p->clearBits, p->clearColor, p->clearDepth);
+			lastClear[t] = p;
+			cleared |= BIT(t);
+		}
+
+		if (!p->cb)
+			continue;
+		if (target != cur)
+		{
+			C3D_FrameDrawOn(target);
+			cur = target;
+		}
+		p->cb(p->param);
+		pending |= BIT(t);
+		for (j = 0; j < p->numReads; j ++)
+			pendingReads |= BIT(C3Di_RenderGraphPhys(rg, p->reads[j]));
+		cleared &= ~BIT(t);
+	}
+}
@@ -2,6 +2,7 @@
 #include <c3d/base.h>
 #include <c3d/renderqueue.h>
 #include <stdlib.h>
+#include <math.h>
 
 static C3D_RenderTarget *firstTarget, *lastTarget;
 static C3D_RenderTarget *linkedTarget[3];
@@ -24,6 +25,28 @@ static u32 frameCounter[2];
 static void (* frameEndCb)(void*);
 static void* frameEndCbData;
 
+// Fences count the work submitted to the GPU: each frame and each transfer issued outside of a frame.
+// The queue finishing in order means that everything submitted so far has been reached.
+static u32 fenceSubmitted;
+static volatile u32 fenceReached;
+
+// Top screen refresh period in system ticks
+#define VBLANK_TICKS 4481136
+
+// Low latency pacing: moving averages of the CPU and GPU times and of their deviation, in milliseconds
+#define PACING_ALPHA     0.125f
+#define PACING_DEV_SCALE 2.0f
+#define PACING_MARGIN_MS 0.5f
+
+static u64 lastVBlank, frameDeadline;
+static float paceCpu, paceGpu, paceCpuDev, paceGpuDev;
+static bool paceValid, frameEnded;
+static u32 deadlineMisses;
+
+#ifdef C3D_PROFILE
+static u64 frameStartTick;
+#endif
+
 static bool framerateLimit(int id)
 {
 	framerateCounter[id] -= framerate;
@@ -37,6 +60,7 @@ static bool framerateLimit(int id)
 
 static void onVBlank0(C3D_UNUSED void* unused)
 {
+	lastVBlank = svcGetSystemTick();
 	if (frameStage & STAGE_NEED_TOP_TRANSFER)
 	{
 		C3D_RenderTarget *left = linkedTarget[0], *right = linkedTarget[1];
@@ -56,9 +80,15 @@ static void onVBlank0(C3D_UNUSED void* unused)
 			if (right)
 				C3D_FrameBufTransfer(&right->frameBuf, GFX_TOP, GFX_RIGHT, right->transferFlags);
 			if (left && left->clearBits)
+			{
 				C3D_FrameBufClear(&left->frameBuf, left->clearBits, left->clearColor, left->clearDepth);
+				left->autoCleared = true;
+			}
 			if (right && right != left && right->clearBits)
+			{
 				C3D_FrameBufClear(&right->frameBuf, right->clearBits, right->clearColor, right->clearDepth);
+				right->autoCleared = true;
+			}
 			gfxConfigScreen(GFX_TOP, false);
 		}
 	}
@@ -77,7 +107,10 @@ static void onVBlank1(C3D_UNUSED void* unused)
 			frameStage |= STAGE_WAIT_TRANSFER;
 			C3D_FrameBufTransfer(&target->frameBuf, GFX_BOTTOM, GFX_LEFT, target->transferFlags);
 			if (target->clearBits)
+			{
 				C3D_FrameBufClear(&target->frameBuf, target->clearBits, target->clearColor, target->clearDepth);
+				target->autoCleared = true;
+			}
 			gfxConfigScreen(GFX_BOTTOM, false);
 		}
 	}
@@ -87,10 +120,14 @@ static void onVBlank1(C3D_UNUSED void* unused)
 
 static void onQueueFinish(gxCmdQueue_s* queue)
 {
+	fenceReached = fenceSubmitted;
 	if (measureGpuTime)
 	{
 		osTickCounterUpdate(&gpuTime);
 		measureGpuTime = false;
+		if (frameDeadline && svcGetSystemTick() > frameDeadline)
+			deadlineMisses++;
+		frameDeadline = 0;
 	}
 	if (inSafeTransfer)
 	{
@@ -114,6 +151,7 @@ void C3D_FrameSync(void)
 {
 	u32 cur[2];
 	u32 start[2] = { frameCounter[0], frameCounter[1] };
+	C3D_PROFILE_SCOPE("C3D_FrameSync");
 	do
 	{
 		gspWaitForAnyEvent();
@@ -127,9 +165,15 @@ u32 C3D_FrameCounter(int id)
 	return frameCounter[id];
 }
 
+u32 C3D_FrameDeadlineMisses(void)
+{
+	return deadlineMisses;
+}
+
 static bool C3Di_WaitAndClearQueue(s64 timeout)
 {
 	gxCmdQueue_s* queue = &C3Di_GetContext()->gxQueue;
+	C3D_PROFILE_SCOPE("C3Di_WaitAndClearQueue");
 	if (!gxCmdQueueWait(queue, timeout))
 		return false;
 	if (timeout==0 && frameStage)
@@ -138,6 +182,7 @@ static bool C3Di_WaitAndClearQueue(s64 timeout)
 		gspWaitForAnyEvent();
 	gxCmdQueueStop(queue);
 	gxCmdQueueClear(queue);
+	fenceReached = fenceSubmitted;
 	return true;
 }
 
@@ -210,14 +255,72 @@ float C3D_FrameRate(float fps)
 	return old;
 }
 
+static void C3Di_PaceUpdate(float* mean, float* dev, float sample)
+{
+	float err = sample - *mean;
+	*mean += PACING_ALPHA*err;
+	*dev += PACING_ALPHA*(fabsf(err) - *dev);
+}
+
+static bool C3Di_FramePace(bool nonBlock)
+{
+	if (frameEnded)
+	{
+		frameEnded = false;
+		if (paceValid)
+		{
+			C3Di_PaceUpdate(&paceCpu, &paceCpuDev, C3D_GetProcessingTime());
+			C3Di_PaceUpdate(&paceGpu, &paceGpuDev, C3D_GetDrawingTime());
+		} else
+		{
+			paceCpu = C3D_GetProcessingTime();
+			paceGpu = C3D_GetDrawingTime();
+			paceCpuDev = paceGpuDev = 0.0f;
+			paceValid = true;
+		}
+	}
+
+	frameDeadline = 0;
+	if (!paceValid || !lastVBlank)
+		return true;
+
+	// Aim for the first VBlank the frame can still make, starting as late as possible
+	float budgetMs = paceCpu + paceGpu + PACING_DEV_SCALE*(paceCpuDev + paceGpuDev) + PACING_MARGIN_MS;
+	u64 budget = (u64)(budgetMs*CPU_TICKS_PER_MSEC);
+	u64 now = svcGetSystemTick();
+	u64 vblank = lastVBlank + VBLANK_TICKS;
+	while (vblank < now + budget)
+		vblank += VBLANK_TICKS;
+
+	u64 start = vblank - budget;
+	if (start > now)
+	{
+		if (nonBlock)
+			return false;
+		svcSleepThread((s64)((start - now)*1000000000ULL/SYSCLOCK_ARM11));
+	}
+	frameDeadline = vblank;
+	return true;
+}
+
 bool C3D_FrameBegin(u8 flags)
 {
 	if (inFrame) return false;
+	if (!checkRenderQueueInit()) return false; // Fences only advance with the queue callback installed
 	if (flags & C3D_FRAME_SYNCDRAW)
 		C3D_FrameSync();
 	if (!C3Di_WaitAndClearQueue((flags & C3D_FRAME_NONBLOCK) ? 0 : -1))
 		return false;
+	if (!(flags & C3D_FRAME_LOWLATENCY))
+		frameDeadline = 0;
+	else if (!C3Di_FramePace((flags & C3D_FRAME_NONBLOCK) != 0))
+		return false;
 	inFrame = true;
+	C3Di_CaptureFrameBegin();
+	C3Di_OverdrawFrameBegin();
+#ifdef C3D_PROFILE
+	frameStartTick = C3D_ProfileTicks();
+#endif
 	osTickCounterStart(&cpuTime);
 	return true;
 }
@@ -227,6 +330,7 @@ bool C3D_FrameDrawOn(C3D_RenderTarget* target)
 	if (!inFrame) return false;
 
 	target->used = true;
+	target->autoCleared = false;
 	C3D_SetFrameBuf(&target->frameBuf);
 	C3D_SetViewport(0, 0, target->frameBuf.width, target->frameBuf.height);
 	return true;
@@ -237,7 +341,11 @@ void C3D_FrameSplit(u8 flags)
 	u32 *cmdBuf, cmdBufSize;
 	if (!inFrame) return;
 	if (C3Di_SplitFrame(&cmdBuf, &cmdBufSize))
+	{
+		C3Di_TimingSubmit();
+		C3Di_CaptureList(cmdBuf, cmdBufSize);
 		GX_ProcessCommandList(cmdBuf, cmdBufSize*4, flags);
+	}
 }
 
 void C3D_FrameEnd(u8 flags)
@@ -250,6 +358,12 @@ void C3D_FrameEnd(u8 flags)
 	C3D_FrameSplit(flags);
 	inFrame = false;
 	osTickCounterUpdate(&cpuTime);
+#ifdef C3D_PROFILE
+	C3D_ProfileRecord("C3D_Frame", frameStartTick, C3D_ProfileTicks());
+#endif
+#ifdef C3D_STATS
+	C3Di_StatsFrameEnd();
+#endif
 
 	// Flush the entire linear memory if the user did not explicitly mandate to flush the command list
 	if (!(flags & GX_CMDLIST_FLUSH))
@@ -276,14 +390,41 @@ void C3D_FrameEnd(u8 flags)
 			continue;
 		target->used = false;
 		C3D_FrameBufClear(&target->frameBuf, target->clearBits, target->clearColor, target->clearDepth);
+		target->autoCleared = true;
 	}
 
 	GPUCMD_SetBuffer(ctx->cmdBuf, ctx->cmdBufSize, 0);
+	C3Di_TimingFrameEnd();
+	C3Di_CaptureFrameEnd();
 	measureGpuTime = true;
+	frameEnded = true;
+	fenceSubmitted++;
+	if (!ctx->gxQueue.numEntries)
+		fenceReached = fenceSubmitted; // An empty queue never calls back
 	osTickCounterStart(&gpuTime);
 	gxCmdQueueRun(&ctx->gxQueue);
 }
 
+u32 C3D_FrameFence(void)
+{
+	return inFrame ? fenceSubmitted+1 : fenceSubmitted;
+}
+
+bool C3D_FenceReached(u32 fence)
+{
+	return (s32)(fenceReached - fence) >= 0;
+}
+
+bool C3D_FenceWait(u32 fence)
+{
+	C3D_PROFILE_SCOPE("C3D_FenceWait");
+	if ((s32)(fenceSubmitted - fence) < 0)
+		return false; // Waiting for a frame that has not ended would never return
+	while (!C3D_FenceReached(fence))
+		gspWaitForAnyEvent();
+	return true;
+}
+
 void C3D_FrameEndHook(void (* hook)(void*), void* param)
 {
 	frameEndCb = hook;
@@ -413,6 +554,7 @@ void C3D_RenderTargetSetClear(C3D_RenderTarget* target, C3D_ClearBits clearBits,
 	if (!target->frameBuf.depthBuf) clearBits &= ~C3D_CLEAR_DEPTH;
 
 	C3D_ClearBits oldClearBits = target->clearBits;
+	target->autoCleared = false; // The last clear may have used other values
 	target->clearBits = clearBits;
 	target->clearColor = clearColor;
 	target->clearDepth = clearDepth;
@@ -459,6 +601,23 @@ static void C3Di_SafeMemoryFill(u32* buf0a, u32 buf0v, u32* buf0e, u16 control0,
 	gxCmdQueueRun(&C3Di_GetContext()->gxQueue);
 }
 
+u32 C3Di_QueueDisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags)
+{
+	if (inFrame)
+	{
+		C3D_FrameSplit(0);
+		GX_DisplayTransfer(inadr, indim, outadr, outdim, flags);
+		return fenceSubmitted+1;
+	}
+
+	C3Di_WaitAndClearQueue(-1);
+	inSafeTransfer = true;
+	GX_DisplayTransfer(inadr, indim, outadr, outdim, flags);
+	fenceSubmitted++;
+	gxCmdQueueRun(&C3Di_GetContext()->gxQueue);
+	return fenceSubmitted;
+}
+
 void C3D_SafeDisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags)
 {
 	C3Di_SafeDisplayTransfer(inadr, indim, outadr, outdim, flags);
@@ -0,0 +1,249 @@
+#include "internal.h"
+#include <c3d/shadowmap.h>
+#include <stdlib.h>
+
+typedef struct C3Di_ShadowTarget_s C3Di_ShadowTarget;
+
+struct C3Di_ShadowTarget_s
+{
+	C3Di_ShadowTarget* next;
+	C3D_Tex tex;
+	C3D_RenderTarget* target;
+	u16 size;
+	bool used;
+};
+
+static C3Di_ShadowTarget* shadowPool;
+
+static C3Di_ShadowTarget* C3Di_ShadowTargetAcquire(u16 size)
+{
+	C3Di_ShadowTarget* st;
+	for (st = shadowPool; st; st = st->next)
+	{
+		if (!st->used && st->size == size)
+		{
+			st->used = true;
+			return st;
+		}
+	}
+
+	st = (C3Di_ShadowTarget*)malloc(sizeof(C3Di_ShadowTarget));
+	if (!st) return NULL;
+
+	if (!C3D_TexInitShadow(&st->tex, size, size))
+		goto _fail0;
+
+	st->target = C3D_RenderTargetCreateFromTex(&st->tex, GPU_TEXFACE_2D, 0, GPU_RB_DEPTH24_STENCIL8);
+	if (!st->target)
+		goto _fail1;
+
+	st->size = size;
+	st->used = true;
+	st->next = shadowPool;
+	shadowPool = st;
+	return st;
+
+_fail1:
+	C3D_TexDelete(&st->tex);
+_fail0:
+	free(st);
+	return NULL;
+}
+
+static void C3Di_ShadowTargetRelease(C3D_Tex* tex)
+{
+	C3Di_ShadowTarget* st;
+	for (st = shadowPool; st; st = st->next)
+	{
+		if (&st->tex == tex)
+		{
+			st->used = false;
+			break;
+		}
+	}
+}
+
+void C3D_ShadowMapPurgePool(void)
+{
+	C3Di_ShadowTarget *st, **prevNext = &shadowPool;
+	while ((st = *prevNext))
+	{
+		if (st->used)
+		{
+			prevNext = &st->next;
+			continue;
+		}
+
+		*prevNext = st->next;
+		C3D_RenderTargetDelete(st->target);
+		C3D_TexDelete(&st->tex);
+		free(st);
+	}
+}
+
+void C3Di_ShadowPoolExit(void)
+{
+	// Render targets are destroyed along with the render queue, only the textures remain
+	C3Di_ShadowTarget *st, *next;
+	for (st = shadowPool; st; st = next)
+	{
+		next = st->next;
+		C3D_TexDelete(&st->tex);
+		free(st);
+	}
+	shadowPool = NULL;
+}
+
+void C3D_ShadowMapSplits(float* splits, int numCascades, float near, float far, float lambda)
+{
+	int i;
+	splits[0] = near;
+	for (i = 1; i < numCascades; i ++)
+	{
+		float t = (float)i / numCascades;
+		float logSplit = near * powf(far/near, t);
+		float uniSplit = near + (far-near)*t;
+		splits[i] = lambda*logSplit + (1.0f-lambda)*uniSplit;
+	}
+	splits[numCascades] = far;
+}
+
+bool C3D_ShadowMapInit(C3D_ShadowMap* sm, int numCascades, u16 size)
+{
+	int i;
+	if (numCascades < 1 || numCascades > C3D_SHADOW_MAX_CASCADES)
+		return false;
+
+	memset(sm, 0, sizeof(*sm));
+	sm->numCascades = numCascades;
+	sm->size = size;
+	sm->lambda = 0.75f;
+
+	for (i = 0; i < numCascades; i ++)
+	{
+		C3Di_ShadowTarget* st = C3Di_ShadowTargetAcquire(size);
+		if (!st)
+		{
+			C3D_ShadowMapDelete(sm);
+			return false;
+		}
+		sm->cascades[i].tex = &st->tex;
+		sm->cascades[i].target = st->target;
+	}
+	return true;
+}
+
+void C3D_ShadowMapDelete(C3D_ShadowMap* sm)
+{
+	int i;
+	for (i = 0; i < sm->numCascades; i ++)
+	{
+		C3D_ShadowCascade* c = &sm->cascades[i];
+		if (c->tex)
+			C3Di_ShadowTargetRelease(c->tex);
+		c->tex = NULL;
+		c->target = NULL;
+		c->valid = false;
+	}
+}
+
+static void C3Di_ShadowLightBasis(C3D_FVec lightDir, C3D_FVec* x, C3D_FVec* y, C3D_FVec* z)
+{
+	// The light camera looks down its -Z axis, i.e. along the light direction
+	*z = FVec3_Normalize(FVec3_Negate(lightDir));
+	C3D_FVec up = fabsf(z->y) < 0.99f ? FVec3_New(0.0f, 1.0f, 0.0f) : FVec3_New(1.0f, 0.0f, 0.0f);
+	*x = FVec3_Normalize(FVec3_Cross(up, *z));
+	*y = FVec3_Cross(*z, *x);
+}
+
+u32 C3D_ShadowMapUpdate(C3D_ShadowMap* sm, const C3D_Mtx* view, float fovy, float aspect, float near, float far, C3D_FVec lightDir, bool isLeftHanded)
+{
+	int i;
+	u32 dirty = 0;
+	float splits[C3D_SHADOW_MAX_CASCADES+1];
+	C3D_ShadowMapSplits(splits, sm->numCascades, near, far, sm->lambda);
+
+	// Camera position and forward vector in world space, assuming a rigid view matrix
+	C3D_FVec camPos = FVec3_New(0.0f, 0.0f, 0.0f);
+	for (i = 0; i < 3; i ++)
+		camPos = FVec3_Subtract(camPos, FVec3_Scale(view->r[i], view->r[i].w));
+	C3D_FVec camFwd = FVec3_Normalize(isLeftHanded ? view->r[2] : FVec3_Negate(view->r[2]));
+
+	// Squared slope of the frustum corners relative to the view axis
+	float tanY = tanf(fovy/2.0f);
+	float tanX = tanY*aspect;
+	float t2 = tanX*tanX + tanY*tanY;
+
+	if (lightDir.x != sm->lightDir.x || lightDir.y != sm->lightDir.y || lightDir.z != sm->lightDir.z)
+	{
+		sm->lightDir = lightDir;
+		C3D_ShadowMapInvalidate(sm);
+	}
+
+	C3D_FVec lx, ly, lz;
+	C3Di_ShadowLightBasis(lightDir, &lx, &ly, &lz);
+
+	for (i = 0; i < sm->numCascades; i ++)
+	{
+		C3D_ShadowCascade* c = &sm->cascades[i];
+		float n = splits[i], f = splits[i+1];
+
+		// Bounding sphere of the frustum slice. It only depends on the camera position and
+		// direction, so its radius stays constant while the camera rotates.
+		float d = 0.5f*(f+n)*(1.0f+t2);
+		if (d > f) d = f;
+		float radius = sqrtf((f-d)*(f-d) + f*f*t2);
+
+		// Round the radius up and reserve a texel of slack for the snapping below
+		radius = ceilf(radius*16.0f) / 16.0f;
+		float texel = 2.0f*radius / sm->size;
+		radius += texel;
+		texel = 2.0f*radius / sm->size;
+
+		// Snap the sphere center to whole texels in light space to avoid shimmering
+		C3D_FVec center = FVec3_Add(camPos, FVec3_Scale(camFwd, d));
+		float cx = floorf(FVec3_Dot(lx, center) / texel) * texel;
+		float cy = floorf(FVec3_Dot(ly, center) / texel) * texel;
+		float cz = FVec3_Dot(lz, center);
+		float depth = 2.0f*radius + sm->extend;
+
+		c->splitNear = n;
+		c->splitFar = f;
+
+		if (c->valid && c->radius == radius && c->depth == depth
+			&& c->lightX == cx && c->lightY == cy && fabsf(c->lightZ - cz) < texel)
+			continue;
+
+		c->radius = radius;
+		c->depth = depth;
+		c->lightX = cx;
+		c->lightY = cy;
+		c->lightZ = cz;
+
+		Mtx_Identity(&c->view);
+		c->view.r[0] = FVec4_New(lx.x, lx.y, lx.z, -cx);
+		c->view.r[1] = FVec4_New(ly.x, ly.y, ly.z, -cy);
+		c->view.r[2] = FVec4_New(lz.x, lz.y, lz.z, -(cz + radius + sm->extend));
+
+		Mtx_Ortho(&c->proj, -radius, radius, -radius, radius, 0.0f, depth, false);
+		Mtx_Multiply(&c->viewProj, &c->proj, &c->view);
+
+		c->valid = true;
+		dirty |= BIT(i);
+	}
+
+	return dirty;
+}
+
+bool C3D_ShadowCascadeCull(const C3D_ShadowCascade* c, C3D_FVec center, float radius)
+{
+	center.w = 1.0f;
+	float x = FVec4_Dot(c->view.r[0], center);
+	float y = FVec4_Dot(c->view.r[1], center);
+	float z = FVec4_Dot(c->view.r[2], center);
+
+	if (fabsf(x) > c->radius + radius) return false;
+	if (fabsf(y) > c->radius + radius) return false;
+	if (z > radius || z < -c->depth - radius) return false;
+	return true;
+}
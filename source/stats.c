@@ -0,0 +1,39 @@
+#include "internal.h"
+#include <string.h>
+
+#ifdef C3D_STATS
+C3D_Stats C3Di_Stats;
+static C3D_Stats lastFrame;
+
+void C3Di_StatsFrameEnd(void)
+{
+	lastFrame = C3Di_Stats;
+	memset(&C3Di_Stats, 0, sizeof(C3Di_Stats));
+}
+#endif
+
+void C3D_GetStats(C3D_Stats* out)
+{
+#ifdef C3D_STATS
+	*out = lastFrame;
+#else
+	memset(out, 0, sizeof(*out));
+#endif
+}
+
+void C3D_GetStatsCurrent(C3D_Stats* out)
+{
+#ifdef C3D_STATS
+	*out = C3Di_Stats;
+#else
+	memset(out, 0, sizeof(*out));
+#endif
+}
+
+void C3D_ResetStats(void)
+{
+#ifdef C3D_STATS
+	memset(&C3Di_Stats, 0, sizeof(C3Di_Stats));
+	memset(&lastFrame, 0, sizeof(lastFrame));
+#endif
+}
@@ -37,10 +37,166 @@ void C3D_DirtyTexEnv(C3D_TexEnv* env)
 		ctx->flags |= C3DiF_TexEnv(id);
 }
 
+static inline u32 tevNumArgs(u32 func)
+{
+	switch (func)
+	{
+		case GPU_REPLACE:
+			return 1;
+		case GPU_INTERPOLATE:
+		case GPU_MULTIPLY_ADD:
+		case GPU_ADD_MULTIPLY:
+			return 3;
+		default:
+			return 2;
+	}
+}
+
+// Returns 0 if the constant operand is all zeroes, 1 if it is all ones and -1 otherwise
+static int tevConstOperand(u32 op, u32 color, bool alpha)
+{
+	u32 val, ones;
+	if (alpha)
+	{
+		ones = 0xFF;
+		switch (op&~1)
+		{
+			case GPU_TEVOP_A_SRC_ALPHA: val = color>>24;        break;
+			case GPU_TEVOP_A_SRC_R:     val = color&0xFF;       break;
+			case GPU_TEVOP_A_SRC_G:     val = (color>>8)&0xFF;  break;
+			case GPU_TEVOP_A_SRC_B:     val = (color>>16)&0xFF; break;
+			default:                    return -1;
+		}
+	} else
+	{
+		ones = 0xFFFFFF;
+		switch (op&~1)
+		{
+			case GPU_TEVOP_RGB_SRC_COLOR: val = color&0xFFFFFF;             break;
+			case GPU_TEVOP_RGB_SRC_ALPHA: val = (color>>24)*0x010101;       break;
+			case GPU_TEVOP_RGB_SRC_R:     val = (color&0xFF)*0x010101;      break;
+			case GPU_TEVOP_RGB_SRC_G:     val = ((color>>8)&0xFF)*0x010101; break;
+			case GPU_TEVOP_RGB_SRC_B:     val = ((color>>16)&0xFF)*0x010101; break;
+			default:                      return -1;
+		}
+	}
+	if (op & 1)
+		val ^= ones;
+	return val == ones ? 1 : val == 0 ? 0 : -1;
+}
+
+static inline void tevPick(u32* src, u32* op, u32 func, u16* outFunc, int a, int b)
+{
+	*src = ((*src>>(4*a))&0xF) | (((*src>>(4*b))&0xF)<<4);
+	*op  = ((*op >>(4*a))&0xF) | (((*op >>(4*b))&0xF)<<4);
+	*outFunc = func;
+}
+
+// Fold operations with identity constant operands into simpler ones
+static void tevFold(u32* src, u32* op, u16* func, u32 color, bool alpha)
+{
+	int i, c[3];
+	for (;;)
+	{
+		for (i = 0; i < 3; i ++)
+			c[i] = ((*src>>(4*i))&0xF) == GPU_CONSTANT ? tevConstOperand((*op>>(4*i))&0xF, color, alpha) : -1;
+
+		switch (*func)
+		{
+			case GPU_MODULATE:
+				if (c[1] == 1)      tevPick(src, op, GPU_REPLACE, func, 0, 1);
+				else if (c[0] == 1) tevPick(src, op, GPU_REPLACE, func, 1, 0);
+				else return;
+				break;
+			case GPU_ADD:
+				if (c[1] == 0)      tevPick(src, op, GPU_REPLACE, func, 0, 1);
+				else if (c[0] == 0) tevPick(src, op, GPU_REPLACE, func, 1, 0);
+				else return;
+				break;
+			case GPU_SUBTRACT:
+				if (c[1] == 0)      tevPick(src, op, GPU_REPLACE, func, 0, 1);
+				else return;
+				break;
+			case GPU_INTERPOLATE:
+				if (c[2] == 1)      tevPick(src, op, GPU_REPLACE, func, 0, 1);
+				else if (c[2] == 0) tevPick(src, op, GPU_REPLACE, func, 1, 0);
+				else return;
+				break;
+			case GPU_MULTIPLY_ADD:
+				if (c[2] == 0)      tevPick(src, op, GPU_MODULATE, func, 0, 1);
+				else return;
+				break;
+			case GPU_ADD_MULTIPLY:
+				if (c[2] == 1)      tevPick(src, op, GPU_ADD, func, 0, 1);
+				else return;
+				break;
+			default:
+				return;
+		}
+	}
+}
+
+// Brings a stage into a canonical form so that equivalent setups compare equal:
+// identity constants are folded away, and unused sources, operands and colors are cleared
+static void C3Di_TexEnvCanon(C3D_TexEnv* out, const C3D_TexEnv* in)
+{
+	u32 srcRgb = in->srcRgb, srcAlpha = in->srcAlpha;
+	u32 opRgb = in->opRgb, opAlpha = in->opAlpha;
+	u32 mask;
+	int i;
+
+	memset(out, 0, sizeof(*out));
+	out->funcRgb = in->funcRgb;
+	out->funcAlpha = in->funcAlpha;
+	out->scaleRgb = in->scaleRgb;
+	out->scaleAlpha = in->scaleAlpha;
+
+	tevFold(&srcRgb, &opRgb, &out->funcRgb, in->color, false);
+	tevFold(&srcAlpha, &opAlpha, &out->funcAlpha, in->color, true);
+
+	mask = (1U << (4*tevNumArgs(out->funcRgb))) - 1;
+	out->srcRgb = srcRgb & mask;
+	out->opRgb = opRgb & mask;
+	mask = (1U << (4*tevNumArgs(out->funcAlpha))) - 1;
+	out->srcAlpha = srcAlpha & mask;
+	out->opAlpha = opAlpha & mask;
+
+	for (i = 0; i < 3; i ++)
+	{
+		if (((out->srcRgb>>(4*i))&0xF) == GPU_CONSTANT || ((out->srcAlpha>>(4*i))&0xF) == GPU_CONSTANT)
+		{
+			out->color = in->color;
+			break;
+		}
+	}
+}
+
+static inline u32 C3Di_TexEnvHash(const C3D_TexEnv* env)
+{
+	const u32* p = (const u32*)env;
+	u32 i, hash = 2166136261U;
+	for (i = 0; i < sizeof(C3D_TexEnv)/sizeof(u32); i ++)
+		hash = (hash ^ p[i]) * 16777619U;
+	return hash;
+}
+
 void C3Di_TexEnvBind(int id, C3D_TexEnv* env)
 {
+	C3D_Context* ctx = C3Di_GetContext();
+	C3D_TexEnv canon;
+
+	// Skip the upload if the hardware already holds an equivalent setup
+	C3Di_TexEnvCanon(&canon, env);
+	u32 hash = C3Di_TexEnvHash(&canon);
+	if ((ctx->texEnvHwValid & BIT(id)) && ctx->texEnvHash[id] == hash && memcmp(&ctx->texEnvHw[id], &canon, sizeof(canon)) == 0)
+		return;
+
+	ctx->texEnvHwValid |= BIT(id);
+	ctx->texEnvHash[id] = hash;
+	ctx->texEnvHw[id] = canon;
+
 	if (id >= 4) id += 2;
-	GPUCMD_AddIncrementalWrites(GPUREG_TEXENV0_SOURCE + id*8, (u32*)env, sizeof(C3D_TexEnv)/sizeof(u32));
+	GPUCMD_AddIncrementalWrites(GPUREG_TEXENV0_SOURCE + id*8, (u32*)&canon, sizeof(C3D_TexEnv)/sizeof(u32));
 }
 
 void C3D_TexEnvBufUpdate(int mode, int mask)
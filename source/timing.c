@@ -0,0 +1,196 @@
+#include "internal.h"
+#include <c3d/renderqueue.h>
+#include <c3d/timing.h>
+
+// Command lists waiting for their completion interrupt
+#define TIMING_MAX_LISTS 64
+
+typedef struct
+{
+	const char* name;
+	u64 gpuFrame;           // Ticks spent on the frame being executed
+	u64 cpuAccum, cpuFrame; // Ticks spent recording the current and the submitted frame
+	float gpu[C3D_TIMING_WINDOW];
+	float cpu[C3D_TIMING_WINDOW];
+	u32 pos, count;
+} C3Di_TimingScope;
+
+static C3Di_TimingScope scopes[C3D_TIMING_MAX_SCOPES];
+static int numScopes, curScope = -1;
+static u32 usedAccum, usedFrame;
+static u64 cpuStart, lastEvent;
+static bool initialized;
+
+static s8 listScope[TIMING_MAX_LISTS];
+static volatile u32 listHead, listTail;
+static u32 frameFirst;
+static volatile bool sealed;
+
+static void C3Di_TimingCommit(void)
+{
+	int i;
+	for (i = 0; i < numScopes; i ++)
+	{
+		C3Di_TimingScope* s = &scopes[i];
+		if (usedFrame & BIT(i))
+		{
+			s->gpu[s->pos] = s->gpuFrame / CPU_TICKS_PER_MSEC;
+			s->cpu[s->pos] = s->cpuFrame / CPU_TICKS_PER_MSEC;
+			s->pos = (s->pos + 1) % C3D_TIMING_WINDOW;
+			if (s->count < C3D_TIMING_WINDOW)
+				s->count ++;
+		}
+		s->gpuFrame = 0;
+	}
+	sealed = false;
+}
+
+// Lists complete in submission order, each one starting when the previous command finished
+static void onP3D(C3D_UNUSED void* unused)
+{
+	u64 now = svcGetSystemTick();
+	if (listHead == listTail)
+		return;
+
+	s8 scope = listScope[listHead % TIMING_MAX_LISTS];
+	listHead++;
+	if (scope >= 0)
+		scopes[scope].gpuFrame += now - lastEvent;
+	lastEvent = now;
+
+	if (sealed && listHead == listTail)
+		C3Di_TimingCommit();
+}
+
+void C3Di_TimingSubmit(void)
+{
+	if (!initialized || listTail - listHead >= TIMING_MAX_LISTS)
+		return;
+	listScope[listTail % TIMING_MAX_LISTS] = curScope;
+	listTail++;
+}
+
+void C3Di_TimingFrameEnd(void)
+{
+	int i;
+	if (!initialized)
+		return;
+
+	if (curScope >= 0)
+	{
+		scopes[curScope].cpuAccum += svcGetSystemTick() - cpuStart;
+		curScope = -1;
+	}
+
+	// Lists of a previous frame that never reported back are dropped
+	if (listHead != frameFirst && sealed)
+	{
+		listHead = frameFirst;
+		for (i = 0; i < numScopes; i ++)
+			scopes[i].gpuFrame = 0;
+	}
+	frameFirst = listTail;
+
+	for (i = 0; i < numScopes; i ++)
+	{
+		scopes[i].cpuFrame = scopes[i].cpuAccum;
+		scopes[i].cpuAccum = 0;
+	}
+	usedFrame = usedAccum;
+	usedAccum = 0;
+
+	lastEvent = svcGetSystemTick();
+	sealed = true;
+	if (listHead == listTail)
+		C3Di_TimingCommit();
+}
+
+void C3Di_TimingExit(void)
+{
+	if (!initialized)
+		return;
+	gspSetEventCallback(GSPGPU_EVENT_P3D, NULL, NULL, false);
+	initialized = false;
+	numScopes = 0;
+	curScope = -1;
+	listHead = listTail = frameFirst = 0;
+	sealed = false;
+}
+
+int C3D_TimingScope(const char* name)
+{
+	int i;
+	for (i = 0; i < numScopes; i ++)
+		if (strcmp(scopes[i].name, name) == 0)
+			return i;
+	if (numScopes == C3D_TIMING_MAX_SCOPES)
+		return -1;
+
+	if (!initialized)
+	{
+		gspSetEventCallback(GSPGPU_EVENT_P3D, onP3D, NULL, false);
+		initialized = true;
+	}
+
+	C3Di_TimingScope* s = &scopes[numScopes];
+	memset(s, 0, sizeof(*s));
+	s->name = name;
+	return numScopes++;
+}
+
+void C3D_TimingBegin(int scope)
+{
+	if (scope < 0 || scope >= numScopes)
+		return;
+
+	// Commands recorded so far belong to the previous scope
+	if (curScope >= 0)
+		C3D_TimingEnd();
+	else
+		C3D_FrameSplit(0);
+	curScope = scope;
+	usedAccum |= BIT(scope);
+	cpuStart = svcGetSystemTick();
+}
+
+void C3D_TimingEnd(void)
+{
+	if (curScope < 0)
+		return;
+
+	C3D_FrameSplit(0);
+	scopes[curScope].cpuAccum += svcGetSystemTick() - cpuStart;
+	curScope = -1;
+}
+
+bool C3D_TimingGet(int scope, C3D_TimingInfo* info)
+{
+	u32 i;
+	if (scope < 0 || scope >= numScopes)
+		return false;
+
+	const C3Di_TimingScope* s = &scopes[scope];
+	memset(info, 0, sizeof(*info));
+	info->name = s->name;
+	info->frames = s->count;
+	for (i = 0; i < s->count; i ++)
+	{
+		info->gpuAvg += s->gpu[i];
+		info->cpuAvg += s->cpu[i];
+		if (s->gpu[i] > info->gpuMax) info->gpuMax = s->gpu[i];
+		if (s->cpu[i] > info->cpuMax) info->cpuMax = s->cpu[i];
+	}
+	if (s->count)
+	{
+		info->gpuAvg /= s->count;
+		info->cpuAvg /= s->count;
+	}
+	return true;
+}
+
+void C3D_TimingReset(void)
+{
+	int i;
+	for (i = 0; i < numScopes; i ++)
+		scopes[i].pos = scopes[i].count = 0;
+}
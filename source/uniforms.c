@@ -23,6 +23,7 @@ void C3D_UpdateUniforms(GPU_SHADER_TYPE type)
 {
 	int offset = type == GPU_GEOMETRY_SHADER ? (GPUREG_GSH_BOOLUNIFORM-GPUREG_VSH_BOOLUNIFORM) : 0;
 	int i = 0;
+	C3D_PROFILE_SCOPE("C3D_UpdateUniforms");
 
 	// Update FVec uniforms that come from shader constants
 	if (C3Di_ShaderFVecData[type].dirty)
@@ -0,0 +1,113 @@
+#include "internal.h"
+#include <c3d/videotex.h>
+
+static u16 C3Di_VideoTexSize(u16 size)
+{
+	u16 texSize = 8;
+	while (texSize < size)
+		texSize <<= 1;
+	return texSize;
+}
+
+bool C3D_VideoTexInit(C3D_VideoTex* vt, u16 width, u16 height, GPU_TEXCOLOR fmt, int numBuffers)
+{
+	int i;
+	memset(vt, 0, sizeof(*vt));
+	vt->current = -1;
+	vt->writing = -1;
+	if ((fmt != GPU_RGB565 && fmt != GPU_RGB8) || numBuffers < 2 || numBuffers > C3D_VIDEOTEX_MAX_BUFFERS
+		|| !width || !height || (width & 1) || (height & 1) || width > 1024 || height > 1024)
+		return false;
+
+	u16 texWidth = C3Di_VideoTexSize(width), texHeight = C3Di_VideoTexSize(height);
+	for (i = 0; i < numBuffers; i ++)
+	{
+		if (!C3D_TexInit(&vt->tex[i], texWidth, texHeight, fmt))
+		{
+			while (i--)
+				C3D_TexDelete(&vt->tex[i]);
+			return false;
+		}
+		// Filtering at the edges of the video blends in the unused area, so keep it black
+		memset(vt->tex[i].data, 0, vt->tex[i].size);
+		C3D_TexSetFilter(&vt->tex[i], GPU_LINEAR, GPU_LINEAR);
+		C3D_TexSetWrap(&vt->tex[i], GPU_CLAMP_TO_EDGE, GPU_CLAMP_TO_EDGE);
+		C3D_TexFlush(&vt->tex[i]);
+		vt->fence[i] = C3D_FrameFence();
+	}
+	vt->numBuffers = numBuffers;
+	vt->width = width;
+	vt->height = height;
+	return true;
+}
+
+void C3D_VideoTexDelete(C3D_VideoTex* vt)
+{
+	int i;
+	for (i = 0; i < vt->numBuffers; i ++)
+	{
+		C3D_FenceWait(vt->fence[i]);
+		C3D_TexDelete(&vt->tex[i]);
+	}
+	memset(vt, 0, sizeof(*vt));
+	vt->current = -1;
+	vt->writing = -1;
+}
+
+C3D_Tex* C3D_VideoTexBegin(C3D_VideoTex* vt, bool wait)
+{
+	int i, id;
+	C3D_PROFILE_SCOPE("C3D_VideoTexBegin");
+	if (vt->writing >= 0)
+		return &vt->tex[vt->writing];
+
+	// Buffers are used in rotation, so the one after the current frame was sampled the longest ago
+	for (i = 1; i <= vt->numBuffers; i ++)
+	{
+		id = (vt->current + i) % vt->numBuffers;
+		if (id != vt->current && C3D_FenceReached(vt->fence[id]))
+		{
+			vt->writing = id;
+			return &vt->tex[id];
+		}
+	}
+
+	id = (vt->current + 1) % vt->numBuffers;
+	if (!wait || !C3D_FenceWait(vt->fence[id]))
+		return NULL;
+	vt->writing = id;
+	return &vt->tex[id];
+}
+
+bool C3D_VideoTexConvert(C3D_VideoTex* vt, const C3D_YUVFrame* frame, u32 y0, u32 y1)
+{
+	if (vt->writing < 0 || y1 > vt->height)
+		return false;
+
+	C3D_Tex* tex = &vt->tex[vt->writing];
+	return C3D_PixFromYUV420Tiled(tex->data, (C3D_PixFormat)tex->fmt, tex->width, tex->height, frame, vt->width, y0, y1);
+}
+
+void C3D_VideoTexEnd(C3D_VideoTex* vt)
+{
+	if (vt->writing < 0)
+		return;
+
+	// The video occupies the top rows of the texture, which come first in memory
+	C3D_Tex* tex = &vt->tex[vt->writing];
+	u32 rows = (vt->height + 7) & ~7;
+	GSPGPU_FlushDataCache(tex->data, rows * (tex->size / tex->height));
+	vt->current = vt->writing;
+	vt->writing = -1;
+}
+
+C3D_Tex* C3D_VideoTexBind(C3D_VideoTex* vt, int unitId)
+{
+	if (vt->current < 0)
+		return NULL;
+
+	C3D_Tex* tex = &vt->tex[vt->current];
+	C3D_TexBind(unitId, tex);
+	vt->fence[vt->current] = C3D_FrameFence();
+	return tex;
+}
@@ -0,0 +1,421 @@
+// Table-driven checks of the pieces of the library that are pure functions of their inputs. They run
+// on the same host build as the benchmark so that libctru's register definitions are available.
+#include <citro3d.h>
+#include "checks.h"
+
+#define CHECK(cond) checkResult(cond, #cond, __FILE__, __LINE__)
+
+static int failures;
+
+static void checkResult(bool ok, const char* expr, const char* file, int line)
+{
+	if (ok)
+		return;
+	printf("%s:%d: check failed: %s\n", file, line, expr);
+	failures ++;
+}
+
+// Index of pixel (x, y) of a tiled texture, y counted in memory order
+static u32 tiledIndex(u32 x, u32 y, u32 width)
+{
+	u32 morton = (x&1) | ((y&1)<<1) | ((x&2)<<1) | ((y&2)<<2) | ((x&4)<<2) | ((y&4)<<3);
+	return ((y>>3)*(width>>3) + (x>>3))*64 + morton;
+}
+
+static void checkVideoOrientation(void)
+{
+	// An 8x4 frame whose top row is white and the rest black, converted into a 16x16 texture. The top
+	// row must land on memory row 0 (t=1) and the rows below the frame must be left alone.
+	static u8 luma[8*4], chroma[4*2];
+	static u16 tex[16*16];
+	C3D_YUVFrame frame = { luma, chroma, chroma, 8, 4 };
+	u32 x, y;
+
+	memset(luma, 16, sizeof(luma));
+	memset(luma, 235, 8);
+	memset(chroma, 128, sizeof(chroma));
+	for (x = 0; x < 16*16; x ++)
+		tex[x] = 0x1234;
+
+	CHECK(C3D_PixFromYUV420Tiled(tex, C3D_PIX_RGB565, 16, 16, &frame, 8, 0, 4));
+	for (y = 0; y < 16; y ++)
+		for (x = 0; x < 16; x ++)
+		{
+			u16 expected = (x >= 8 || y >= 4) ? 0x1234 : y == 0 ? 0xFFFF : 0x0000;
+			CHECK(tex[tiledIndex(x, y, 16)] == expected);
+		}
+
+	// Bands are independent, so converting the lower half alone touches only rows 2 and 3
+	for (x = 0; x < 16*16; x ++)
+		tex[x] = 0x1234;
+	CHECK(C3D_PixFromYUV420Tiled(tex, C3D_PIX_RGB565, 16, 16, &frame, 8, 2, 4));
+	CHECK(tex[tiledIndex(0, 0, 16)] == 0x1234);
+	CHECK(tex[tiledIndex(0, 2, 16)] == 0x0000);
+	CHECK(tex[tiledIndex(7, 3, 16)] == 0x0000);
+	CHECK(!C3D_PixFromYUV420Tiled(tex, C3D_PIX_RGB565, 16, 16, &frame, 8, 1, 4));
+}
+
+static void checkProfileOverflow(void)
+{
+	static const char* names[10] = { "e0", "e1", "e2", "e3", "e4", "e5", "e6", "e7", "e8", "e9" };
+	C3D_ProfileEvent events[8];
+	char trace[1024];
+	u32 i;
+
+	CHECK(C3D_ProfileInit(8));
+	for (i = 0; i < 10; i ++)
+		C3D_ProfileRecord(names[i], 100 + i, 101 + i);
+	CHECK(C3D_ProfileDropped() == 2);
+	CHECK(C3D_ProfileEvents(events, 8) == 8);
+	CHECK(strcmp(events[0].name, "e2") == 0 && strcmp(events[7].name, "e9") == 0);
+	CHECK(C3D_ProfileExport(trace, sizeof(trace)) < sizeof(trace));
+	CHECK(strstr(trace, "\"droppedEvents\":2") != NULL);
+	CHECK(!strstr(trace, "\"e1\""));
+
+	C3D_ProfileClear();
+	CHECK(C3D_ProfileDropped() == 0);
+	CHECK(C3D_ProfileInit(0));
+}
+
+static void checkProcTex(void)
+{
+	// Without LUTs a sample is the combined value as gray, truncated to 8 bits
+	static const struct
+	{
+		u8 func, uClamp, vClamp, uShift, vShift;
+		float u, v;
+		u8 gray;
+	} cases[] =
+	{
+		// Plain ramps, negative coordinates are mirrored around 0
+		{ GPU_PT_U,   GPU_PT_CLAMP_TO_EDGE,     GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  0.50f, 0.20f, 127 },
+		{ GPU_PT_V,   GPU_PT_CLAMP_TO_EDGE,     GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  0.50f, 0.20f,  51 },
+		{ GPU_PT_U,   GPU_PT_CLAMP_TO_EDGE,     GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE, -0.50f, 0.00f, 127 },
+		{ GPU_PT_ADD, GPU_PT_CLAMP_TO_EDGE,     GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  0.50f, 0.25f,  95 },
+		{ GPU_PT_MIN, GPU_PT_CLAMP_TO_EDGE,     GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  0.50f, 0.25f,  63 },
+		{ GPU_PT_MAX, GPU_PT_CLAMP_TO_EDGE,     GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  0.50f, 0.25f, 127 },
+		// Clamp modes
+		{ GPU_PT_U,   GPU_PT_CLAMP_TO_EDGE,     GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  1.50f, 0.00f, 255 },
+		{ GPU_PT_U,   GPU_PT_CLAMP_TO_ZERO,     GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  1.50f, 0.00f,   0 },
+		{ GPU_PT_U,   GPU_PT_REPEAT,            GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  1.25f, 0.00f,  63 },
+		{ GPU_PT_U,   GPU_PT_MIRRORED_REPEAT,   GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  1.25f, 0.00f, 191 },
+		{ GPU_PT_U,   GPU_PT_MIRRORED_REPEAT,   GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  2.25f, 0.00f,  63 },
+		{ GPU_PT_U,   GPU_PT_PULSE,             GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  0.75f, 0.00f, 255 },
+		{ GPU_PT_U,   GPU_PT_PULSE,             GPU_PT_CLAMP_TO_EDGE, GPU_PT_NONE, GPU_PT_NONE,  0.25f, 0.00f,   0 },
+		// Shift modes offset u by half a period (a whole one when mirrored) on odd or even rows of v
+		{ GPU_PT_U,   GPU_PT_REPEAT,            GPU_PT_CLAMP_TO_EDGE, GPU_PT_ODD,  GPU_PT_NONE,  0.25f, 0.50f,  63 },
+		{ GPU_PT_U,   GPU_PT_REPEAT,            GPU_PT_CLAMP_TO_EDGE, GPU_PT_ODD,  GPU_PT_NONE,  0.25f, 2.50f, 191 },
+		{ GPU_PT_U,   GPU_PT_REPEAT,            GPU_PT_CLAMP_TO_EDGE, GPU_PT_EVEN, GPU_PT_NONE,  0.25f, 1.50f, 191 },
+		{ GPU_PT_U,   GPU_PT_REPEAT,            GPU_PT_CLAMP_TO_EDGE, GPU_PT_EVEN, GPU_PT_NONE,  0.25f, 0.50f,  63 },
+		{ GPU_PT_U,   GPU_PT_MIRRORED_REPEAT,   GPU_PT_CLAMP_TO_EDGE, GPU_PT_ODD,  GPU_PT_NONE,  0.25f, 2.50f, 191 },
+		{ GPU_PT_V,   GPU_PT_CLAMP_TO_EDGE,     GPU_PT_REPEAT,        GPU_PT_NONE, GPU_PT_ODD,   2.50f, 0.25f, 191 },
+	};
+	C3D_ProcTex pt;
+	C3D_ProcTexEval ev = { &pt, NULL, NULL, NULL, NULL };
+	C3D_Tex tex;
+	u32 i, y;
+
+	for (i = 0; i < sizeof(cases)/sizeof(cases[0]); i ++)
+	{
+		C3D_ProcTexInit(&pt, 0, 256);
+		pt.rgbFunc = cases[i].func;
+		pt.alphaFunc = cases[i].func;
+		pt.uClamp = cases[i].uClamp;
+		pt.vClamp = cases[i].vClamp;
+		pt.uShift = cases[i].uShift;
+		pt.vShift = cases[i].vShift;
+		CHECK(ProcTexEval_Sample(&ev, cases[i].u, cases[i].v) == (0xFF000000 | 0x010101*cases[i].gray));
+	}
+
+	// Baking a V ramp puts v=1 on memory row 0, like every other texture
+	C3D_ProcTexInit(&pt, 0, 256);
+	pt.rgbFunc = GPU_PT_V;
+	pt.uClamp = GPU_PT_CLAMP_TO_EDGE;
+	pt.vClamp = GPU_PT_CLAMP_TO_EDGE;
+	CHECK(C3D_TexInit(&tex, 8, 8, GPU_RGBA8));
+	CHECK(ProcTexEval_Bake(&ev, &tex, 0.0f, 0.0f, 1.0f, 1.0f));
+	for (y = 0; y < 8; y ++)
+	{
+		// RGBA8 texels are stored A, B, G, R
+		u8 gray = (u8)((1.0f - (y + 0.5f)/8)*255.0f);
+		CHECK(((u8*)tex.data)[tiledIndex(3, y, 8)*4 + 3] == gray);
+	}
+	C3D_TexDelete(&tex);
+}
+
+static void checkCmdStream(void)
+{
+	// Header: incremental flag in bit 31, parameter count-1 in bits 20-27, byte mask in 16-19, register
+	// in 0-15. The first parameter precedes its header and commands are padded to an even word count.
+	static const u32 cmdBuf[] =
+	{
+		1,          0x000F0000 | GPUREG_FACECULLING_CONFIG,
+		1,          0x000F0000 | GPUREG_FACECULLING_CONFIG,
+		0x000000AA, 0x00010000 | GPUREG_BLEND_COLOR,
+		0x0000BB00, 0x00020000 | GPUREG_BLEND_COLOR,
+		0x0000BBAA, 0x00030000 | GPUREG_BLEND_COLOR,
+		0x11,       0x802F0000 | GPUREG_TEXENV0_SOURCE, 0x22, 0x33,
+		5,          0x001F0000 | GPUREG_VIEWPORT_WIDTH, 6, 0,
+		1,          0x000F0000 | GPUREG_DRAWARRAYS,
+		1,          0x000F0000 | GPUREG_FACECULLING_CONFIG,
+		0,          0x002F0000 | GPUREG_FACECULLING_CONFIG, // Truncated, three parameters announced
+	};
+	static const C3D_CmdWrite expected[] =
+	{
+		// A full rewrite before any draw replaces the first write, and repeats the value it stored
+		{  0, GPUREG_FACECULLING_CONFIG,   0xF, C3D_CMDWRITE_OVERWRITTEN, 1          },
+		{  2, GPUREG_FACECULLING_CONFIG,   0xF, C3D_CMDWRITE_REDUNDANT,   1          },
+		// Masked writes only count the bytes they enable, and only replace writes they fully cover
+		{  4, GPUREG_BLEND_COLOR,          0x1, 0,                        0x000000AA },
+		{  6, GPUREG_BLEND_COLOR,          0x2, C3D_CMDWRITE_OVERWRITTEN, 0x0000BB00 },
+		{  8, GPUREG_BLEND_COLOR,          0x3, C3D_CMDWRITE_REDUNDANT,   0x0000BBAA },
+		// Incremental headers advance the register, consecutive ones repeat it
+		{ 10, GPUREG_TEXENV0_SOURCE,       0xF, 0,                        0x11       },
+		{ 10, GPUREG_TEXENV0_SOURCE+1,     0xF, 0,                        0x22       },
+		{ 10, GPUREG_TEXENV0_SOURCE+2,     0xF, 0,                        0x33       },
+		{ 14, GPUREG_VIEWPORT_WIDTH,       0xF, C3D_CMDWRITE_OVERWRITTEN, 5          },
+		{ 14, GPUREG_VIEWPORT_WIDTH,       0xF, 0,                        6          },
+		// The draw uses the pending state, so the write after it replaces nothing
+		{ 18, GPUREG_DRAWARRAYS,           0xF, 0,                        1          },
+		{ 20, GPUREG_FACECULLING_CONFIG,   0xF, C3D_CMDWRITE_REDUNDANT,   1          },
+	};
+	const u32 numExpected = sizeof(expected)/sizeof(expected[0]);
+	const u32 numWords = sizeof(cmdBuf)/sizeof(cmdBuf[0]);
+	C3D_CmdWrite writes[16];
+	static C3D_CmdStats stats;
+	u32 i;
+
+	CHECK(C3D_CmdDecode(cmdBuf, numWords, writes, 4) == numExpected);
+	CHECK(C3D_CmdDecode(cmdBuf, numWords, writes, 16) == numExpected);
+	CHECK(C3D_CmdAnalyze(writes, numExpected, &stats));
+	for (i = 0; i < numExpected; i ++)
+	{
+		CHECK(writes[i].offset == expected[i].offset);
+		CHECK(writes[i].reg == expected[i].reg);
+		CHECK(writes[i].mask == expected[i].mask);
+		CHECK(writes[i].value == expected[i].value);
+		CHECK(writes[i].flags == expected[i].flags);
+	}
+
+	CHECK(stats.writes == numExpected);
+	CHECK(stats.stateWrites == numExpected - 1);
+	CHECK(stats.redundant == 3);
+	CHECK(stats.overwritten == 3);
+	CHECK(stats.draws == 1);
+	CHECK(stats.regWrites[GPUREG_FACECULLING_CONFIG] == 3);
+	CHECK(stats.regWrites[GPUREG_TEXENV0_SOURCE+2] == 1);
+}
+
+static bool writeCaptureHeader(const char* path, u32 version, u32 numLists, u32 numRanges)
+{
+	u32 header[4] = { C3D_CAPTURE_MAGIC, version, numLists, numRanges };
+	FILE* f = fopen(path, "wb");
+	if (!f) return false;
+	bool ok = fwrite(header, sizeof(header), 1, f) == 1;
+	return fclose(f) == 0 && ok;
+}
+
+static u8 captureMem[64];
+
+static const void* resolveCaptureMem(u32 paddr, u32 size, void* user)
+{
+	u32 offset = paddr - 0x18000000;
+	if (paddr < 0x18000000 || offset > sizeof(captureMem) || size > sizeof(captureMem) - offset)
+		return NULL;
+	return captureMem + offset;
+}
+
+static void checkCaptureSnapshot(void)
+{
+	// Two lists drawing 4 and then 8 vertices of 4 bytes from the same buffer
+	static const u32 list0[] =
+	{
+		0x18000000 >> 3,         0x000F0000 | GPUREG_ATTRIBBUFFERS_LOC,
+		0,                       0x000F0000 | GPUREG_ATTRIBBUFFER0_OFFSET,
+		(1u << 28) | (4 << 16),  0x000F0000 | (GPUREG_ATTRIBBUFFER0_OFFSET+2),
+		4,                       0x000F0000 | GPUREG_NUMVERTICES,
+		1,                       0x000F0000 | GPUREG_DRAWARRAYS,
+	};
+	static const u32 list1[] =
+	{
+		8,                       0x000F0000 | GPUREG_NUMVERTICES,
+		1,                       0x000F0000 | GPUREG_DRAWARRAYS,
+	};
+	C3D_Capture cap;
+	u32 i;
+
+	memset(&cap, 0, sizeof(cap));
+	memset(captureMem, 1, sizeof(captureMem));
+	CHECK(C3D_CaptureAddList(&cap, list0, sizeof(list0)/4));
+	CHECK(C3D_CaptureAddMemory(&cap, resolveCaptureMem, NULL));
+	CHECK(cap.numRanges == 1 && cap.ranges[0].size == 16);
+	CHECK(C3D_CaptureMarkRewritten(&cap, resolveCaptureMem, NULL) == 0);
+
+	// The buffer is rewritten before the second list: the range grows, but keeps what the first list read
+	memset(captureMem, 2, sizeof(captureMem));
+	CHECK(C3D_CaptureAddList(&cap, list1, sizeof(list1)/4));
+	CHECK(C3D_CaptureAddMemory(&cap, resolveCaptureMem, NULL));
+	CHECK(cap.numRanges == 1 && cap.ranges[0].paddr == 0x18000000 && cap.ranges[0].size == 32);
+	for (i = 0; cap.numRanges == 1 && i < 32; i ++)
+		CHECK(((u8*)cap.ranges[0].data)[i] == (i < 16 ? 1 : 2));
+	CHECK(C3D_CaptureMarkRewritten(&cap, resolveCaptureMem, NULL) == 1);
+	CHECK(cap.ranges[0].flags == C3D_CAPTURERANGE_REWRITTEN);
+	C3D_CaptureFree(&cap);
+}
+
+static void checkCaptureFile(void)
+{
+	static const char path[] = "checks.c3dc";
+	static u32 list0[] = { 1, 0x000F0000 | GPUREG_FACECULLING_CONFIG }, list1[] = { 0 };
+	static u8 range0[5] = { 1, 2, 3, 4, 5 }, range1[8] = { 6, 7, 8, 9, 10, 11, 12, 13 };
+	C3D_CaptureList lists[] = { { list0, 2 }, { list1, 0 } };
+	C3D_CaptureRange ranges[] =
+	{
+		{ 0x18000000, sizeof(range0), range0, 0 },
+		{ 0x20000000, sizeof(range1), range1, C3D_CAPTURERANGE_REWRITTEN },
+	};
+	C3D_Capture cap = { lists, 2, ranges, 2 }, loaded;
+	u32 i;
+
+	// Range sizes that aren't a multiple of 4 are padded in the file and trimmed again on load
+	CHECK(C3D_CaptureSave(&cap, path));
+	CHECK(C3D_CaptureLoad(&loaded, path));
+	CHECK(loaded.numLists == 2 && loaded.numRanges == 2);
+	if (loaded.numLists == 2 && loaded.numRanges == 2)
+	{
+		for (i = 0; i < 2; i ++)
+		{
+			CHECK(loaded.lists[i].numWords == lists[i].numWords);
+			CHECK(memcmp(loaded.lists[i].words, lists[i].words, lists[i].numWords*4) == 0);
+			CHECK(loaded.ranges[i].paddr == ranges[i].paddr && loaded.ranges[i].size == ranges[i].size);
+			CHECK(loaded.ranges[i].flags == ranges[i].flags);
+			CHECK(memcmp(loaded.ranges[i].data, ranges[i].data, ranges[i].size) == 0);
+		}
+		CHECK(C3D_CaptureResolve(0x18000001, 4, &loaded) == (u8*)loaded.ranges[0].data + 1);
+		CHECK(C3D_CaptureResolve(0x18000001, 5, &loaded) == NULL);
+		CHECK(C3D_CaptureResolve(0x20000008, 1, &loaded) == NULL);
+	}
+	C3D_CaptureFree(&loaded);
+
+	// Counts that would wrap or blow up the allocations are rejected before allocating, and a capture
+	// that ends early is rejected without leaking what was read so far
+	static const struct
+	{
+		u32 version, numLists, numRanges;
+		bool ok;
+	} headers[] =
+	{
+		{ C3D_CAPTURE_VERSION,   0,          0,        true  },
+		{ 1,                     0,          0,        true  },
+		{ 0,                     0,          0,        false },
+		{ C3D_CAPTURE_VERSION+1, 0,          0,        false },
+		{ C3D_CAPTURE_VERSION,   0xFFFFFFFF, 0,        false },
+		{ C3D_CAPTURE_VERSION,   0,          0x100000, false },
+		{ C3D_CAPTURE_VERSION,   0x0FFFFF,   0,        false },
+		{ C3D_CAPTURE_VERSION,   0,          1,        false },
+	};
+	for (i = 0; i < sizeof(headers)/sizeof(headers[0]); i ++)
+	{
+		CHECK(writeCaptureHeader(path, headers[i].version, headers[i].numLists, headers[i].numRanges));
+		CHECK(C3D_CaptureLoad(&loaded, path) == headers[i].ok);
+		CHECK(loaded.numLists == 0 && loaded.numRanges == 0);
+		if (!headers[i].ok)
+			CHECK(!loaded.lists && !loaded.ranges);
+		C3D_CaptureFree(&loaded);
+	}
+	remove(path);
+}
+
+static u32 addWrite(C3D_CmdWrite* writes, u32 count, u16 reg, u32 value)
+{
+	C3D_CmdWrite w = { 0, reg, 0xF, 0, value };
+	writes[count] = w;
+	return count + 1;
+}
+
+static void checkCostModel(void)
+{
+	// With one fragment per draw and only the per-LUT cost set, the lighting cost is the LUT count
+	static const struct
+	{
+		u32 numLights, permutation, config1;
+		u32 luts;
+	} lightCases[] =
+	{
+		{ 1, 0x00000000, 0x00000000,  8 },
+		{ 3, 0x00000210, 0x00000000, 12 },
+		{ 1, 0x00000000, 0xFFFFFFFF,  0 },
+		// Only D0, light 5's spotlight and light 3's attenuation; light 0 is enabled but not active
+		{ 2, 0x00000053, ~(GPU_LC1_LUTBIT(GPU_LUT_D0) | GPU_LC1_SPOTBIT(5) | GPU_LC1_ATTNBIT(3) | GPU_LC1_SPOTBIT(0)), 3 },
+		// DA has no common disable bit, so clearing bit 23 enables nothing
+		{ 1, 0x00000000, ~GPU_LC1_LUTBIT(GPU_LUT_DA), 0 },
+	};
+	// Immediate attributes complete a vertex once every shader input has been written
+	static const struct
+	{
+		u32 numAttr, attribs;
+		u32 vertices;
+	} immCases[] =
+	{
+		{ 0, 6, 6 },
+		{ 2, 9, 3 },
+		{ 3, 8, 2 },
+	};
+	C3D_CmdWrite writes[64];
+	C3D_CostParams params;
+	C3D_CostEstimate est;
+	u32 i, j, n;
+
+	memset(&params, 0, sizeof(params));
+	params.clockHz = 1.0f;
+	params.fragmentsPerPrim = 1.0f;
+	params.maxOverdraw = 1.0f;
+	params.fragPerLightLut = 1.0f;
+
+	for (i = 0; i < sizeof(lightCases)/sizeof(lightCases[0]); i ++)
+	{
+		n = addWrite(writes, 0, GPUREG_FRAMEBUFFER_DIM, 0x00F00140);
+		n = addWrite(writes, n, GPUREG_LIGHTING_ENABLE0, 1);
+		n = addWrite(writes, n, GPUREG_LIGHTING_NUM_LIGHTS, lightCases[i].numLights - 1);
+		n = addWrite(writes, n, GPUREG_LIGHTING_LIGHT_PERMUTATION, lightCases[i].permutation);
+		n = addWrite(writes, n, GPUREG_LIGHTING_CONFIG1, lightCases[i].config1);
+		n = addWrite(writes, n, GPUREG_NUMVERTICES, 3);
+		n = addWrite(writes, n, GPUREG_DRAWARRAYS, 1);
+		C3D_CostEstimateStream(writes, n, &params, &est);
+		CHECK(est.draws == 1 && est.primitives == 1);
+		CHECK(est.lighting == (float)lightCases[i].luts);
+	}
+
+	for (i = 0; i < sizeof(immCases)/sizeof(immCases[0]); i ++)
+	{
+		n = addWrite(writes, 0, GPUREG_VSH_NUM_ATTR, immCases[i].numAttr);
+		n = addWrite(writes, n, GPUREG_START_DRAW_FUNC0, 0);
+		n = addWrite(writes, n, GPUREG_FIXEDATTRIB_INDEX, 0xF);
+		for (j = 0; j < immCases[i].attribs; j ++)
+		{
+			n = addWrite(writes, n, GPUREG_FIXEDATTRIB_DATA0, 0);
+			n = addWrite(writes, n, GPUREG_FIXEDATTRIB_DATA0+1, 0);
+			n = addWrite(writes, n, GPUREG_FIXEDATTRIB_DATA0+2, 0);
+		}
+		n = addWrite(writes, n, GPUREG_START_DRAW_FUNC0, 1);
+		C3D_CostEstimateStream(writes, n, &params, &est);
+		CHECK(est.draws == 1 && est.vertices == immCases[i].vertices);
+	}
+}
+
+int Checks_Run(void)
+{
+	failures = 0;
+	checkVideoOrientation();
+	checkProfileOverflow();
+	checkProcTex();
+	checkCmdStream();
+	checkCaptureSnapshot();
+	checkCaptureFile();
+	checkCostModel();
+	if (failures)
+		printf("%d check(s) failed\n", failures);
+	else
+		printf("all checks passed\n");
+	return failures;
+}
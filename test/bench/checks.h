@@ -0,0 +1,5 @@
+#pragma once
+
+// Checks of the library's host-compatible functions against known results, run with bench -c.
+// Returns the number of failed checks.
+int Checks_Run(void);
@@ -0,0 +1,674 @@
+// Runs synthetic frames through the whole library on top of the recording backend and reports CPU time
+// per draw, command words per draw and allocations per frame. Results can be stored as a baseline and
+// later runs compared against it; words and allocations are deterministic and must not grow. CPU time
+// depends on the machine, so it is only checked when a tolerance is given and the baseline was written
+// locally; the checked-in baseline.txt leaves it out.
+#include <citro3d.h>
+#include "shim/recorder.h"
+#include "checks.h"
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+
+#define WARMUP_FRAMES 4
+#define CMDBUF_SIZE   0x800000
+#define MAX_SCENES    16
+
+typedef struct
+{
+	float pos[3];
+	float tc[2];
+	float nrm[3];
+} Vertex;
+
+typedef struct
+{
+	const char* name;
+	void (* init)(void);
+	void (* frame)(u32 frame);
+	void (* fini)(void);
+} Scene;
+
+typedef struct
+{
+	char name[32];
+	double nsPerDraw;
+	double wordsPerDraw;
+	double allocsPerFrame;
+} BenchResult;
+
+static u32 shaderCode[64], shaderOpdescs[8];
+static DVLP_s dvlp;
+static DVLE_s dvle;
+static shaderInstance_s vsh;
+static shaderProgram_s program;
+
+static C3D_RenderTarget* target;
+static Vertex* cubeVbo;
+static Vertex* spriteVbo;
+static u16* cubeIbo;
+static C3D_Tex textures[4];
+static C3D_Tex streamTex[2];
+static u32* streamData;
+static C3D_Mtx projection;
+static C3D_Mtx modelView[64];
+
+static C3D_LightEnv lightEnv;
+static C3D_Light lights[8];
+static C3D_LightLut lutPhong;
+
+#define NUM_SPRITES    2000
+#define NUM_CHARACTERS 32
+#define NUM_BONES      20
+#define NUM_OBJECTS    300
+
+static void setupGeometry(void)
+{
+	static const float corners[8][3] =
+	{
+		{ -0.5f, -0.5f, -0.5f }, { +0.5f, -0.5f, -0.5f }, { +0.5f, +0.5f, -0.5f }, { -0.5f, +0.5f, -0.5f },
+		{ -0.5f, -0.5f, +0.5f }, { +0.5f, -0.5f, +0.5f }, { +0.5f, +0.5f, +0.5f }, { -0.5f, +0.5f, +0.5f },
+	};
+	static const u8 faces[6][4] = { {0,3,2,1}, {4,5,6,7}, {0,4,7,3}, {1,2,6,5}, {0,1,5,4}, {3,7,6,2} };
+	static const float normals[6][3] = { {0,0,-1}, {0,0,1}, {-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0} };
+	static const u8 quad[6] = { 0, 1, 2, 2, 3, 0 };
+	int f, i;
+
+	cubeVbo = (Vertex*)linearAlloc(36*sizeof(Vertex));
+	cubeIbo = (u16*)linearAlloc(36*sizeof(u16));
+	spriteVbo = (Vertex*)linearAlloc(NUM_SPRITES*4*sizeof(Vertex));
+	for (f = 0; f < 6; f ++)
+		for (i = 0; i < 6; i ++)
+		{
+			Vertex* v = &cubeVbo[f*6+i];
+			memcpy(v->pos, corners[faces[f][quad[i]]], sizeof(v->pos));
+			memcpy(v->nrm, normals[f], sizeof(v->nrm));
+			v->tc[0] = (quad[i] == 1 || quad[i] == 2) ? 1.0f : 0.0f;
+			v->tc[1] = quad[i] >= 2 ? 1.0f : 0.0f;
+			cubeIbo[f*6+i] = f*6+i;
+		}
+
+	for (i = 0; i < 64; i ++)
+	{
+		Mtx_Identity(&modelView[i]);
+		Mtx_Translate(&modelView[i], (i%8) - 3.5f, (i/8) - 3.5f, -10.0f, true);
+		Mtx_RotateY(&modelView[i], i*0.1f, true);
+	}
+	Mtx_PerspTilt(&projection, C3D_AngleFromDegrees(60.0f), C3D_AspectRatioTop, 0.1f, 100.0f, false);
+}
+
+static void setupState(void)
+{
+	C3D_AttrInfo* attrInfo = C3D_GetAttrInfo();
+	AttrInfo_Init(attrInfo);
+	AttrInfo_AddLoader(attrInfo, 0, GPU_FLOAT, 3);
+	AttrInfo_AddLoader(attrInfo, 1, GPU_FLOAT, 2);
+	AttrInfo_AddLoader(attrInfo, 2, GPU_FLOAT, 3);
+
+	C3D_BufInfo* bufInfo = C3D_GetBufInfo();
+	BufInfo_Init(bufInfo);
+	BufInfo_Add(bufInfo, cubeVbo, sizeof(Vertex), 3, 0x210);
+
+	C3D_TexEnv* env = C3D_GetTexEnv(0);
+	C3D_TexEnvInit(env);
+	C3D_TexEnvSrc(env, C3D_Both, GPU_TEXTURE0, GPU_PRIMARY_COLOR, GPU_PRIMARY_COLOR);
+	C3D_TexEnvFunc(env, C3D_Both, GPU_MODULATE);
+
+	C3D_DepthTest(true, GPU_GREATER, GPU_WRITE_ALL);
+	C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_ONE, GPU_ZERO, GPU_ONE, GPU_ZERO);
+	C3D_TexBind(0, &textures[0]);
+	C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, 0, &projection);
+}
+
+static bool setupShared(void)
+{
+	static u32 pixels[64*64];
+	int i, j;
+
+	dvlp.codeSize = sizeof(shaderCode)/4;
+	dvlp.codeData = shaderCode;
+	dvlp.opdescSize = sizeof(shaderOpdescs)/4;
+	dvlp.opcdescData = shaderOpdescs;
+	dvle.type = VERTEX_SHDR;
+	dvle.dvlp = &dvlp;
+	vsh.dvle = &dvle;
+	program.vertexShader = &vsh;
+
+	target = C3D_RenderTargetCreate(240, 400, GPU_RB_RGBA8, GPU_RB_DEPTH24_STENCIL8);
+	if (!target)
+		return false;
+	C3D_RenderTargetSetOutput(target, GFX_TOP, GFX_LEFT,
+		GX_TRANSFER_FLIP_VERT(0) | GX_TRANSFER_OUT_TILED(0) | GX_TRANSFER_RAW_COPY(0) |
+		GX_TRANSFER_IN_FORMAT(GX_TRANSFER_FMT_RGBA8) | GX_TRANSFER_OUT_FORMAT(GX_TRANSFER_FMT_RGB8) |
+		GX_TRANSFER_SCALING(GX_TRANSFER_SCALE_NO));
+
+	setupGeometry();
+	for (i = 0; i < 4; i ++)
+	{
+		if (!C3D_TexInit(&textures[i], 64, 64, GPU_RGBA8))
+			return false;
+		for (j = 0; j < 64*64; j ++)
+			pixels[j] = 0xFF000000 | (j * 0x10101 * (i+1));
+		C3D_TexUpload(&textures[i], pixels);
+	}
+
+	C3D_BindProgram(&program);
+	return true;
+}
+
+static void drawCubes(u32 count, int churn)
+{
+	u32 i;
+	for (i = 0; i < count; i ++)
+	{
+		if (churn >= 1)
+			C3D_TexBind(0, &textures[i & 3]);
+		if (churn >= 2)
+		{
+			C3D_TexEnvColor(C3D_GetTexEnv(0), 0xFF000000 | (i * 0x10305));
+			C3D_DepthTest(true, (i & 1) ? GPU_GREATER : GPU_GEQUAL, GPU_WRITE_ALL);
+			if (i & 2)
+				C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA);
+			else
+				C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_ONE, GPU_ZERO, GPU_ONE, GPU_ZERO);
+		}
+		C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, 4, &modelView[i & 63]);
+		C3D_DrawArrays(GPU_TRIANGLES, 0, 36);
+	}
+}
+
+static void frameDraws1kNone(u32 frame)  { drawCubes(1000, 0); }
+static void frameDraws1kLow(u32 frame)   { drawCubes(1000, 1); }
+static void frameDraws1kHigh(u32 frame)  { drawCubes(1000, 2); }
+static void frameDraws10kNone(u32 frame) { drawCubes(10000, 0); }
+static void frameDraws10kHigh(u32 frame) { drawCubes(10000, 2); }
+
+static void initSprites(void)
+{
+	C3D_Mtx ortho;
+	C3D_BufInfo* bufInfo = C3D_GetBufInfo();
+	BufInfo_Init(bufInfo);
+	BufInfo_Add(bufInfo, spriteVbo, sizeof(Vertex), 3, 0x210);
+	C3D_DepthTest(false, GPU_ALWAYS, GPU_WRITE_COLOR);
+	C3D_AlphaBlend(GPU_BLEND_ADD, GPU_BLEND_ADD, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA, GPU_SRC_ALPHA, GPU_ONE_MINUS_SRC_ALPHA);
+	Mtx_OrthoTilt(&ortho, 0.0f, 400.0f, 240.0f, 0.0f, 0.0f, 1.0f, true);
+	C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, 0, &ortho);
+	Mtx_Identity(&ortho);
+	C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, 4, &ortho);
+}
+
+static void frameSprites(u32 frame)
+{
+	int i, j;
+	// Animated UI: every sprite moves, so the whole vertex buffer is rewritten each frame
+	for (i = 0; i < NUM_SPRITES; i ++)
+	{
+		float x = (float)((i*37 + frame*3) % 384);
+		float y = (float)((i*11 + frame) % 224);
+		for (j = 0; j < 4; j ++)
+		{
+			Vertex* v = &spriteVbo[i*4+j];
+			v->pos[0] = x + (j & 1 ? 16.0f : 0.0f);
+			v->pos[1] = y + (j & 2 ? 16.0f : 0.0f);
+			v->pos[2] = 0.5f;
+			v->tc[0] = j & 1 ? 1.0f : 0.0f;
+			v->tc[1] = j & 2 ? 1.0f : 0.0f;
+			v->nrm[0] = v->nrm[1] = 0.0f;
+			v->nrm[2] = 1.0f;
+		}
+	}
+	for (i = 0; i < NUM_SPRITES; i ++)
+	{
+		C3D_TexBind(0, &textures[(i / 8) % 3]);
+		C3D_DrawArrays(GPU_TRIANGLE_STRIP, i*4, 4);
+	}
+}
+
+static void frameSkinned(u32 frame)
+{
+	C3D_Mtx bones[NUM_BONES];
+	int c, b, m;
+	for (c = 0; c < NUM_CHARACTERS; c ++)
+	{
+		for (b = 0; b < NUM_BONES; b ++)
+		{
+			Mtx_Identity(&bones[b]);
+			Mtx_Translate(&bones[b], 0.0f, b*0.1f, 0.0f, true);
+			Mtx_RotateY(&bones[b], (frame + c + b) * 0.05f, true);
+		}
+		C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, 4, &modelView[c & 63]);
+		// 3x4 is enough for affine bone transforms
+		for (b = 0; b < NUM_BONES; b ++)
+			C3D_FVUnifMtx3x4(GPU_VERTEX_SHADER, 8 + b*3, &bones[b]);
+		for (m = 0; m < 6; m ++)
+			C3D_DrawElements(GPU_TRIANGLES, 36, C3D_UNSIGNED_SHORT, cubeIbo);
+	}
+}
+
+static void initLights(void)
+{
+	int i;
+	C3D_TexEnv* env = C3D_GetTexEnv(0);
+	C3D_TexEnvInit(env);
+	C3D_TexEnvSrc(env, C3D_Both, GPU_FRAGMENT_PRIMARY_COLOR, GPU_FRAGMENT_SECONDARY_COLOR, GPU_PRIMARY_COLOR);
+	C3D_TexEnvFunc(env, C3D_Both, GPU_ADD);
+
+	C3D_LightEnvInit(&lightEnv);
+	C3D_LightEnvBind(&lightEnv);
+	LightLut_Phong(&lutPhong, 20.0f);
+	C3D_LightEnvLut(&lightEnv, GPU_LUT_D0, GPU_LUTINPUT_NH, false, &lutPhong);
+	for (i = 0; i < 8; i ++)
+	{
+		C3D_LightInit(&lights[i], &lightEnv);
+		C3D_LightColor(&lights[i], 0.2f + i*0.1f, 0.5f, 1.0f - i*0.1f);
+	}
+}
+
+static void frameLights(u32 frame)
+{
+	static const C3D_Material materials[4] =
+	{
+		{ { 0.1f, 0.1f, 0.1f }, { 0.8f, 0.2f, 0.2f }, { 0.5f, 0.5f, 0.5f }, { 0 }, { 0 } },
+		{ { 0.1f, 0.1f, 0.1f }, { 0.2f, 0.8f, 0.2f }, { 0.5f, 0.5f, 0.5f }, { 0 }, { 0 } },
+		{ { 0.1f, 0.1f, 0.1f }, { 0.2f, 0.2f, 0.8f }, { 0.9f, 0.9f, 0.9f }, { 0 }, { 0 } },
+		{ { 0.2f, 0.2f, 0.2f }, { 0.6f, 0.6f, 0.6f }, { 0.1f, 0.1f, 0.1f }, { 0 }, { 0 } },
+	};
+	int i;
+	for (i = 0; i < 8; i ++)
+	{
+		float a = (frame + i*8) * 0.05f;
+		C3D_FVec pos = FVec4_New(cosf(a)*5.0f, 2.0f, sinf(a)*5.0f - 10.0f, 1.0f);
+		C3D_LightPosition(&lights[i], &pos);
+	}
+	for (i = 0; i < NUM_OBJECTS; i ++)
+	{
+		if (i % 10 == 0)
+			C3D_LightEnvMaterial(&lightEnv, &materials[(i / 10) & 3]);
+		C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, 4, &modelView[i & 63]);
+		C3D_DrawElements(GPU_TRIANGLES, 36, C3D_UNSIGNED_SHORT, cubeIbo);
+	}
+}
+
+static void finiLights(void)
+{
+	C3D_LightEnvBind(NULL);
+}
+
+static void initStreaming(void)
+{
+	int i;
+	for (i = 0; i < 2; i ++)
+		C3D_TexInit(&streamTex[i], 256, 256, GPU_RGBA8);
+	streamData = (u32*)linearAlloc(256*256*4);
+}
+
+static void frameStreaming(u32 frame)
+{
+	int i;
+	// Stands in for a decoder writing a new frame of video
+	for (i = 0; i < 256*256; i ++)
+		streamData[i] = (i + frame) * 0x01010101;
+	for (i = 0; i < 2; i ++)
+		C3D_TexUpload(&streamTex[i], streamData);
+	for (i = 0; i < 100; i ++)
+	{
+		C3D_TexBind(0, &streamTex[i & 1]);
+		C3D_FVUnifMtx4x4(GPU_VERTEX_SHADER, 4, &modelView[i & 63]);
+		C3D_DrawArrays(GPU_TRIANGLES, 0, 36);
+	}
+}
+
+static void finiStreaming(void)
+{
+	int i;
+	for (i = 0; i < 2; i ++)
+		C3D_TexDelete(&streamTex[i]);
+	linearFree(streamData);
+	streamData = NULL;
+}
+
+static const Scene scenes[] =
+{
+	{ "draws_1k_none",   NULL,           frameDraws1kNone,  NULL },
+	{ "draws_1k_low",    NULL,           frameDraws1kLow,   NULL },
+	{ "draws_1k_high",   NULL,           frameDraws1kHigh,  NULL },
+	{ "draws_10k_none",  NULL,           frameDraws10kNone, NULL },
+	{ "draws_10k_high",  NULL,           frameDraws10kHigh, NULL },
+	{ "sprites_ui",      initSprites,    frameSprites,      NULL },
+	{ "skinned",         NULL,           frameSkinned,      NULL },
+	{ "many_lights",     initLights,     frameLights,       finiLights },
+	{ "tex_streaming",   initStreaming,  frameStreaming,    finiStreaming },
+};
+
+static double nowNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+static void runFrame(const Scene* s, u32 frame)
+{
+	C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
+	C3D_FrameDrawOn(target);
+	s->frame(frame);
+	C3D_FrameEnd(0);
+}
+
+static void runScene(const Scene* s, u32 numFrames, const char* capturePrefix, BenchResult* out)
+{
+	Recorder_Counters before, after;
+	C3D_Stats stats;
+	u64 draws = 0;
+	double ns = 0.0;
+	u32 i;
+
+	setupState();
+	if (s->init)
+		s->init();
+	for (i = 0; i < WARMUP_FRAMES; i ++)
+		runFrame(s, i);
+
+	Recorder_GetCounters(&before);
+	for (i = 0; i < numFrames; i ++)
+	{
+		double start = nowNs();
+		runFrame(s, WARMUP_FRAMES + i);
+		ns += nowNs() - start;
+		C3D_GetStats(&stats);
+		draws += stats.draws;
+	}
+	Recorder_GetCounters(&after);
+
+	if (capturePrefix)
+	{
+		char path[256];
+		snprintf(path, sizeof(path), "%s%s.c3dc", capturePrefix, s->name);
+		C3D_FrameCapture(path);
+		runFrame(s, WARMUP_FRAMES + numFrames);
+	}
+
+	if (s->fini)
+		s->fini();
+
+	snprintf(out->name, sizeof(out->name), "%s", s->name);
+	out->nsPerDraw = draws ? ns / draws : 0.0;
+	out->wordsPerDraw = draws ? (double)(after.words - before.words) / draws : 0.0;
+	out->allocsPerFrame = (double)(after.allocs - before.allocs) / numFrames;
+}
+
+// Puts a capture's memory back at the addresses it was taken from, then resubmits its command lists
+// once per frame. The backend records the lists instead of executing them, so this measures submission
+// and checks that a capture is complete enough to be replayed.
+typedef struct
+{
+	void* mem;
+	bool vram; // Allocated from VRAM rather than linear memory
+} ReplayRange;
+
+static int replayCapture(const char* path, u32 numFrames)
+{
+	Recorder_Counters before, after;
+	C3D_Capture cap;
+	u32** lists;
+	ReplayRange* ranges;
+	u32 restored = 0, i, j;
+	double ns = 0.0;
+	int ret = 1;
+
+	if (!C3D_CaptureLoad(&cap, path))
+	{
+		fprintf(stderr, "failed to load %s\n", path);
+		return 1;
+	}
+	lists = (u32**)calloc(cap.numLists + 1, sizeof(u32*));
+	ranges = (ReplayRange*)calloc(cap.numRanges + 1, sizeof(ReplayRange));
+	if (!lists || !ranges)
+	{
+		fprintf(stderr, "out of memory\n");
+		goto _fail;
+	}
+
+	// Ranges first, so that the lists are placed around them
+	for (i = 0; i < cap.numRanges; i ++)
+	{
+		u32 paddr = cap.ranges[i].paddr;
+		ranges[i].vram = paddr >= OS_VRAM_PADDR && paddr - OS_VRAM_PADDR < OS_VRAM_SIZE;
+		ranges[i].mem = Recorder_AllocAt(paddr, cap.ranges[i].size);
+		if (!ranges[i].mem)
+			continue;
+		memcpy(ranges[i].mem, cap.ranges[i].data, cap.ranges[i].size);
+		restored ++;
+	}
+	for (i = 0; i < cap.numLists; i ++)
+	{
+		lists[i] = (u32*)linearAlloc(cap.lists[i].numWords*4);
+		if (!lists[i])
+		{
+			fprintf(stderr, "out of linear memory\n");
+			goto _fail;
+		}
+		memcpy(lists[i], cap.lists[i].words, cap.lists[i].numWords*4);
+	}
+
+	Recorder_GetCounters(&before);
+	for (i = 0; i < numFrames; i ++)
+	{
+		double start = nowNs();
+		for (j = 0; j < cap.numLists; j ++)
+			GX_ProcessCommandList(lists[j], cap.lists[j].numWords*4, 0);
+		ns += nowNs() - start;
+	}
+	Recorder_GetCounters(&after);
+
+	printf("%s: %u command lists, %u of %u memory ranges restored\n", path, cap.numLists, restored, cap.numRanges);
+	printf("%-16s %10s %10s %12s\n", "replay", "ns/frame", "lists", "words/frame");
+	printf("%-16s %10.1f %10.2f %12.2f\n", "", ns / numFrames, (double)(after.lists - before.lists) / numFrames,
+		(double)(after.words - before.words) / numFrames);
+	ret = restored == cap.numRanges ? 0 : 1;
+
+_fail:
+	for (i = 0; lists && i < cap.numLists; i ++)
+		linearFree(lists[i]);
+	for (i = 0; ranges && i < cap.numRanges; i ++)
+	{
+		if (!ranges[i].mem)
+			continue;
+		if (ranges[i].vram)
+			vramFree(ranges[i].mem);
+		else
+			linearFree(ranges[i].mem);
+	}
+	free(lists);
+	free(ranges);
+	C3D_CaptureFree(&cap);
+	return ret;
+}
+
+static bool writeBaseline(const char* path, const BenchResult* results, int count)
+{
+	int i;
+	FILE* f = fopen(path, "w");
+	if (!f)
+		return false;
+	fprintf(f, "# scene ns/draw words/draw allocs/frame\n");
+	for (i = 0; i < count; i ++)
+		fprintf(f, "%s %.1f %.2f %.2f\n", results[i].name, results[i].nsPerDraw, results[i].wordsPerDraw, results[i].allocsPerFrame);
+	fclose(f);
+	return true;
+}
+
+static int readBaseline(const char* path, BenchResult* results, int maxCount)
+{
+	char line[256];
+	int count = 0;
+	FILE* f = fopen(path, "r");
+	if (!f)
+		return -1;
+	while (count < maxCount && fgets(line, sizeof(line), f))
+	{
+		BenchResult* r = &results[count];
+		if (line[0] == '#')
+			continue;
+		if (sscanf(line, "%31s %lf %lf %lf", r->name, &r->nsPerDraw, &r->wordsPerDraw, &r->allocsPerFrame) == 4)
+			count ++;
+	}
+	fclose(f);
+	return count;
+}
+
+static bool worse(double cur, double base, double tolerance)
+{
+	// The baseline is stored rounded to two decimals
+	return cur > base * (1.0 + tolerance) + 0.005;
+}
+
+static int compare(const BenchResult* results, int count, const BenchResult* base, int baseCount, double nsTolerance)
+{
+	int regressions = 0, i, j;
+	for (i = 0; i < count; i ++)
+	{
+		const BenchResult* r = &results[i];
+		for (j = 0; j < baseCount && strcmp(base[j].name, r->name) != 0; j ++);
+		if (j == baseCount)
+		{
+			printf("%-16s not in baseline\n", r->name);
+			continue;
+		}
+		const BenchResult* b = &base[j];
+		if (worse(r->wordsPerDraw, b->wordsPerDraw, 0.0))
+		{
+			printf("%-16s words/draw %.2f -> %.2f\n", r->name, b->wordsPerDraw, r->wordsPerDraw);
+			regressions ++;
+		}
+		if (worse(r->allocsPerFrame, b->allocsPerFrame, 0.0))
+		{
+			printf("%-16s allocs/frame %.2f -> %.2f\n", r->name, b->allocsPerFrame, r->allocsPerFrame);
+			regressions ++;
+		}
+		// The checked-in baseline leaves ns/draw at 0, timings only compare against a local baseline
+		if (nsTolerance > 0.0 && b->nsPerDraw > 0.0 && worse(r->nsPerDraw, b->nsPerDraw, nsTolerance))
+		{
+			printf("%-16s ns/draw %.1f -> %.1f\n", r->name, b->nsPerDraw, r->nsPerDraw);
+			regressions ++;
+		}
+	}
+	return regressions;
+}
+
+static void usage(const char* argv0)
+{
+	fprintf(stderr, "usage: %s [-f frames] [-s scene] [-w baseline] [-b baseline] [-t percent] [-d prefix] [-r capture] [-c]\n", argv0);
+	fprintf(stderr, "  -f frames    frames measured per scene (default 32)\n");
+	fprintf(stderr, "  -s scene     only run scenes whose name contains this\n");
+	fprintf(stderr, "  -w baseline  store the results\n");
+	fprintf(stderr, "  -b baseline  fail if words/draw or allocs/frame grew compared to these results\n");
+	fprintf(stderr, "  -t percent   also fail if ns/draw grew by more than this (baselines written on this machine)\n");
+	fprintf(stderr, "  -d prefix    save a frame capture of each scene to <prefix><scene>.c3dc\n");
+	fprintf(stderr, "  -r capture   replay a frame capture instead of running the scenes\n");
+	fprintf(stderr, "  -c           run the host checks instead of the scenes\n");
+}
+
+int main(int argc, char* argv[])
+{
+	BenchResult results[MAX_SCENES], base[MAX_SCENES];
+	const char* filter = NULL;
+	const char* writePath = NULL;
+	const char* basePath = NULL;
+	const char* capturePrefix = NULL;
+	const char* replayPath = NULL;
+	bool runChecks = false;
+	double nsTolerance = 0.0;
+	int numFrames = 32;
+	int count = 0, i;
+
+	for (i = 1; i < argc; i ++)
+	{
+		if (strcmp(argv[i], "-f") == 0 && i+1 < argc)
+			numFrames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-s") == 0 && i+1 < argc)
+			filter = argv[++i];
+		else if (strcmp(argv[i], "-w") == 0 && i+1 < argc)
+			writePath = argv[++i];
+		else if (strcmp(argv[i], "-b") == 0 && i+1 < argc)
+			basePath = argv[++i];
+		else if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+			nsTolerance = atof(argv[++i]) / 100.0;
+		else if (strcmp(argv[i], "-d") == 0 && i+1 < argc)
+			capturePrefix = argv[++i];
+		else if (strcmp(argv[i], "-r") == 0 && i+1 < argc)
+			replayPath = argv[++i];
+		else if (strcmp(argv[i], "-c") == 0)
+			runChecks = true;
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (numFrames <= 0)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (!Recorder_Init())
+	{
+		fprintf(stderr, "failed to map linear memory and VRAM\n");
+		return 1;
+	}
+	if (runChecks)
+	{
+		int failures = Checks_Run();
+		Recorder_Exit();
+		return failures ? 1 : 0;
+	}
+	if (replayPath)
+	{
+		int ret = replayCapture(replayPath, numFrames);
+		Recorder_Exit();
+		return ret;
+	}
+	if (!C3D_Init(CMDBUF_SIZE) || !setupShared())
+	{
+		fprintf(stderr, "failed to initialize citro3d\n");
+		return 1;
+	}
+
+	printf("%-16s %10s %10s %12s\n", "scene", "ns/draw", "words/draw", "allocs/frame");
+	for (i = 0; i < (int)(sizeof(scenes)/sizeof(scenes[0])); i ++)
+	{
+		if (filter && !strstr(scenes[i].name, filter))
+			continue;
+		runScene(&scenes[i], numFrames, capturePrefix, &results[count]);
+		printf("%-16s %10.1f %10.2f %12.2f\n", results[count].name, results[count].nsPerDraw, results[count].wordsPerDraw, results[count].allocsPerFrame);
+		count ++;
+	}
+
+	for (i = 0; i < 4; i ++)
+		C3D_TexDelete(&textures[i]);
+	C3D_Fini();
+	Recorder_Exit();
+
+	if (writePath && !writeBaseline(writePath, results, count))
+	{
+		fprintf(stderr, "failed to write %s\n", writePath);
+		return 1;
+	}
+	if (basePath)
+	{
+		int baseCount = readBaseline(basePath, base, MAX_SCENES);
+		if (baseCount < 0)
+		{
+			fprintf(stderr, "failed to read %s\n", basePath);
+			return 1;
+		}
+		int regressions = compare(results, count, base, baseCount, nsTolerance);
+		if (regressions)
+		{
+			printf("%d regression(s)\n", regressions);
+			return 1;
+		}
+	}
+	return 0;
+}
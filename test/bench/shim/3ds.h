@@ -0,0 +1,82 @@
+#pragma once
+// Host stand-in for <3ds.h>: the GPU-side headers come straight from libctru, the OS
+// services citro3d uses are declared here and implemented by the recording backend.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <3ds/types.h>
+#include <3ds/gpu/registers.h>
+#include <3ds/gpu/enums.h>
+#include <3ds/gpu/gpu.h>
+#include <3ds/gpu/gx.h>
+#include <3ds/gpu/shbin.h>
+#include <3ds/gpu/shaderProgram.h>
+#include <3ds/services/gspgpu.h>
+#include <3ds/gfx.h>
+
+#define SYSCLOCK_ARM11     268111856
+#define CPU_TICKS_PER_MSEC (SYSCLOCK_ARM11/1000.0)
+
+#define OS_VRAM_VADDR 0x1F000000
+#define OS_VRAM_PADDR 0x18000000
+#define OS_VRAM_SIZE  0x00600000
+
+#define OS_FCRAM_PADDR 0x20000000
+
+void* linearAlloc(size_t size);
+void* linearMemAlign(size_t size, size_t alignment);
+void linearFree(void* mem);
+u32 linearSpaceFree(void);
+void* vramAlloc(size_t size);
+void vramFree(void* mem);
+u32 osConvertVirtToPhys(const void* vaddr);
+
+extern u32 __ctru_linear_heap;
+extern u32 __ctru_linear_heap_size;
+
+typedef struct
+{
+	u64 elapsed;
+	u64 reference;
+} TickCounter;
+
+void osTickCounterStart(TickCounter* cnt);
+void osTickCounterUpdate(TickCounter* cnt);
+double osTickCounterRead(const TickCounter* cnt);
+
+typedef enum
+{
+	USERBREAK_PANIC = 0,
+	USERBREAK_ASSERT = 1,
+	USERBREAK_USER = 2,
+} UserBreakType;
+
+u64 svcGetSystemTick(void);
+void svcSleepThread(s64 ns);
+void svcBreak(UserBreakType breakReason);
+
+typedef struct Thread_tag* Thread;
+Thread threadGetCurrent(void);
+
+typedef enum
+{
+	APTHOOK_ONSUSPEND = 0,
+	APTHOOK_ONRESTORE,
+	APTHOOK_ONSLEEP,
+	APTHOOK_ONWAKEUP,
+	APTHOOK_ONEXIT,
+	APTHOOK_COUNT,
+} APT_HookType;
+
+typedef void (*aptHookFn)(APT_HookType hook, void* param);
+
+typedef struct tag_aptHookCookie
+{
+	struct tag_aptHookCookie* next;
+	aptHookFn callback;
+	void* param;
+} aptHookCookie;
+
+void aptHook(aptHookCookie* cookie, aptHookFn callback, void* param);
+void aptUnhook(aptHookCookie* cookie);
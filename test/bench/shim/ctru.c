@@ -0,0 +1,633 @@
+#define _GNU_SOURCE
+#include "recorder.h"
+#include <stdint.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define LINEAR_VADDR 0x30000000
+#define LINEAR_SIZE  0x04000000
+
+typedef struct
+{
+	u32 addr;
+	u32 size;
+} Block;
+
+typedef struct
+{
+	u32 base, size;
+	Block* blocks; // Sorted by address
+	u32 count, cap;
+} Arena;
+
+typedef struct
+{
+	ThreadFunc func;
+	void* data;
+	bool oneShot;
+} EventCb;
+
+enum
+{
+	GXCMD_LIST,
+	GXCMD_FILL,
+	GXCMD_TRANSFER,
+	GXCMD_COPY,
+};
+
+static Arena linearArena, vramArena;
+static Recorder_Counters counters;
+static gxCmdQueue_s* boundQueue;
+static bool queueRunning, queueBusy;
+static EventCb events[GSPGPU_EVENT_MAX];
+static u8* framebuffers[3];
+
+u32* gpuCmdBuf;
+u32 gpuCmdBufSize;
+u32 gpuCmdBufOffset;
+
+u32 __ctru_linear_heap;
+u32 __ctru_linear_heap_size;
+
+// Allocation counting, hooked up with -Wl,--wrap
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t num, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+	counters.allocs ++;
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t num, size_t size)
+{
+	counters.allocs ++;
+	return __real_calloc(num, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+	counters.allocs ++;
+	return __real_realloc(ptr, size);
+}
+
+static bool Arena_Init(Arena* a, u32 base, u32 size)
+{
+	void* mem = mmap((void*)(uintptr_t)base, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED_NOREPLACE, -1, 0);
+	if (mem == MAP_FAILED)
+		return false;
+	if (mem != (void*)(uintptr_t)base)
+	{
+		munmap(mem, size);
+		return false;
+	}
+	a->base = base;
+	a->size = size;
+	return true;
+}
+
+static void Arena_Fini(Arena* a)
+{
+	if (a->size)
+		munmap((void*)(uintptr_t)a->base, a->size);
+	free(a->blocks);
+	memset(a, 0, sizeof(*a));
+}
+
+static bool Arena_Reserve(Arena* a)
+{
+	if (a->count == a->cap)
+	{
+		u32 cap = a->cap ? a->cap*2 : 64;
+		Block* blocks = (Block*)realloc(a->blocks, cap*sizeof(Block));
+		if (!blocks)
+			return false;
+		a->blocks = blocks;
+		a->cap = cap;
+	}
+	return true;
+}
+
+static void* Arena_Alloc(Arena* a, u32 size, u32 align)
+{
+	u32 pos = a->base, i;
+	if (!a->size || !size || (align & (align-1)) || !Arena_Reserve(a))
+		return NULL;
+
+	// First fit over the gaps between allocated blocks
+	for (i = 0; i <= a->count; i ++)
+	{
+		u32 start = (pos + align-1) &~ (align-1);
+		u32 end = i < a->count ? a->blocks[i].addr : a->base + a->size;
+		if (start <= end && end - start >= size)
+		{
+			memmove(&a->blocks[i+1], &a->blocks[i], (a->count-i)*sizeof(Block));
+			a->blocks[i].addr = start;
+			a->blocks[i].size = size;
+			a->count ++;
+			counters.allocs ++;
+			return (void*)(uintptr_t)start;
+		}
+		if (i < a->count)
+			pos = a->blocks[i].addr + a->blocks[i].size;
+	}
+	return NULL;
+}
+
+static void* Arena_AllocAt(Arena* a, u32 addr, u32 size)
+{
+	u32 i;
+	if (!a->size || !size || addr < a->base || addr - a->base >= a->size || size > a->size - (addr - a->base)
+		|| !Arena_Reserve(a))
+		return NULL;
+
+	for (i = 0; i < a->count && a->blocks[i].addr < addr; i ++);
+	if ((i > 0 && a->blocks[i-1].addr + a->blocks[i-1].size > addr)
+		|| (i < a->count && a->blocks[i].addr - addr < size))
+		return NULL;
+	memmove(&a->blocks[i+1], &a->blocks[i], (a->count-i)*sizeof(Block));
+	a->blocks[i].addr = addr;
+	a->blocks[i].size = size;
+	a->count ++;
+	counters.allocs ++;
+	return (void*)(uintptr_t)addr;
+}
+
+static void Arena_Free(Arena* a, void* mem)
+{
+	u32 addr = (u32)(uintptr_t)mem;
+	u32 lo = 0, hi = a->count;
+	while (lo < hi)
+	{
+		u32 mid = (lo + hi) / 2;
+		if (a->blocks[mid].addr < addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < a->count && a->blocks[lo].addr == addr)
+	{
+		memmove(&a->blocks[lo], &a->blocks[lo+1], (a->count-lo-1)*sizeof(Block));
+		a->count --;
+	}
+}
+
+static bool Arena_Contains(const Arena* a, const void* mem)
+{
+	uintptr_t addr = (uintptr_t)mem;
+	return a->size && addr >= a->base && addr - a->base < a->size;
+}
+
+static u32 Arena_SpaceFree(const Arena* a)
+{
+	u32 used = 0, i;
+	for (i = 0; i < a->count; i ++)
+		used += a->blocks[i].size;
+	return a->size - used;
+}
+
+bool Recorder_Init(void)
+{
+	if (!Arena_Init(&linearArena, LINEAR_VADDR, LINEAR_SIZE))
+		return false;
+	if (!Arena_Init(&vramArena, OS_VRAM_VADDR, OS_VRAM_SIZE))
+	{
+		Arena_Fini(&linearArena);
+		return false;
+	}
+	__ctru_linear_heap = LINEAR_VADDR;
+	__ctru_linear_heap_size = LINEAR_SIZE;
+	memset(&counters, 0, sizeof(counters));
+	return true;
+}
+
+void Recorder_Exit(void)
+{
+	Arena_Fini(&linearArena);
+	Arena_Fini(&vramArena);
+	memset(framebuffers, 0, sizeof(framebuffers));
+	__ctru_linear_heap = 0;
+	__ctru_linear_heap_size = 0;
+}
+
+void Recorder_GetCounters(Recorder_Counters* out)
+{
+	*out = counters;
+}
+
+void* linearMemAlign(size_t size, size_t alignment)
+{
+	return Arena_Alloc(&linearArena, size, alignment < 0x80 ? 0x80 : alignment);
+}
+
+void* linearAlloc(size_t size)
+{
+	return linearMemAlign(size, 0x80);
+}
+
+void linearFree(void* mem)
+{
+	if (Arena_Contains(&linearArena, mem))
+		Arena_Free(&linearArena, mem);
+}
+
+u32 linearSpaceFree(void)
+{
+	return Arena_SpaceFree(&linearArena);
+}
+
+void* vramAlloc(size_t size)
+{
+	return Arena_Alloc(&vramArena, size, 0x80);
+}
+
+void vramFree(void* mem)
+{
+	if (Arena_Contains(&vramArena, mem))
+		Arena_Free(&vramArena, mem);
+}
+
+u32 osConvertVirtToPhys(const void* vaddr)
+{
+	if (Arena_Contains(&linearArena, vaddr))
+		return OS_FCRAM_PADDR + ((uintptr_t)vaddr - LINEAR_VADDR);
+	if (Arena_Contains(&vramArena, vaddr))
+		return OS_VRAM_PADDR + ((uintptr_t)vaddr - OS_VRAM_VADDR);
+	return 0;
+}
+
+void* Recorder_AllocAt(u32 paddr, u32 size)
+{
+	if (paddr >= OS_VRAM_PADDR && paddr < OS_VRAM_PADDR + OS_VRAM_SIZE)
+		return Arena_AllocAt(&vramArena, OS_VRAM_VADDR + (paddr - OS_VRAM_PADDR), size);
+	if (paddr >= OS_FCRAM_PADDR && paddr - OS_FCRAM_PADDR < LINEAR_SIZE)
+		return Arena_AllocAt(&linearArena, LINEAR_VADDR + (paddr - OS_FCRAM_PADDR), size);
+	return NULL;
+}
+
+u64 svcGetSystemTick(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec*SYSCLOCK_ARM11 + (u64)ts.tv_nsec*SYSCLOCK_ARM11/1000000000ULL;
+}
+
+void svcSleepThread(s64 ns)
+{
+	struct timespec ts = { ns / 1000000000, ns % 1000000000 };
+	if (ns > 0)
+		nanosleep(&ts, NULL);
+}
+
+void svcBreak(UserBreakType breakReason)
+{
+	fprintf(stderr, "svcBreak(%d)\n", (int)breakReason);
+	abort();
+}
+
+Thread threadGetCurrent(void)
+{
+	static __thread char self;
+	return (Thread)&self;
+}
+
+void osTickCounterStart(TickCounter* cnt)
+{
+	cnt->reference = svcGetSystemTick();
+}
+
+void osTickCounterUpdate(TickCounter* cnt)
+{
+	u64 now = svcGetSystemTick();
+	cnt->elapsed = now - cnt->reference;
+	cnt->reference = now;
+}
+
+double osTickCounterRead(const TickCounter* cnt)
+{
+	return cnt->elapsed / CPU_TICKS_PER_MSEC;
+}
+
+void aptHook(aptHookCookie* cookie, aptHookFn callback, void* param)
+{
+	cookie->next = NULL;
+	cookie->callback = callback;
+	cookie->param = param;
+}
+
+void aptUnhook(aptHookCookie* cookie)
+{
+}
+
+u8* gfxGetFramebuffer(gfxScreen_t screen, gfx3dSide_t side, u16* width, u16* height)
+{
+	int id = screen == GFX_BOTTOM ? 2 : side;
+	if (width)  *width  = 240;
+	if (height) *height = screen == GFX_BOTTOM ? 320 : 400;
+	if (!framebuffers[id])
+		framebuffers[id] = (u8*)linearAlloc(240*400*4);
+	return framebuffers[id];
+}
+
+bool gfxIs3D(void)
+{
+	return false;
+}
+
+void gfxConfigScreen(gfxScreen_t scr, bool immediate)
+{
+}
+
+static void fireEvent(GSPGPU_Event id)
+{
+	EventCb cb = events[id];
+	if (cb.oneShot)
+		memset(&events[id], 0, sizeof(EventCb));
+	if (cb.func)
+		cb.func(cb.data);
+}
+
+void gspSetEventCallback(GSPGPU_Event id, ThreadFunc cb, void* data, bool oneShot)
+{
+	events[id].func = cb;
+	events[id].data = data;
+	events[id].oneShot = oneShot;
+}
+
+Result GSPGPU_FlushDataCache(const void* adr, u32 size)
+{
+	return 0;
+}
+
+Result GSPGPU_InvalidateDataCache(const void* adr, u32 size)
+{
+	return 0;
+}
+
+void GPUCMD_SetBuffer(u32* adr, u32 size, u32 offset)
+{
+	gpuCmdBuf = adr;
+	gpuCmdBufSize = size;
+	gpuCmdBufOffset = offset;
+}
+
+void GPUCMD_Add(u32 header, const u32* param, u32 paramlength)
+{
+	u32 zero = 0;
+	if (!param || !paramlength)
+	{
+		paramlength = 1;
+		param = &zero;
+	}
+	if (!gpuCmdBuf || gpuCmdBufOffset+paramlength+1 > gpuCmdBufSize)
+		svcBreak(USERBREAK_PANIC);
+
+	paramlength --;
+	gpuCmdBuf[gpuCmdBufOffset] = param[0];
+	gpuCmdBuf[gpuCmdBufOffset+1] = header | ((paramlength & 0x7FF) << 20);
+	if (paramlength)
+		memcpy(&gpuCmdBuf[gpuCmdBufOffset+2], &param[1], paramlength*4);
+	gpuCmdBufOffset += paramlength+2;
+	if (paramlength & 1)
+		gpuCmdBuf[gpuCmdBufOffset++] = 0;
+}
+
+void GPUCMD_Split(u32** addr, u32* size)
+{
+	GPUCMD_AddWrite(GPUREG_FINALIZE, 0x12345678);
+	if ((gpuCmdBufOffset & 3) == 2) // Keep lists 16-byte aligned
+		GPUCMD_AddWrite(GPUREG_FINALIZE, 0x12345678);
+	if (addr) *addr = gpuCmdBuf;
+	if (size) *size = gpuCmdBufOffset;
+	gpuCmdBuf += gpuCmdBufOffset;
+	gpuCmdBufSize -= gpuCmdBufOffset;
+	gpuCmdBufOffset = 0;
+}
+
+Result shaderProgramConfigure(shaderProgram_s* sp, bool sendVshCode, bool sendGshCode)
+{
+	static const u32 outmaps[7] = { 0x03020100, 0x0B0A0908, 0x1F1F1F1F, 0x1F1F1F1F, 0x1F1F1F1F, 0x1F1F1F1F, 0x1F1F1F1F };
+	DVLE_s* dvle;
+	DVLP_s* dvlp;
+	u32 i;
+	if (!sp || !sp->vertexShader)
+		return -1;
+	dvle = sp->vertexShader->dvle;
+	dvlp = dvle->dvlp;
+
+	// Same command shape as libctru, with a fixed position + color output map
+	GPUCMD_AddMaskedWrite(GPUREG_GEOSTAGE_CONFIG, 0xB, 0);
+	GPUCMD_AddMaskedWrite(GPUREG_VSH_COM_MODE, 0x1, 0);
+	if (sendVshCode)
+	{
+		GPUCMD_AddWrite(GPUREG_VSH_CODETRANSFER_CONFIG, 0);
+		for (i = 0; i < dvlp->codeSize; i += 128)
+			GPUCMD_AddWrites(GPUREG_VSH_CODETRANSFER_DATA, &dvlp->codeData[i], dvlp->codeSize-i < 128 ? dvlp->codeSize-i : 128);
+		GPUCMD_AddWrite(GPUREG_VSH_CODETRANSFER_END, 1);
+		GPUCMD_AddWrite(GPUREG_VSH_OPDESCS_CONFIG, 0);
+		for (i = 0; i < dvlp->opdescSize; i += 128)
+			GPUCMD_AddWrites(GPUREG_VSH_OPDESCS_DATA, &dvlp->opcdescData[i], dvlp->opdescSize-i < 128 ? dvlp->opdescSize-i : 128);
+	}
+	GPUCMD_AddWrite(GPUREG_VSH_ENTRYPOINT, 0x7FFF0000 | (dvle->mainOffset & 0xFFFF));
+	GPUCMD_AddWrite(GPUREG_VSH_OUTMAP_MASK, 0x3);
+	GPUCMD_AddWrite(GPUREG_SH_OUTMAP_TOTAL, 2);
+	GPUCMD_AddIncrementalWrites(GPUREG_SH_OUTMAP_O0, outmaps, 7);
+	GPUCMD_AddWrite(GPUREG_SH_OUTATTR_MODE, 0);
+	GPUCMD_AddWrite(GPUREG_SH_OUTATTR_CLOCK, 0x3);
+	return 0;
+}
+
+static void memoryFill(u32* start, u32 value, u32* end, u16 control)
+{
+	u8* p = (u8*)start;
+	u8* e = (u8*)end;
+	u32 width = (control >> 8) & 3; // 0: 16-bit, 1: 24-bit, 2: 32-bit
+	if (!start || !(control & 1))
+		return;
+	if (width == 1)
+	{
+		for (; p + 3 <= e; p += 3)
+		{
+			p[0] = value;
+			p[1] = value >> 8;
+			p[2] = value >> 16;
+		}
+	} else
+	{
+		u32 size = width ? 4 : 2;
+		for (; p + size <= e; p += size)
+			memcpy(p, &value, size);
+	}
+}
+
+static void textureCopy(const u8* in, u32 indim, u8* out, u32 outdim, u32 size)
+{
+	// Dimensions are in 16-byte units: line width in the low half, gap in the high half
+	u32 inWidth = (indim & 0xFFFF) * 16, inGap = (indim >> 16) * 16;
+	u32 outWidth = (outdim & 0xFFFF) * 16, outGap = (outdim >> 16) * 16;
+	u32 inLeft = inWidth ? inWidth : size, outLeft = outWidth ? outWidth : size;
+	while (size)
+	{
+		u32 n = size;
+		if (n > inLeft)  n = inLeft;
+		if (n > outLeft) n = outLeft;
+		memcpy(out, in, n);
+		in += n; out += n; size -= n;
+		inLeft -= n; outLeft -= n;
+		if (!inLeft)
+		{
+			in += inGap;
+			inLeft = inWidth;
+		}
+		if (!outLeft)
+		{
+			out += outGap;
+			outLeft = outWidth;
+		}
+	}
+}
+
+static void runCommand(const gxCmdEntry_s* e)
+{
+	const u32* d = e->data;
+	switch (d[0])
+	{
+		case GXCMD_LIST:
+			counters.lists ++;
+			counters.words += d[2] / 4;
+			fireEvent(GSPGPU_EVENT_P3D);
+			break;
+		case GXCMD_FILL:
+			counters.transfers ++;
+			memoryFill((u32*)(uintptr_t)d[1], d[2], (u32*)(uintptr_t)d[3], d[7] & 0xFFFF);
+			memoryFill((u32*)(uintptr_t)d[4], d[5], (u32*)(uintptr_t)d[6], d[7] >> 16);
+			fireEvent(GSPGPU_EVENT_PSC0);
+			break;
+		case GXCMD_TRANSFER:
+			// Only counted; nothing on the host reads the screen
+			counters.transfers ++;
+			fireEvent(GSPGPU_EVENT_PPF);
+			break;
+		case GXCMD_COPY:
+			counters.transfers ++;
+			textureCopy((const u8*)(uintptr_t)d[1], d[2], (u8*)(uintptr_t)d[3], d[4], d[5]);
+			fireEvent(GSPGPU_EVENT_PPF);
+			break;
+	}
+}
+
+// The "GPU" only makes progress when the library waits on it, which keeps callbacks in the
+// same order as on the console: nothing queued completes before its submitter returns
+static void runQueue(void)
+{
+	gxCmdQueue_s* q = boundQueue;
+	if (!q || queueBusy)
+		return;
+	queueBusy = true;
+	while (queueRunning && q->curEntry < q->numEntries)
+	{
+		runCommand(&q->entries[q->curEntry++]);
+		if (q->curEntry == q->numEntries && q->callback)
+			q->callback(q);
+	}
+	queueBusy = false;
+}
+
+static Result submit(const gxCmdEntry_s* e)
+{
+	gxCmdQueue_s* q = boundQueue;
+	if (!q)
+	{
+		runCommand(e);
+		return 0;
+	}
+	if (q->numEntries >= q->maxEntries)
+		return -1;
+	q->entries[q->numEntries++] = *e;
+	return 0;
+}
+
+void GX_BindQueue(gxCmdQueue_s* queue)
+{
+	boundQueue = queue;
+}
+
+void gxCmdQueueRun(gxCmdQueue_s* queue)
+{
+	queueRunning = true;
+	runQueue();
+}
+
+void gxCmdQueueStop(gxCmdQueue_s* queue)
+{
+	queueRunning = false;
+}
+
+void gxCmdQueueClear(gxCmdQueue_s* queue)
+{
+	queue->numEntries = 0;
+	queue->curEntry = 0;
+	queue->lastEntry = 0;
+}
+
+bool gxCmdQueueWait(gxCmdQueue_s* queue, s64 timeout)
+{
+	runQueue();
+	return !queueRunning || queue->curEntry >= queue->numEntries;
+}
+
+void gspWaitForEvent(GSPGPU_Event id, bool nextEvent)
+{
+	if (id == GSPGPU_EVENT_VBlank0 || id == GSPGPU_EVENT_VBlank1)
+		fireEvent(id);
+	else
+		runQueue();
+}
+
+GSPGPU_Event gspWaitForAnyEvent(void)
+{
+	gxCmdQueue_s* q = boundQueue;
+	if (q && queueRunning && q->curEntry < q->numEntries)
+	{
+		runQueue();
+		return GSPGPU_EVENT_P3D;
+	}
+	fireEvent(GSPGPU_EVENT_VBlank0);
+	fireEvent(GSPGPU_EVENT_VBlank1);
+	return GSPGPU_EVENT_VBlank0;
+}
+
+Result GX_ProcessCommandList(u32* buf0a, u32 buf0s, u8 flags)
+{
+	gxCmdEntry_s e = { { GXCMD_LIST, (u32)(uintptr_t)buf0a, buf0s, flags } };
+	return submit(&e);
+}
+
+Result GX_MemoryFill(u32* buf0a, u32 buf0v, u32* buf0e, u16 control0, u32* buf1a, u32 buf1v, u32* buf1e, u16 control1)
+{
+	gxCmdEntry_s e = { { GXCMD_FILL, (u32)(uintptr_t)buf0a, buf0v, (u32)(uintptr_t)buf0e,
+		(u32)(uintptr_t)buf1a, buf1v, (u32)(uintptr_t)buf1e, control0 | ((u32)control1 << 16) } };
+	return submit(&e);
+}
+
+Result GX_DisplayTransfer(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 flags)
+{
+	gxCmdEntry_s e = { { GXCMD_TRANSFER, (u32)(uintptr_t)inadr, indim, (u32)(uintptr_t)outadr, outdim, flags } };
+	return submit(&e);
+}
+
+Result GX_TextureCopy(u32* inadr, u32 indim, u32* outadr, u32 outdim, u32 size, u8 flags)
+{
+	gxCmdEntry_s e = { { GXCMD_COPY, (u32)(uintptr_t)inadr, indim, (u32)(uintptr_t)outadr, outdim, size, flags } };
+	return submit(&e);
+}
+
+Result GX_FlushCacheRegions(u32* buf0a, u32 buf0s, u32* buf1a, u32 buf1s, u32* buf2a, u32 buf2s)
+{
+	return 0;
+}
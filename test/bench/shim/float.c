@@ -0,0 +1,45 @@
+// PICA float conversions. Kept apart from <3ds.h> since newer libctru versions define them inline.
+#include <stdint.h>
+#include <string.h>
+
+static uint32_t floatBits(float f)
+{
+	uint32_t v;
+	memcpy(&v, &f, sizeof(v));
+	return v;
+}
+
+// Rebiases a float to a smaller exponent/mantissa, flushing anything out of range to zero
+static uint32_t convert(float f, int expBits, int manBits)
+{
+	uint32_t v = floatBits(f);
+	uint32_t sign = v >> 31;
+	int32_t bias = (1 << (expBits-1)) - 1;
+	int32_t exp = (int32_t)((v >> 23) & 0xFF) - 127 + bias;
+	uint32_t man = (v & 0x7FFFFF) >> (23 - manBits);
+	if (!(v & 0x7FFFFFFF) || exp <= 0)
+		return sign << (expBits + manBits);
+	if (exp >= (1 << expBits))
+		exp = (1 << expBits) - 1;
+	return (sign << (expBits + manBits)) | ((uint32_t)exp << manBits) | man;
+}
+
+uint32_t f32tof24(float f)
+{
+	return convert(f, 7, 16);
+}
+
+uint32_t f32tof31(float f)
+{
+	return convert(f, 7, 23);
+}
+
+uint32_t f32tof20(float f)
+{
+	return convert(f, 7, 12);
+}
+
+uint16_t f32tof16(float f)
+{
+	return (uint16_t)convert(f, 5, 10);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <3ds.h>
+
+// The recording backend stands in for libctru's OS and GX layers on the host. Linear memory and VRAM
+// live at their console addresses so citro3d's pointer arithmetic works unchanged, queued GX commands
+// run whenever the library waits on the GPU, and command lists are recorded instead of executed.
+typedef struct
+{
+	u64 lists;     // Command lists submitted through GX_ProcessCommandList
+	u64 words;     // Words in those lists
+	u64 transfers; // Display transfers, texture copies and memory fills
+	u64 allocs;    // Heap and linear/VRAM allocations
+} Recorder_Counters;
+
+bool Recorder_Init(void);
+void Recorder_Exit(void);
+void Recorder_GetCounters(Recorder_Counters* out);
+// Allocates linear memory or VRAM at a given console physical address, as replaying a capture needs.
+// Returns NULL if the range lies outside both or overlaps an allocation. VRAM addresses are freed with
+// vramFree, the rest with linearFree.
+void* Recorder_AllocAt(u32 paddr, u32 size);
@@ -1,8 +1,11 @@
 #include <cassert>
 #include <cmath>
 #include <cstdio>
+#include <algorithm>
+#include <array>
 #include <cstdlib>
 #include <random>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,6 +14,7 @@
 
 extern "C" {
 #include <c3d/maths.h>
+#include <c3d/mesh.h>
 }
 
 typedef std::default_random_engine            generator_t;
@@ -966,6 +970,259 @@ check_quaternion(generator_t &gen, distribution_t &dist)
   }
 }
 
+static void
+check_mesh_layout()
+{
+  // A needs only bytes and B needs shorts, so packing puts B first whatever the stream order
+  static const float a[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 0.0f, 1.0f }, { 1.0f, 1.0f } };
+  static const float b[4][3] = { { 0.0f, 0.0f, 0.0f }, { 100.0f, 0.0f, 0.0f }, { 0.0f, 100.0f, 0.0f }, { 0.0f, 0.0f, 100.0f } };
+  static const u16 indices[3] = { 0, 1, 2 };
+  const C3D_MeshStream streamA = { &a[0][0], sizeof(a[0]), 2, 0, 0.01f };
+  const C3D_MeshStream streamB = { &b[0][0], sizeof(b[0]), 3, 1, 0.01f };
+
+  for(int order = 0; order < 2; ++order)
+  {
+    C3D_MeshStream streams[2] = { order ? streamB : streamA, order ? streamA : streamB };
+    C3D_MeshLayout layout;
+    bool packed = Mesh_PackLayout(&layout, streams, 2, 4);
+    assert(packed);
+    assert(layout.numAttribs == 2);
+    assert(layout.attribs[0].src->regId == 1);
+    assert(layout.attribs[0].stream == (order ? 0 : 1));
+
+    u8 vertices[4*16];
+    Mesh_PackVertices(vertices, &layout);
+
+    C3D_MeshFileDesc desc = { &layout, vertices, indices, 3, C3D_UNSIGNED_SHORT, 0, -1 };
+    std::vector<u8> file(Mesh_FileSize(&desc));
+    size_t written = Mesh_FileWrite(file.data(), file.size(), &desc);
+    assert(written == file.size());
+
+    // Scale and bias of stream i are uniforms 2*i and 2*i+1
+    const C3D_MeshFileHeader *hdr = reinterpret_cast<const C3D_MeshFileHeader*>(file.data());
+    const float *unif = reinterpret_cast<const float*>(file.data() + hdr->uniformOffset);
+    assert(hdr->numUniforms == 4);
+    for(int i = 0; i < 2; ++i)
+    {
+      const C3D_MeshAttrib *attr = layout.attribs[0].stream == i ? &layout.attribs[0] : &layout.attribs[1];
+      assert(attr->src->data == streams[i].data);
+      for(int j = 0; j < 4; ++j)
+      {
+        assert(unif[i*8 + j] == attr->scale.c[3-j]);
+        assert(unif[i*8 + 4 + j] == attr->bias.c[3-j]);
+      }
+    }
+    assert(unif[(order ? 8 : 0)] == 1.0f/255.0f);
+  }
+}
+
+typedef std::array<u16, 3> triangle_t;
+
+// n*n quads in the z = 0 plane, counter-clockwise seen from +z (or from -z when flipped), with the
+// triangles shuffled so that their order carries no locality
+static void
+make_grid(std::vector<float> &pos, std::vector<u16> &indices, int n, bool flip, float (*height)(float, float))
+{
+  u16 base = pos.size() / 3;
+  for(int y = 0; y <= n; ++y)
+  {
+    for(int x = 0; x <= n; ++x)
+    {
+      pos.push_back(x);
+      pos.push_back(y);
+      pos.push_back(height ? height(x, y) : 0.0f);
+    }
+  }
+
+  std::vector<triangle_t> tris;
+  for(int y = 0; y < n; ++y)
+  {
+    for(int x = 0; x < n; ++x)
+    {
+      u16 a = base + y*(n+1) + x, b = a + 1, c = a + n + 1, d = c + 1;
+      tris.push_back(flip ? triangle_t{{a, d, b}} : triangle_t{{a, b, d}});
+      tris.push_back(flip ? triangle_t{{a, c, d}} : triangle_t{{a, d, c}});
+    }
+  }
+  std::shuffle(tris.begin(), tris.end(), std::default_random_engine(1));
+  for(const triangle_t &t : tris)
+    indices.insert(indices.end(), t.begin(), t.end());
+}
+
+// Triangles rotated to start at their smallest index, which keeps the winding, in sorted order
+static std::vector<triangle_t>
+canonical_triangles(const u16 *indices, size_t numIndices)
+{
+  std::vector<triangle_t> tris;
+  for(size_t i = 0; i + 2 < numIndices; i += 3)
+  {
+    const u16 *t = &indices[i];
+    int r = t[0] <= t[1] && t[0] <= t[2] ? 0 : t[1] <= t[2] ? 1 : 2;
+    tris.push_back(triangle_t{{t[r], t[(r+1)%3], t[(r+2)%3]}});
+  }
+  std::sort(tris.begin(), tris.end());
+  return tris;
+}
+
+static void
+check_mesh_vcache()
+{
+  std::vector<float> pos;
+  std::vector<u16>   indices;
+  make_grid(pos, indices, 16, false, nullptr);
+
+  std::vector<u16> out(indices.size());
+  bool optimized = Mesh_OptimizeCache(out.data(), indices.data(), indices.size(), pos.size()/3, C3D_MESH_VCACHE_SIZE);
+  assert(optimized);
+
+  // Same triangles with the same winding, and no more cache misses (thus no worse ACMR)
+  assert(canonical_triangles(out.data(), out.size()) == canonical_triangles(indices.data(), indices.size()));
+  u32 before = Mesh_CacheMisses(indices.data(), indices.size(), C3D_MESH_VCACHE_SIZE);
+  u32 after  = Mesh_CacheMisses(out.data(), out.size(), C3D_MESH_VCACHE_SIZE);
+  assert(after <= before);
+
+  // A shuffled grid leaves plenty of room, so the optimizer must actually improve it
+  C3D_MeshCacheStats stats;
+  Mesh_AnalyzeCache(&stats, out.data(), out.size(), pos.size()/3, C3D_MESH_VCACHE_SIZE);
+  assert(stats.misses == after);
+  assert(stats.acmr < 1.0f);
+  assert(after < before);
+}
+
+// Triangles of a strip as the GPU assembles them: odd ones have their first two vertices swapped,
+// degenerate ones are dropped
+static std::vector<u16>
+expand_strip(const u16 *strip, size_t count)
+{
+  std::vector<u16> tris;
+  for(size_t k = 0; k + 2 < count; ++k)
+  {
+    u16 a = strip[k], b = strip[k+1], c = strip[k+2];
+    if(a == b || b == c || a == c)
+      continue;
+    if(k & 1)
+      std::swap(a, b);
+    tris.push_back(a);
+    tris.push_back(b);
+    tris.push_back(c);
+  }
+  return tris;
+}
+
+static void
+check_mesh_strip()
+{
+  std::vector<float> pos;
+  std::vector<u16>   indices;
+  make_grid(pos, indices, 12, false, nullptr);
+  std::vector<triangle_t> expected = canonical_triangles(indices.data(), indices.size());
+
+  // One strip stitched with degenerate triangles
+  std::vector<u16> strip(C3D_MESH_STRIP_MAX(indices.size()));
+  u32 numSegs = 0;
+  u32 count = Mesh_Stripify(strip.data(), indices.data(), indices.size(), nullptr, &numSegs);
+  assert(count > 0 && count <= strip.size());
+  assert(numSegs == 1);
+  std::vector<u16> tris = expand_strip(strip.data(), count);
+  assert(canonical_triangles(tris.data(), tris.size()) == expected);
+
+  // Separate strips, each starting with an even triangle
+  std::vector<u32> segEnds(indices.size()/3);
+  count = Mesh_Stripify(strip.data(), indices.data(), indices.size(), segEnds.data(), &numSegs);
+  assert(numSegs > 0 && segEnds[numSegs-1] == count);
+  tris.clear();
+  for(u32 i = 0, start = 0; i < numSegs; start = segEnds[i++])
+  {
+    std::vector<u16> seg = expand_strip(&strip[start], segEnds[i] - start);
+    tris.insert(tris.end(), seg.begin(), seg.end());
+  }
+  assert(tris.size() == indices.size());
+  assert(canonical_triangles(tris.data(), tris.size()) == expected);
+
+  // Whichever form Mesh_StripOrList picks still draws the same triangles
+  bool isStrip;
+  count = Mesh_StripOrList(strip.data(), &isStrip, indices.data(), indices.size(), C3D_MESH_VCACHE_SIZE);
+  tris = isStrip ? expand_strip(strip.data(), count) : std::vector<u16>(strip.begin(), strip.begin() + count);
+  assert(canonical_triangles(tris.data(), tris.size()) == expected);
+}
+
+static float
+tri_normal_z(const std::vector<float> &pos, const u16 *t)
+{
+  const float *a = &pos[t[0]*3], *b = &pos[t[1]*3], *c = &pos[t[2]*3];
+  return (b[0]-a[0])*(c[1]-a[1]) - (b[1]-a[1])*(c[0]-a[0]);
+}
+
+static void
+check_mesh_clusters()
+{
+  // A sheet facing +z at z = 0 and one facing -z at z = -1, seen from either side
+  std::vector<float> pos;
+  std::vector<u16>   indices;
+  make_grid(pos, indices, 8, false, nullptr);
+  u32 front = indices.size();
+  make_grid(pos, indices, 8, true, [](float, float) { return -1.0f; });
+
+  C3D_MeshClusters clusters;
+  bool built = Mesh_BuildClusters(&clusters, indices.data(), indices.size(), pos.data(), 3*sizeof(float), pos.size()/3, 16);
+  assert(built);
+  assert(clusters.count >= 2);
+
+  for(int side = 0; side < 2; ++side)
+  {
+    C3D_FVec eye = FVec3_New(4.0f, 4.0f, side ? -20.0f : 20.0f);
+    std::vector<u32> ranges(clusters.count*2);
+    u32 numRanges = Mesh_CullClusters(ranges.data(), &clusters, nullptr, eye);
+
+    // Exactly the triangles facing the eye are kept
+    u32 kept = 0;
+    for(u32 i = 0; i < numRanges; ++i)
+    {
+      for(u32 j = ranges[i*2]; j < ranges[i*2] + ranges[i*2+1]; j += 3)
+      {
+        float nz = tri_normal_z(pos, &indices[j]);
+        assert(side ? nz < 0.0f : nz > 0.0f);
+        kept += 3;
+      }
+    }
+    assert(kept == (side ? indices.size() - front : front));
+  }
+  Mesh_FreeClusters(&clusters);
+}
+
+static void
+check_mesh_simplify()
+{
+  // A flat grid reaches the target without flipping any triangle or exceeding the bound
+  std::vector<float> pos;
+  std::vector<u16>   indices;
+  make_grid(pos, indices, 16, false, nullptr);
+
+  std::vector<u16> out(indices.size());
+  float error = -1.0f;
+  u32 target = indices.size()/4;
+  u32 count = Mesh_Simplify(out.data(), &error, indices.data(), indices.size(), pos.data(), 3*sizeof(float), pos.size()/3, target, 1.0f);
+  assert(count <= target && count % 3 == 0 && count > 0);
+  assert(error >= 0.0f && error <= 1.0f);
+  for(u32 i = 0; i < count; i += 3)
+    assert(tri_normal_z(pos, &out[i]) > 0.0f);
+
+  // A curved grid costs error to simplify: the target is met within a loose bound, a tight one stops
+  // it early, and the reported error stays within whichever bound was given
+  pos.clear();
+  indices.clear();
+  make_grid(pos, indices, 16, false, [](float x, float y) { return 0.5f*std::sin(x*0.7f)*std::cos(y*0.7f); });
+
+  count = Mesh_Simplify(out.data(), &error, indices.data(), indices.size(), pos.data(), 3*sizeof(float), pos.size()/3, target, 10.0f);
+  assert(count <= target);
+  assert(error > 0.0f && error <= 10.0f);
+
+  float maxError = 0.01f;
+  count = Mesh_Simplify(out.data(), &error, indices.data(), indices.size(), pos.data(), 3*sizeof(float), pos.size()/3, target, maxError);
+  assert(count > target && count < indices.size());
+  assert(error <= maxError);
+}
+
 int main(int argc, char *argv[])
 {
   std::random_device rd;
@@ -974,6 +1231,11 @@ int main(int argc, char *argv[])
 
   check_matrix(gen, dist);
   check_quaternion(gen, dist);
+  check_mesh_layout();
+  check_mesh_vcache();
+  check_mesh_strip();
+  check_mesh_clusters();
+  check_mesh_simplify();
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,204 @@
+// Disassembles a raw PICA200 command buffer dump (little endian u32 words, as found in memory) or the
+// command lists of a frame capture, and
+// reports redundant writes, writes overwritten before use and per-register write counts. The output
+// is stable so that dumps taken before and after a change can be diffed. The estimated GPU cost can be
+// checked against a budget, failing with exit code 2 when it is exceeded.
+#include <c3d/cmdstream.h>
+#include <c3d/capture.h>
+#include <c3d/costmodel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const C3D_CmdStats* sortStats;
+
+static int cmpRegCount(const void* a, const void* b)
+{
+	const C3D_CmdStats* s = sortStats;
+	u16 ra = *(const u16*)a, rb = *(const u16*)b;
+	if (s->regWrites[ra] != s->regWrites[rb])
+		return s->regWrites[ra] < s->regWrites[rb] ? 1 : -1;
+	return (int)ra - (int)rb;
+}
+
+static void printReg(u16 reg, int width)
+{
+	const char* name = C3D_CmdRegName(reg);
+	if (name)
+		printf("%-*s", width, name);
+	else
+		printf("0x%03X%*s", reg, width > 5 ? width-5 : 0, "");
+}
+
+static void usage(const char* argv0)
+{
+	fprintf(stderr, "usage: %s [-s] [-t count] [-c ms] cmdbuf.bin|capture.c3dc\n", argv0);
+	fprintf(stderr, "  -s        only print the summary\n");
+	fprintf(stderr, "  -t count  number of registers listed by write count (default 16, 0 for all)\n");
+	fprintf(stderr, "  -c ms     fail if the estimated GPU time exceeds this budget\n");
+}
+
+int main(int argc, char* argv[])
+{
+	const char* path = NULL;
+	bool summaryOnly = false;
+	int top = 16;
+	float budget = 0.0f;
+	int i;
+
+	for (i = 1; i < argc; i ++)
+	{
+		if (strcmp(argv[i], "-s") == 0)
+			summaryOnly = true;
+		else if (strcmp(argv[i], "-t") == 0 && i+1 < argc)
+			top = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-c") == 0 && i+1 < argc)
+			budget = atof(argv[++i]);
+		else if (argv[i][0] != '-' && !path)
+			path = argv[i];
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (!path)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	u32* words;
+	u32 numWords;
+	C3D_Capture cap;
+	if (C3D_CaptureLoad(&cap, path))
+	{
+		// Each list ends on a command boundary, so they decode as one stream with the state carried over
+		u32 l, rewritten = 0;
+		numWords = 0;
+		for (l = 0; l < cap.numLists; l ++)
+			numWords += cap.lists[l].numWords;
+		words = (u32*)malloc(numWords*4 + 4);
+		if (!words)
+		{
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+		numWords = 0;
+		for (l = 0; l < cap.numLists; l ++)
+		{
+			memcpy(&words[numWords], cap.lists[l].words, cap.lists[l].numWords*4);
+			numWords += cap.lists[l].numWords;
+		}
+		for (l = 0; l < cap.numRanges; l ++)
+			if (cap.ranges[l].flags & C3D_CAPTURERANGE_REWRITTEN)
+				rewritten ++;
+		printf("capture: %u command lists, %u memory ranges (%u rewritten within the frame)\n\n", cap.numLists, cap.numRanges, rewritten);
+		C3D_CaptureFree(&cap);
+	} else
+	{
+		FILE* f = fopen(path, "rb");
+		if (!f)
+		{
+			perror(path);
+			return 1;
+		}
+		fseek(f, 0, SEEK_END);
+		long size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+
+		numWords = size / 4;
+		words = (u32*)malloc(numWords*4 + 4);
+		if (!words || fread(words, 4, numWords, f) != numWords)
+		{
+			fprintf(stderr, "%s: read error\n", path);
+			fclose(f);
+			return 1;
+		}
+		fclose(f);
+	}
+
+	u32 count = C3D_CmdDecode(words, numWords, NULL, 0);
+	C3D_CmdWrite* writes = (C3D_CmdWrite*)malloc(count*sizeof(C3D_CmdWrite) + 1);
+	C3D_CmdStats* stats = (C3D_CmdStats*)malloc(sizeof(C3D_CmdStats));
+	if (!writes || !stats)
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	C3D_CmdDecode(words, numWords, writes, count);
+	C3D_CmdAnalyze(writes, count, stats);
+
+	if (!summaryOnly)
+	{
+		u32 w;
+		for (w = 0; w < count; w ++)
+		{
+			C3D_CmdWrite* cw = &writes[w];
+			printf("%06X  ", cw->offset);
+			printReg(cw->reg, 36);
+			if (cw->mask != 0xF)
+				printf(" [%X]", cw->mask);
+			else
+				printf("    ");
+			printf(" = %08X", cw->value);
+			if (cw->flags & C3D_CMDWRITE_REDUNDANT)
+				printf("  ; redundant");
+			if (cw->flags & C3D_CMDWRITE_OVERWRITTEN)
+				printf("  ; overwritten");
+			printf("\n");
+		}
+		printf("\n");
+	}
+
+	printf("words        %u\n", numWords);
+	printf("writes       %u\n", stats->writes);
+	printf("state writes %u\n", stats->stateWrites);
+	printf("redundant    %u\n", stats->redundant);
+	printf("overwritten  %u\n", stats->overwritten);
+	printf("draws        %u\n", stats->draws);
+
+	u16 regs[C3D_CMD_NUM_REGS];
+	int numRegs = 0;
+	for (i = 0; i < C3D_CMD_NUM_REGS; i ++)
+		if (stats->regWrites[i])
+			regs[numRegs++] = i;
+	sortStats = stats;
+	qsort(regs, numRegs, sizeof(u16), cmpRegCount);
+
+	if (top <= 0 || top > numRegs)
+		top = numRegs;
+	printf("\nwrites per register:\n");
+	for (i = 0; i < top; i ++)
+	{
+		printf("  %8u  ", stats->regWrites[regs[i]]);
+		printReg(regs[i], 0);
+		printf("\n");
+	}
+
+	C3D_CostParams params;
+	C3D_CostEstimate cost;
+	C3D_CostParamsDefault(&params);
+	C3D_CostEstimateStream(writes, count, &params, &cost);
+
+	printf("\nestimated cost:\n");
+	printf("  draws %u, vertices %u, primitives %u, fragments %.0f\n", cost.draws, cost.vertices, cost.primitives, cost.fragments);
+	printf("  vertex   %12.0f\n", cost.vertex);
+	printf("  setup    %12.0f\n", cost.setup);
+	printf("  fill     %12.0f\n", cost.fill);
+	printf("  texture  %12.0f\n", cost.texture);
+	printf("  lighting %12.0f\n", cost.lighting);
+	printf("  total    %12.0f cycles, %.3f ms\n", cost.total, cost.ms);
+
+	int ret = 0;
+	if (budget > 0.0f && cost.ms > budget)
+	{
+		fprintf(stderr, "%s: estimated %.3f ms exceeds the %.3f ms budget\n", path, cost.ms, budget);
+		ret = 2;
+	}
+
+	free(stats);
+	free(writes);
+	free(words);
+	return ret;
+}